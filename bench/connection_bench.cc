@@ -0,0 +1,123 @@
+// Connection throughput benchmark.
+//
+// Opens many short-lived connections against a running Webserver from a set
+// of client threads and reports connections per second along with latency
+// percentiles (connect through to the end of the response).
+//
+// Usage:
+//   ./connection_bench <port> [uri] [connections] [concurrency]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Sends one request on a fresh connection and reads until the server closes it.
+// Returns false if the connection failed.
+bool do_request(unsigned short port, const std::string& request) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (connect(fd, (sockaddr*) &addr, sizeof(addr)) < 0) {
+        close(fd);
+        return false;
+    }
+
+    if (write(fd, request.data(), request.size()) != (ssize_t) request.size()) {
+        close(fd);
+        return false;
+    }
+
+    char buf[16384];
+    size_t total = 0;
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        total += n;
+    }
+
+    close(fd);
+    return total > 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: ./connection_bench <port> [uri] [connections] [concurrency]\n";
+        return 1;
+    }
+
+    unsigned short port = std::atoi(argv[1]);
+    std::string uri = argc > 2 ? argv[2] : "/echo";
+    int connections = argc > 3 ? std::atoi(argv[3]) : 20000;
+    int concurrency = argc > 4 ? std::atoi(argv[4]) : 64;
+
+    std::string request = "GET " + uri + " HTTP/1.0\r\nHost: localhost\r\n\r\n";
+
+    std::atomic<int> next(0);
+    std::atomic<int> failures(0);
+    std::mutex latency_mutex;
+    std::vector<double> latencies;
+    latencies.reserve(connections);
+
+    Clock::time_point start = Clock::now();
+
+    std::vector<std::thread> clients;
+    for (int i = 0; i < concurrency; i++) {
+        clients.emplace_back([&]() {
+            std::vector<double> local;
+            while (next++ < connections) {
+                Clock::time_point begin = Clock::now();
+                if (!do_request(port, request)) {
+                    failures++;
+                    continue;
+                }
+                local.push_back(std::chrono::duration<double, std::micro>(Clock::now() - begin).count());
+            }
+
+            std::lock_guard<std::mutex> lock(latency_mutex);
+            latencies.insert(latencies.end(), local.begin(), local.end());
+        });
+    }
+
+    for (auto& client : clients) {
+        client.join();
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (latencies.empty()) {
+        std::cerr << "Error: No successful connections.\n";
+        return 1;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1, (size_t) (p * latencies.size()))];
+    };
+
+    std::cout << "connections:  " << latencies.size() << " ok, " << failures << " failed\n"
+              << "concurrency:  " << concurrency << "\n"
+              << "conn/sec:     " << latencies.size() / seconds << "\n"
+              << "p50 (us):     " << percentile(0.50) << "\n"
+              << "p99 (us):     " << percentile(0.99) << "\n"
+              << "max (us):     " << latencies.back() << "\n";
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+// Header scanning benchmark.
+//
+// Parses realistic request and response heads of roughly 500, 1000 and 2000
+// bytes with each delimiter_scan kernel the CPU supports, and reports
+// requests per second on one core for RequestParser and Response::Parse.
+// Also reports the raw throughput of each kernel over a 1 KB header value.
+//
+// Usage:
+//   ./header_scan_bench [iterations]
+
+#include "delimiter_scan.h"
+#include "request_handler.h"
+#include "request_parser.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+typedef std::chrono::steady_clock Clock;
+
+const char* kernel_name(delimiter_scan::Kernel kernel) {
+    switch (kernel) {
+        case delimiter_scan::SCALAR:
+            return "scalar";
+        case delimiter_scan::SSE42:
+            return "sse4.2";
+        case delimiter_scan::AVX2:
+            return "avx2";
+    }
+    return "";
+}
+
+// Common browser headers, padded out with analytics cookies until the head
+// reaches target_size.
+std::string make_request(size_t target_size) {
+    std::string head =
+        "GET /static/images/logo.png?v=20170315 HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Connection: keep-alive\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 "
+        "(KHTML, like Gecko) Chrome/57.0.2987.133 Safari/537.36\r\n"
+        "Accept: image/webp,image/*,*/*;q=0.8\r\n"
+        "Referer: http://www.example.com/index.html\r\n"
+        "Accept-Encoding: gzip, deflate, sdch\r\n"
+        "Accept-Language: en-US,en;q=0.8\r\n";
+
+    std::string cookie = "Cookie: private=s3cr3t";
+    for (int i = 0; head.size() + cookie.size() + 4 < target_size; i++) {
+        cookie += "; _ga" + std::to_string(i) + "=GA1.2.1234567890.1490000000";
+    }
+    return head + cookie + "\r\n\r\n";
+}
+
+std::string make_response(size_t target_size) {
+    std::string head =
+        "HTTP/1.1 200 OK\r\n"
+        "Date: Thu, 16 Mar 2017 21:05:21 GMT\r\n"
+        "Server: Apache/2.4.18 (Ubuntu)\r\n"
+        "Last-Modified: Wed, 15 Mar 2017 18:22:05 GMT\r\n"
+        "ETag: \"2d-54ac8c2e7fa33\"\r\n"
+        "Cache-Control: max-age=3600, public\r\n"
+        "Content-Type: text/html; charset=UTF-8\r\n";
+
+    for (int i = 0; head.size() < target_size - 60; i++) {
+        head += "Set-Cookie: session" + std::to_string(i) +
+                "=0123456789abcdef; Path=/; HttpOnly\r\n";
+    }
+    return head + "Content-Length: 5\r\n\r\nhello";
+}
+
+template <typename F>
+double requests_per_second(size_t iterations, F parse_once) {
+    size_t checksum = 0;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        checksum += parse_once();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (checksum == 0) {
+        std::cerr << "Error: Nothing parsed.\n";
+    }
+    return iterations / seconds;
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::atol(argv[1]) : 200000;
+
+    std::string value(1024, 'a');
+    value += "\r\n";
+    for (auto kernel : {delimiter_scan::SCALAR, delimiter_scan::SSE42, delimiter_scan::AVX2}) {
+        if (!delimiter_scan::use_kernel(kernel)) {
+            continue;
+        }
+
+        double rate = requests_per_second(iterations * 10, [&]() {
+            return delimiter_scan::find_control(value.data(), value.data() + value.size()) - value.data();
+        });
+        std::cout << kernel_name(kernel) << ":	find_control " << rate * value.size() / 1e9 << " GB/s\n";
+    }
+
+    for (size_t size : {500, 1000, 2000}) {
+        std::string request = make_request(size);
+        std::string response = make_response(size);
+        std::cout << "request head " << request.size() << " bytes, "
+                  << "response head " << response.size() << " bytes\n";
+
+        for (auto kernel : {delimiter_scan::SCALAR, delimiter_scan::SSE42, delimiter_scan::AVX2}) {
+            if (!delimiter_scan::use_kernel(kernel)) {
+                continue;
+            }
+
+            RequestParser parser;
+            double request_rate = requests_per_second(iterations, [&]() {
+                parser.reset();
+                parser.parse(request.data(), request.size());
+                return parser.headers().size();
+            });
+
+            double response_rate = requests_per_second(iterations / 4, [&]() {
+                return Response::Parse(response)->body_length();
+            });
+
+            std::cout << "  " << kernel_name(kernel) << ":\tRequestParser " << request_rate
+                      << " req/s,\tResponse::Parse " << response_rate << " resp/s\n";
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+// Markdown rendering benchmark.
+//
+// Builds documents of 1 MB and 4 MB by repeating the markdown corpus in
+// test/markdown, renders each with cpp-markdown, and reports milliseconds
+// per render and megabytes of markdown per second on one core, and the heap
+// allocations each render makes. The block heavy document repeats only the
+// header, list, quote, rule and reference files, so the per-line block
+// recognizers dominate. Each document is written both to an ostringstream
+// and, as MarkdownCache does, appended straight into a presized string.
+// Last, the 1 MB corpus is HTML-encoded as text with each encoding kernel.
+//
+// Usage (from the repository root):
+//   ./markdown_bench [iterations]
+
+#include "markdown.h"
+#include "markdown-tokens.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Every heap allocation in the process, counted by the replacements below.
+size_t num_allocations = 0;
+size_t allocated_bytes = 0;
+
+void* operator new(size_t size) {
+    num_allocations++;
+    allocated_bytes += size;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+const std::string CORPUS_DIR = "test/markdown/";
+
+std::string read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+// Repeats the named corpus files until the document holds size bytes.
+std::string build_document(const std::vector<std::string>& names, size_t size) {
+    std::string sample;
+    for (auto& name : names) {
+        sample += read_file(CORPUS_DIR + name + ".md") + "\n";
+    }
+    std::string document;
+    if (sample.size() <= names.size()) {
+        return document;
+    }
+    while (document.size() < size) {
+        document += sample;
+    }
+    return document;
+}
+
+std::string render_to_stream(const std::string& markdown) {
+    markdown::Document doc;
+    doc.read(markdown);
+    std::ostringstream html;
+    doc.write(html);
+    return html.str();
+}
+
+std::string render_to_string(const std::string& markdown) {
+    markdown::Document doc;
+    doc.read(markdown);
+    std::string html;
+    doc.write(html);
+    return html;
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::atol(argv[1]) : 3;
+    std::vector<std::string> all = {"blockquotes", "blocks", "design_document", "headers",
+                                    "lists", "references", "rules", "syntax"};
+    std::vector<std::string> blocks = {"blockquotes", "headers", "lists", "references", "rules"};
+
+    struct Document {
+        const char* name;
+        std::string markdown;
+    } documents[] = {
+        {"corpus 1 MB", build_document(all, 1 << 20)},
+        {"corpus 4 MB", build_document(all, 4 << 20)},
+        {"blocks 1 MB", build_document(blocks, 1 << 20)},
+    };
+
+    struct Writer {
+        const char* name;
+        std::string (*render)(const std::string&);
+    } writers[] = {
+        {"ostream", render_to_stream},
+        {"string", render_to_string},
+    };
+
+    for (auto& document : documents) {
+        if (document.markdown.empty()) {
+            std::cerr << "Error: Can't read " << CORPUS_DIR << "; run from the repository root.\n";
+            return 1;
+        }
+
+        for (auto& writer : writers) {
+            size_t html_size = 0;
+            size_t allocations_before = num_allocations, bytes_before = allocated_bytes;
+            Clock::time_point start = Clock::now();
+            for (size_t i = 0; i < iterations; i++) {
+                html_size += writer.render(document.markdown).size();
+            }
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+            std::cout << document.name << ", " << writer.name << ":\t" << seconds * 1000 / iterations << " ms/render,\t"
+                      << document.markdown.size() * iterations / seconds / (1 << 20) << " MB/s,\t"
+                      << (num_allocations - allocations_before) / iterations << " allocations ("
+                      << (allocated_bytes - bytes_before) / iterations / (1 << 20) << " MB)/render,\t"
+                      << html_size / iterations << " bytes of HTML\n";
+        }
+    }
+
+    using namespace markdown::token;
+    const std::string& text = documents[0].markdown;
+    struct Kernel {
+        const char* name;
+        EncodingKernel kernel;
+    } kernels[] = {
+        {"scalar", cScalarKernel},
+        {"SSE2", cSse2Kernel},
+        {"AVX2", cAvx2Kernel},
+    };
+    for (auto& kernel : kernels) {
+        if (!useEncodingKernel(kernel.kernel)) {
+            continue;
+        }
+        size_t encoded_size = 0;
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < iterations * 10; i++) {
+            encoded_size += encodeString(text, cAmps | cAngles | cQuotes).size();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::cout << "encode 1 MB, " << kernel.name << ":\t" << seconds * 1000 / (iterations * 10) << " ms,\t"
+                  << text.size() * iterations * 10 / seconds / (1 << 20) << " MB/s,\t"
+                  << encoded_size / (iterations * 10) << " bytes\n";
+    }
+    useEncodingKernel(bestEncodingKernel());
+
+    return 0;
+}
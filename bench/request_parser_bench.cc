@@ -0,0 +1,152 @@
+// Request parsing benchmark.
+//
+// Parses a typical browser request over and over and reports requests per
+// second on one core for:
+//   legacy         the old istringstream/boost::split parser
+//   RequestParser  the state machine alone (offsets only, no copies)
+//   Request::Parse the state machine plus building a Request
+//
+// Usage:
+//   ./request_parser_bench [iterations]
+
+#include "request_handler.h"
+#include "request_parser.h"
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+namespace legacy {
+
+struct Request {
+    std::string method;
+    std::string uri;
+    std::string version;
+    std::string cookie;
+    std::string body;
+    std::string raw_request;
+    std::vector<std::pair<std::string, std::string>> headers;
+};
+
+// The parser Request::Parse used before RequestParser, minus its logging.
+std::unique_ptr<Request> Parse(const std::string& raw_request) {
+    std::unique_ptr<Request> request(new Request());
+    request->raw_request = raw_request;
+
+    std::istringstream request_stream(raw_request);
+    std::string request_line;
+
+    if (std::getline(request_stream, request_line)) {
+        std::vector<std::string> tokens;
+        boost::algorithm::split(tokens, request_line, boost::algorithm::is_any_of(" "));
+
+        if (!tokens.empty() && tokens.size() == 3) {
+            request->method = tokens[0];
+            request->uri = tokens[1];
+            request->version = tokens[2].substr(0, tokens[2].length()-1);
+        }
+        else {
+            return nullptr;
+        }
+    }
+
+    while (std::getline(request_stream, request_line)) {
+        std::string header_field;
+        std::string header_value;
+
+        if (!request_line.empty() && request_line.at(0) != '\r') {
+            std::size_t field_index = request_line.find_first_of(":");
+
+            if (field_index != std::string::npos) {
+                header_field = request_line.substr(0, field_index);
+                header_value = request_line.substr(field_index+2, std::string::npos);
+                header_value = header_value.substr(0, header_value.length()-1);
+            }
+
+            if (header_field == "Cookie") {
+                std::string cookie_name = "private=";
+                std::size_t first = header_value.find(cookie_name);
+
+                if (first != std::string::npos) {
+                    first = first + cookie_name.length();
+                    std::size_t second = header_value.find(";", first);
+
+                    if (second != std::string::npos) {
+                        request->cookie = header_value.substr(first, second - first);
+                    } else {
+                        request->cookie = header_value.substr(first);
+                    }
+                }
+            }
+
+            request->headers.push_back(std::make_pair(header_field, header_value));
+        }
+        else {
+            while (std::getline(request_stream, request_line)) {
+                request->body += request_line;
+            }
+        }
+    }
+
+    return request;
+}
+
+}  // namespace legacy
+
+const std::string kRequest =
+    "GET /static/images/logo.png?v=20170315 HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 "
+    "(KHTML, like Gecko) Chrome/57.0.2987.133 Safari/537.36\r\n"
+    "Accept: image/webp,image/*,*/*;q=0.8\r\n"
+    "Referer: http://www.example.com/index.html\r\n"
+    "Accept-Encoding: gzip, deflate, sdch\r\n"
+    "Accept-Language: en-US,en;q=0.8\r\n"
+    "Cookie: _ga=GA1.2.1234567890.1490000000; private=s3cr3t; theme=dark\r\n"
+    "\r\n";
+
+template <typename F>
+void run(const char* name, size_t iterations, F parse_once) {
+    size_t checksum = 0;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        checksum += parse_once();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << name << iterations / seconds << " req/s"
+              << " (" << seconds * 1e9 / iterations << " ns/req, checksum " << checksum << ")\n";
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::atol(argv[1]) : 500000;
+
+    std::cout << "request size:   " << kRequest.size() << " bytes\n";
+
+    run("legacy:         ", iterations, [&]() {
+        return legacy::Parse(kRequest)->headers.size();
+    });
+
+    RequestParser parser;
+    run("RequestParser:  ", iterations, [&]() {
+        parser.reset();
+        parser.parse(kRequest.data(), kRequest.size());
+        return parser.headers().size();
+    });
+
+    run("Request::Parse: ", iterations, [&]() {
+        parser.reset();
+        parser.parse(kRequest.data(), kRequest.size());
+        return Request::Parse(parser, kRequest.data(), kRequest.size())->headers().size();
+    });
+
+    return 0;
+}
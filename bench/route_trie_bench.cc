@@ -0,0 +1,93 @@
+// Route lookup benchmark.
+//
+// Builds 1,000 and 10,000 routes shaped like /app<i>/v<j>/<name>, then
+// resolves request URIs with the original linear prefix search over the
+// handler map and with RouteTrie, and reports lookups per second on one
+// core.
+//
+// Usage:
+//   ./route_trie_bench [iterations]
+
+#include "route_trie.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Webserver::find_prefix before it used the trie.
+std::string legacy_find_prefix(const std::unordered_map<std::string, RequestHandler*>& handler_map,
+                               std::string uri) {
+    std::string longest = "";
+    size_t last = uri.find_last_of("/");
+    std::string prefix = uri.substr(0, last);
+
+    for (auto it : handler_map) {
+        std::string map = it.first;
+
+        if (prefix.find(map) == 0 && (prefix.find("/", map.length()) == map.length() ||
+            map.length() == prefix.length() || map.length() == 1)) {
+            if (map.length() > longest.length()) {
+                longest = map;
+            }
+        }
+    }
+
+    return longest;
+}
+
+template <typename F>
+double lookups_per_second(size_t iterations, const std::vector<std::string>& uris, F lookup) {
+    size_t checksum = 0;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        checksum += lookup(uris[i % uris.size()]);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (checksum == 0) {
+        std::cerr << "Error: Nothing found.\n";
+    }
+    return iterations / seconds;
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::atol(argv[1]) : 20000;
+    const char* names[] = {"static", "api", "images", "docs", "echo"};
+
+    for (size_t num_routes : {1000, 10000}) {
+        std::unordered_map<std::string, RequestHandler*> handler_map;
+        handler_map["/"] = reinterpret_cast<RequestHandler*>(1);
+        for (size_t i = 0; handler_map.size() < num_routes; i++) {
+            std::string route = "/app" + std::to_string(i / 10) + "/v" + std::to_string(i % 10 / 5) +
+                                "/" + names[i % 5];
+            handler_map[route] = reinterpret_cast<RequestHandler*>(i + 2);
+        }
+
+        std::vector<std::string> uris;
+        for (size_t i = 0; i < 1000; i++) {
+            size_t app = i * 7919 % (num_routes / 10);
+            uris.push_back("/app" + std::to_string(app) + "/v1/" + names[i % 5] + "/css/site.css");
+            uris.push_back("/app" + std::to_string(app) + "/v2/index.html");
+        }
+
+        RouteTrie routes(RouteTrie::Routes(handler_map.begin(), handler_map.end()));
+
+        double legacy_rate = lookups_per_second(iterations, uris, [&](const std::string& uri) {
+            return legacy_find_prefix(handler_map, uri).size();
+        });
+        double trie_rate = lookups_per_second(iterations * 100, uris, [&](const std::string& uri) {
+            boost::string_ref prefix;
+            routes.find_longest_prefix(uri, &prefix);
+            return prefix.size();
+        });
+
+        std::cout << num_routes << " routes:\tlinear " << legacy_rate << " lookups/s,\ttrie "
+                  << trie_rate << " lookups/s\n";
+    }
+
+    return 0;
+}
@@ -13,14 +13,172 @@
 #include <boost/regex.hpp>
 #include <boost/unordered_set.hpp>
 
+// SSE2 is part of x86-64 itself, so only its AVX2 kernel needs a CPU check.
+#if defined(__GNUC__) && defined(__x86_64__)
+#define MARKDOWN_ENCODE_X86 1
+#endif
+
 using std::cerr;
 using std::endl;
 
+namespace markdown {
+namespace token {
+namespace {
+
+// The characters encodeString might replace.
+bool isHtmlSpecial(char c) {
+	return (c=='&' || c=='<' || c=='>' || c=='"');
+}
+
+const char *scalarFindHtmlSpecial(const char *begin, const char *end) {
+	while (begin!=end && !isHtmlSpecial(*begin)) ++begin;
+	return begin;
+}
+
+} // namespace
+} // namespace token
+} // namespace markdown
+
+#ifdef MARKDOWN_ENCODE_X86
+
+#include <immintrin.h>
+
+namespace markdown {
+namespace token {
+namespace {
+
+// '<' and '>' differ only in bit 1, and '"' and '&' only in bit 2, so two
+// comparisons find all four. Kept out of line, so the AVX2 kernel's call
+// doesn't turn it into AVX code.
+__attribute__((noinline))
+const char *sse2FindHtmlSpecial(const char *begin, const char *end) {
+	const __m128i angles=_mm_set1_epi8('>'), ampOrQuote=_mm_set1_epi8('&');
+	const __m128i bit1=_mm_set1_epi8(0x02), bit2=_mm_set1_epi8(0x04);
+
+	for (; end-begin>=16; begin+=16) {
+		__m128i v=_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+		__m128i match=_mm_or_si128(
+			_mm_cmpeq_epi8(_mm_or_si128(v, bit1), angles),
+			_mm_cmpeq_epi8(_mm_or_si128(v, bit2), ampOrQuote));
+		unsigned mask=_mm_movemask_epi8(match);
+		if (mask) return begin+__builtin_ctz(mask);
+	}
+	return scalarFindHtmlSpecial(begin, end);
+}
+
+} // namespace
+} // namespace token
+} // namespace markdown
+
+// Only this kernel is compiled for AVX2; the rest of the library must still
+// run on CPUs without it.
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+namespace markdown {
+namespace token {
+namespace {
+
+const char *avx2FindHtmlSpecial(const char *begin, const char *end) {
+	const __m256i angles=_mm256_set1_epi8('>'), ampOrQuote=_mm256_set1_epi8('&');
+	const __m256i bit1=_mm256_set1_epi8(0x02), bit2=_mm256_set1_epi8(0x04);
+
+	for (; end-begin>=32; begin+=32) {
+		__m256i v=_mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+		__m256i match=_mm256_or_si256(
+			_mm256_cmpeq_epi8(_mm256_or_si256(v, bit1), angles),
+			_mm256_cmpeq_epi8(_mm256_or_si256(v, bit2), ampOrQuote));
+		unsigned mask=_mm256_movemask_epi8(match);
+		if (mask) return begin+__builtin_ctz(mask);
+	}
+	return sse2FindHtmlSpecial(begin, end);
+}
+
+} // namespace
+} // namespace token
+} // namespace markdown
+
+#pragma GCC pop_options
+
+#endif // MARKDOWN_ENCODE_X86
+
 namespace markdown {
 namespace token {
 
 namespace {
 
+typedef const char *(*FindHtmlSpecial)(const char *begin, const char *end);
+
+bool encodingKernelSupported(EncodingKernel kernel) {
+#ifdef MARKDOWN_ENCODE_X86
+	__builtin_cpu_init();
+	switch (kernel) {
+		case cScalarKernel: return true;
+		case cSse2Kernel: return __builtin_cpu_supports("sse2");
+		case cAvx2Kernel: return __builtin_cpu_supports("avx2");
+	}
+	return false;
+#else
+	return (kernel==cScalarKernel);
+#endif
+}
+
+FindHtmlSpecial findHtmlSpecialFor(EncodingKernel kernel) {
+#ifdef MARKDOWN_ENCODE_X86
+	if (kernel==cAvx2Kernel) return avx2FindHtmlSpecial;
+	if (kernel==cSse2Kernel) return sse2FindHtmlSpecial;
+#endif
+	return scalarFindHtmlSpecial;
+}
+
+// Starts out scalar so text encoded during static initialization is safe,
+// then switches to the best kernel before main() runs.
+EncodingKernel activeEncodingKernel=cScalarKernel;
+FindHtmlSpecial findHtmlSpecial=scalarFindHtmlSpecial;
+
+struct EncodingDispatcher {
+	EncodingDispatcher() { useEncodingKernel(bestEncodingKernel()); }
+};
+
+const EncodingDispatcher cEncodingDispatcher;
+
+bool isLineSeparator(char c) {
+	return (c=='\n' || c=='\r' || c=='\f');
+}
+
+bool startsWith(const char *p, const char *end, const char *prefix) {
+	for (; *prefix!=0; ++p, ++prefix) if (p==end || *p!=*prefix) return false;
+	return true;
+}
+
+// Whether "&#" followed by one to three decimal digits, or by 'x' and one or
+// two hex digits, and then ';' starts at p.
+bool isNumericEntity(const char *p, const char *end) {
+	if (end-p<4 || p[0]!='&' || p[1]!='#') return false;
+	p+=2;
+	bool hex=(*p=='x' || *p=='X');
+	if (hex) ++p;
+	const char *digits=p;
+	ptrdiff_t maxDigits=(hex ? 2 : 3);
+	while (p!=end && p-digits<maxDigits && ((*p>='0' && *p<='9') ||
+		(hex && ((*p>='a' && *p<='f') || (*p>='A' && *p<='F'))))) ++p;
+	return (p!=digits && p!=end && *p==';');
+}
+
+// The last '&' in [begin, end) that keeps every '&' before it, under cAmps,
+// as it is: one starting a numeric entity, or "&amp;" at the start of a
+// line. This is where "^(&amp;)|(&#[0-9]{1,3};)|(&#[xX][0-9a-fA-F]{1,2};)",
+// searched for from an earlier '&', would still find a match. Returns 0 if
+// there is none.
+const char *lastKeptAmp(const char *begin, const char *end) {
+	for (const char *p=end; p!=begin; ) {
+		--p;
+		if (*p=='&' && (isNumericEntity(p, end) || (p!=begin &&
+			isLineSeparator(p[-1]) && startsWith(p, end, "&amp;")))) return p;
+	}
+	return 0;
+}
+
 const std::string cEscapedCharacters("\\`*_{}[]()#+-.!>");
 
 optional<size_t> isEscapedCharacter(char c) {
@@ -35,31 +193,6 @@ char escapedCharacter(size_t index) {
 	return cEscapedCharacters[index];
 }
 
-std::string encodeString(const std::string& src, int encodingFlags) {
-	bool amps=(encodingFlags & cAmps)!=0,
-		doubleAmps=(encodingFlags & cDoubleAmps)!=0,
-		angleBrackets=(encodingFlags & cAngles)!=0,
-		quotes=(encodingFlags & cQuotes)!=0;
-
-	std::string tgt;
-	for (std::string::const_iterator i=src.begin(), ie=src.end(); i!=ie; ++i) {
-		if (*i=='&' && amps) {
-			static const boost::regex cIgnore("^(&amp;)|(&#[0-9]{1,3};)|(&#[xX][0-9a-fA-F]{1,2};)");
-			if (boost::regex_search(i, ie, cIgnore)) {
-				tgt.push_back(*i);
-			} else {
-				tgt+="&amp;";
-			}
-		}
-		else if (*i=='&' && doubleAmps) tgt+="&amp;";
-		else if (*i=='<' && angleBrackets) tgt+="&lt;";
-		else if (*i=='>' && angleBrackets) tgt+="&gt;";
-		else if (*i=='\"' && quotes) tgt+="&quot;";
-		else tgt.push_back(*i);
-	}
-	return tgt;
-}
-
 bool looksLikeUrl(const std::string& str) {
 	const char *schemes[]={ "http://", "https://", "ftp://", "ftps://",
 		"file://", "www.", "ftp.", 0 };
@@ -155,8 +288,6 @@ const char *cBlockTagInit[]={ "p/", "blockquote/", "hr", "h1/", "h2/",
 //"!doctype", "bdo", "body", "button", "fieldset", "head", "html",
 //"legend", "noscript", "optgroup", "xmp",
 
-boost::unordered_set<std::string> otherTags, blockTags;
-
 void initTag(boost::unordered_set<std::string> &set, const char *init[]) {
 	for (size_t x=0; init[x]!=0; ++x) {
 		std::string str=init[x];
@@ -168,6 +299,16 @@ void initTag(boost::unordered_set<std::string> &set, const char *init[]) {
 	}
 }
 
+// Built on first use, once, however many threads render at the same time.
+struct Tags {
+	boost::unordered_set<std::string> otherTags, blockTags;
+
+	Tags() {
+		initTag(otherTags, cOtherTagInit);
+		initTag(blockTags, cBlockTagInit);
+	}
+};
+
 std::string cleanTextLinkRef(const std::string& ref) {
 	std::string r;
 	for (std::string::const_iterator i=ref.begin(), ie=ref.end(); i!=ie;
@@ -184,11 +325,67 @@ std::string cleanTextLinkRef(const std::string& ref) {
 
 
 
-size_t isValidTag(const std::string& tag, bool nonBlockFirst) {
-	if (blockTags.empty()) {
-		initTag(otherTags, cOtherTagInit);
-		initTag(blockTags, cBlockTagInit);
+std::string encodeString(const std::string& src, int encodingFlags) {
+	bool amps=(encodingFlags & cAmps)!=0,
+		doubleAmps=(encodingFlags & cDoubleAmps)!=0,
+		angleBrackets=(encodingFlags & cAngles)!=0,
+		quotes=(encodingFlags & cQuotes)!=0;
+
+	std::string tgt;
+	tgt.reserve(src.length());
+	const char *begin=src.data(), *end=begin+src.length(), *prev=begin;
+	const char *keptAmp=0;
+	bool keptAmpFound=false;
+	for (const char *i=findHtmlSpecial(begin, end); i!=end;
+		i=findHtmlSpecial(i+1, end))
+	{
+		const char *entity=0;
+		if (*i=='&' && amps) {
+			if (!startsWith(i, end, "&amp;")) {
+				if (!keptAmpFound) {
+					keptAmp=lastKeptAmp(i, end);
+					keptAmpFound=true;
+				}
+				if (keptAmp==0 || keptAmp<i) entity="&amp;";
+			}
+		}
+		else if (*i=='&' && doubleAmps) entity="&amp;";
+		else if (*i=='<' && angleBrackets) entity="&lt;";
+		else if (*i=='>' && angleBrackets) entity="&gt;";
+		else if (*i=='\"' && quotes) entity="&quot;";
+
+		// Characters left as they are stay in the run copied next.
+		if (entity) {
+			tgt.append(prev, i);
+			tgt+=entity;
+			prev=i+1;
+		}
 	}
+	tgt.append(prev, end);
+	return tgt;
+}
+
+EncodingKernel bestEncodingKernel() {
+	if (encodingKernelSupported(cAvx2Kernel)) return cAvx2Kernel;
+	if (encodingKernelSupported(cSse2Kernel)) return cSse2Kernel;
+	return cScalarKernel;
+}
+
+EncodingKernel encodingKernel() {
+	return activeEncodingKernel;
+}
+
+bool useEncodingKernel(EncodingKernel kernel) {
+	if (!encodingKernelSupported(kernel)) return false;
+	activeEncodingKernel=kernel;
+	findHtmlSpecial=findHtmlSpecialFor(kernel);
+	return true;
+}
+
+size_t isValidTag(const std::string& tag, bool nonBlockFirst) {
+	static const Tags cTags;
+	const boost::unordered_set<std::string>& otherTags=cTags.otherTags;
+	const boost::unordered_set<std::string>& blockTags=cTags.blockTags;
 
 	if (nonBlockFirst) {
 		if (otherTags.find(tag)!=otherTags.end()) return 1;
@@ -212,19 +409,22 @@ void TextHolder::writeAsHtml(std::ostream& out) const {
 	postWrite(out);
 }
 
-optional<TokenGroup> RawText::processSpanElements(const LinkIds& idTable) {
-	if (!canContainMarkup()) return none;
+bool RawText::processSpanElements(const LinkIds& idTable, TokenArena& arena,
+	TokenGroup& tokens)
+{
+	if (!canContainMarkup()) return false;
 
 	ReplacementTable replacements;
-	std::string str=_processHtmlTagAttributes(*text(), replacements);
-	str=_processCodeSpans(str, replacements);
+	std::string str=_processHtmlTagAttributes(*text(), replacements, arena);
+	str=_processCodeSpans(str, replacements, arena);
 	str=_processEscapedCharacters(str);
-	str=_processLinksImagesAndTags(str, replacements, idTable);
-	return _processBoldAndItalicSpans(str, replacements);
+	str=_processLinksImagesAndTags(str, replacements, idTable, arena);
+	_processBoldAndItalicSpans(str, replacements, arena, tokens);
+	return true;
 }
 
 std::string RawText::_processHtmlTagAttributes(std::string src, ReplacementTable&
-	replacements)
+	replacements, TokenArena& arena)
 {
 	// Because "Attribute Content Is Not A Code Span"
 	std::string tgt;
@@ -249,7 +449,7 @@ std::string RawText::_processHtmlTagAttributes(std::string src, ReplacementTable
 						tgttag+="\x01@"+boost::lexical_cast<std::string>(replacements.size())+"@htmlTagAttr\x01";
 						prevtag=mtag[0].second;
 
-						replacements.push_back(TokenPtr(new TextHolder(std::string(mtag[0]), false, cAmps|cAngles)));
+						replacements.push_back(arena.make<TextHolder>(std::string(mtag[0]), false, cAmps|cAngles));
 					} else {
 						tgttag+=std::string(prevtag, endtag);
 						break;
@@ -271,7 +471,7 @@ std::string RawText::_processHtmlTagAttributes(std::string src, ReplacementTable
 }
 
 std::string RawText::_processCodeSpans(std::string src, ReplacementTable&
-	replacements)
+	replacements, TokenArena& arena)
 {
 	static const boost::regex cCodeSpan[2]={
 		boost::regex("(?:^|(?<=[^\\\\]))`` (.+?) ``"),
@@ -286,7 +486,7 @@ std::string RawText::_processCodeSpans(std::string src, ReplacementTable&
 				tgt+=std::string(prev, m[0].first);
 				tgt+="\x01@"+boost::lexical_cast<std::string>(replacements.size())+"@codeSpan\x01";
 				prev=m[0].second;
-				replacements.push_back(TokenPtr(new CodeSpan(_restoreProcessedItems(m[1], replacements))));
+				replacements.push_back(arena.make<CodeSpan>(_restoreProcessedItems(m[1], replacements)));
 			} else {
 				tgt+=std::string(prev, end);
 				break;
@@ -324,7 +524,7 @@ std::string RawText::_processEscapedCharacters(const std::string& src) {
 }
 
 std::string RawText::_processSpaceBracketedGroupings(const std::string &src,
-	ReplacementTable& replacements)
+	ReplacementTable& replacements, TokenArena& arena)
 {
 	static const boost::regex cRemove("(?:(?: \\*+ )|(?: _+ ))");
 
@@ -335,7 +535,7 @@ std::string RawText::_processSpaceBracketedGroupings(const std::string &src,
 		if (boost::regex_search(prev, end, m, cRemove)) {
 			tgt+=std::string(prev, m[0].first);
 			tgt+="\x01@"+boost::lexical_cast<std::string>(replacements.size())+"@spaceBracketed\x01";
-			replacements.push_back(TokenPtr(new RawText(m[0])));
+			replacements.push_back(arena.make<RawText>(m[0]));
 			prev=m[0].second;
 		} else {
 			tgt+=std::string(prev, end);
@@ -346,7 +546,7 @@ std::string RawText::_processSpaceBracketedGroupings(const std::string &src,
 }
 
 std::string RawText::_processLinksImagesAndTags(const std::string &src,
-	ReplacementTable& replacements, const LinkIds& idTable)
+	ReplacementTable& replacements, const LinkIds& idTable, TokenArena& arena)
 {
 	// NOTE: Kludge alert! The "inline link or image" regex should be...
 	//
@@ -419,15 +619,15 @@ std::string RawText::_processLinksImagesAndTags(const std::string &src,
 					// Just encode the first character as-is, and continue
 					// searching after it.
 					prev=m[0].first+1;
-					replacements.push_back(TokenPtr(new RawText(std::string(m[0].first, prev))));
+					replacements.push_back(arena.make<RawText>(std::string(m[0].first, prev)));
 				} else if (isImage) {
-					replacements.push_back(TokenPtr(new Image(contentsOrAlttext,
-						url, title)));
+					replacements.push_back(arena.make<Image>(contentsOrAlttext,
+						url, title));
 				} else {
-					replacements.push_back(TokenPtr(new HtmlAnchorTag(url, title)));
+					replacements.push_back(arena.make<HtmlAnchorTag>(url, title));
 					tgt+=contentsOrAlttext;
 					tgt+="\x01@"+boost::lexical_cast<std::string>(replacements.size())+"@links&Images2\x01";
-					replacements.push_back(TokenPtr(new HtmlTag("/a")));
+					replacements.push_back(arena.make<HtmlTag>("/a"));
 				}
 			} else {
 				// Otherwise it's an HTML tag or auto-link.
@@ -438,21 +638,21 @@ std::string RawText::_processLinksImagesAndTags(const std::string &src,
 
 				if (looksLikeUrl(contents)) {
 					TokenGroup subgroup;
-					subgroup.push_back(TokenPtr(new HtmlAnchorTag(contents)));
-					subgroup.push_back(TokenPtr(new RawText(contents, false)));
-					subgroup.push_back(TokenPtr(new HtmlTag("/a")));
-					replacements.push_back(TokenPtr(new Container(subgroup)));
+					subgroup.push_back(arena.make<HtmlAnchorTag>(contents));
+					subgroup.push_back(arena.make<RawText>(contents, false));
+					subgroup.push_back(arena.make<HtmlTag>("/a"));
+					replacements.push_back(arena.make<Container>(subgroup));
 				} else if (looksLikeEmailAddress(contents)) {
 					TokenGroup subgroup;
-					subgroup.push_back(TokenPtr(new HtmlAnchorTag(emailEncode("mailto:"+contents))));
-					subgroup.push_back(TokenPtr(new RawText(emailEncode(contents), false)));
-					subgroup.push_back(TokenPtr(new HtmlTag("/a")));
-					replacements.push_back(TokenPtr(new Container(subgroup)));
+					subgroup.push_back(arena.make<HtmlAnchorTag>(emailEncode("mailto:"+contents)));
+					subgroup.push_back(arena.make<RawText>(emailEncode(contents), false));
+					subgroup.push_back(arena.make<HtmlTag>("/a"));
+					replacements.push_back(arena.make<Container>(subgroup));
 				} else if (isValidTag(m[8])) {
-					replacements.push_back(TokenPtr(new HtmlTag(_restoreProcessedItems(contents, replacements))));
+					replacements.push_back(arena.make<HtmlTag>(_restoreProcessedItems(contents, replacements)));
 				} else {
 					// Just encode it as-is
-					replacements.push_back(TokenPtr(new RawText(m[0])));
+					replacements.push_back(arena.make<RawText>(m[0]));
 				}
 			}
 		} else {
@@ -463,8 +663,8 @@ std::string RawText::_processLinksImagesAndTags(const std::string &src,
 	return tgt;
 }
 
-TokenGroup RawText::_processBoldAndItalicSpans(const std::string& src,
-	ReplacementTable& replacements)
+void RawText::_processBoldAndItalicSpans(const std::string& src,
+	ReplacementTable& replacements, TokenArena& arena, TokenGroup& tokens)
 {
 	static const boost::regex cEmphasisExpression(
 		"(?:(?<![*_])([*_]{1,3})([^*_ ]+?)\\1(?![*_]))"                                    // Mid-word emphasis
@@ -478,57 +678,55 @@ TokenGroup RawText::_processBoldAndItalicSpans(const std::string& src,
 	while (1) {
 		boost::smatch m;
 		if (boost::regex_search(prev, end, m, cEmphasisExpression)) {
-			if (prev!=m[0].first) tgt.push_back(TokenPtr(new
-				RawText(std::string(prev, m[0].first))));
+			if (prev!=m[0].first) tgt.push_back(arena.make<RawText>(
+				std::string(prev, m[0].first)));
 			if (m[3].matched) {
 				std::string token=m[3];
-				tgt.push_back(TokenPtr(new BoldOrItalicMarker(true, token[0],
-					token.length())));
+				tgt.push_back(arena.make<BoldOrItalicMarker>(true, token[0],
+					token.length()));
 				prev=m[0].second;
 			} else if (m[4].matched) {
 				std::string token=m[4];
-				tgt.push_back(TokenPtr(new BoldOrItalicMarker(false, token[0],
-					token.length())));
+				tgt.push_back(arena.make<BoldOrItalicMarker>(false, token[0],
+					token.length()));
 				prev=m[0].second;
 			} else {
 				std::string token=m[1], contents=m[2];
-				tgt.push_back(TokenPtr(new BoldOrItalicMarker(true, token[0],
-					token.length())));
-				tgt.push_back(TokenPtr(new RawText(std::string(contents))));
-				tgt.push_back(TokenPtr(new BoldOrItalicMarker(false, token[0],
-					token.length())));
+				tgt.push_back(arena.make<BoldOrItalicMarker>(true, token[0],
+					token.length()));
+				tgt.push_back(arena.make<RawText>(std::string(contents)));
+				tgt.push_back(arena.make<BoldOrItalicMarker>(false, token[0],
+					token.length()));
 				prev=m[0].second;
 			}
 		} else {
-			if (prev!=end) tgt.push_back(TokenPtr(new RawText(std::string(prev,
-				end))));
+			if (prev!=end) tgt.push_back(arena.make<RawText>(std::string(prev,
+				end)));
 			break;
 		}
 	}
 
 	int id=0;
-	for (TokenGroup::iterator ii=tgt.begin(), iie=tgt.end(); ii!=iie; ++ii) {
-		if ((*ii)->isUnmatchedOpenMarker()) {
-			BoldOrItalicMarker *openToken=dynamic_cast<BoldOrItalicMarker*>(ii->get());
+	for (size_t ii=0; ii<tgt.size(); ++ii) {
+		if (tgt[ii]->isUnmatchedOpenMarker()) {
+			BoldOrItalicMarker *openToken=dynamic_cast<BoldOrItalicMarker*>(tgt[ii]);
 
 			// Find a matching close-marker, if it's there
-			TokenGroup::iterator iii=ii;
-			for (++iii; iii!=iie; ++iii) {
-				if ((*iii)->isUnmatchedCloseMarker()) {
-					BoldOrItalicMarker *closeToken=dynamic_cast<BoldOrItalicMarker*>(iii->get());
+			for (size_t iii=ii+1; iii<tgt.size(); ++iii) {
+				if (tgt[iii]->isUnmatchedCloseMarker()) {
+					BoldOrItalicMarker *closeToken=dynamic_cast<BoldOrItalicMarker*>(tgt[iii]);
 					if (closeToken->size()==3 && openToken->size()!=3) {
 						// Split the close-token into a match for the open-token
 						// and a second for the leftovers.
 						closeToken->disable();
-						TokenGroup g;
-						g.push_back(TokenPtr(new BoldOrItalicMarker(false,
-							closeToken->tokenCharacter(), closeToken->size()-
-							openToken->size())));
-						g.push_back(TokenPtr(new BoldOrItalicMarker(false,
-							closeToken->tokenCharacter(), openToken->size())));
-						TokenGroup::iterator after=iii;
-						++after;
-						tgt.splice(after, g);
+						TokenPtr g[2]={
+							arena.make<BoldOrItalicMarker>(false,
+								closeToken->tokenCharacter(), closeToken->size()-
+								openToken->size()),
+							arena.make<BoldOrItalicMarker>(false,
+								closeToken->tokenCharacter(), openToken->size())
+						};
+						tgt.insert(tgt.begin()+iii+1, g, g+2);
 						continue;
 					}
 
@@ -543,15 +741,14 @@ TokenGroup RawText::_processBoldAndItalicSpans(const std::string& src,
 						// Split the open-token into a match for the close-token
 						// and a second for the leftovers.
 						openToken->disable();
-						TokenGroup g;
-						g.push_back(TokenPtr(new BoldOrItalicMarker(true,
-							openToken->tokenCharacter(), openToken->size()-
-							closeToken->size())));
-						g.push_back(TokenPtr(new BoldOrItalicMarker(true,
-							openToken->tokenCharacter(), closeToken->size())));
-						TokenGroup::iterator after=ii;
-						++after;
-						tgt.splice(after, g);
+						TokenPtr g[2]={
+							arena.make<BoldOrItalicMarker>(true,
+								openToken->tokenCharacter(), openToken->size()-
+								closeToken->size()),
+							arena.make<BoldOrItalicMarker>(true,
+								openToken->tokenCharacter(), closeToken->size())
+						};
+						tgt.insert(tgt.begin()+ii+1, g, g+2);
 						break;
 					}
 				}
@@ -563,10 +760,10 @@ TokenGroup RawText::_processBoldAndItalicSpans(const std::string& src,
 	std::stack<BoldOrItalicMarker*> openMatches;
 	for (TokenGroup::iterator ii=tgt.begin(), iie=tgt.end(); ii!=iie; ++ii) {
 		if ((*ii)->isMatchedOpenMarker()) {
-			BoldOrItalicMarker *open=dynamic_cast<BoldOrItalicMarker*>(ii->get());
+			BoldOrItalicMarker *open=dynamic_cast<BoldOrItalicMarker*>(*ii);
 			openMatches.push(open);
 		} else if ((*ii)->isMatchedCloseMarker()) {
-			BoldOrItalicMarker *close=dynamic_cast<BoldOrItalicMarker*>(ii->get());
+			BoldOrItalicMarker *close=dynamic_cast<BoldOrItalicMarker*>(*ii);
 
 			if (close->id() != openMatches.top()->id()) {
 				close->matchedTo()->matched(0);
@@ -579,35 +776,30 @@ TokenGroup RawText::_processBoldAndItalicSpans(const std::string& src,
 		}
 	}
 
-	TokenGroup r;
 	for (TokenGroup::iterator ii=tgt.begin(), iie=tgt.end(); ii!=iie; ++ii) {
-		if ((*ii)->text() && (*ii)->canContainMarkup()) {
-			TokenGroup t=_encodeProcessedItems(*(*ii)->text(), replacements);
-			r.splice(r.end(), t);
-		} else r.push_back(*ii);
+		if ((*ii)->text() && (*ii)->canContainMarkup())
+			_encodeProcessedItems(*(*ii)->text(), replacements, arena, tokens);
+		else tokens.push_back(*ii);
 	}
-
-	return r;
 }
 
-TokenGroup RawText::_encodeProcessedItems(const std::string &src,
-	ReplacementTable& replacements)
+void RawText::_encodeProcessedItems(const std::string &src,
+	ReplacementTable& replacements, TokenArena& arena, TokenGroup& r)
 {
 	static const boost::regex cReplaced("\x01@(#?[0-9]*)@.+?\x01");
 
-	TokenGroup r;
 	std::string::const_iterator prev=src.begin();
 	while (1) {
 		boost::smatch m;
 		if (boost::regex_search(prev, src.end(), m, cReplaced)) {
 			std::string pre=std::string(prev, m[0].first);
-			if (!pre.empty()) r.push_back(TokenPtr(new RawText(pre)));
+			if (!pre.empty()) r.push_back(arena.make<RawText>(pre));
 			prev=m[0].second;
 
 			std::string ref=m[1];
 			if (ref[0]=='#') {
 				size_t n=boost::lexical_cast<size_t>(ref.substr(1));
-				r.push_back(TokenPtr(new EscapedCharacter(escapedCharacter(n))));
+				r.push_back(arena.make<EscapedCharacter>(escapedCharacter(n)));
 			} else if (!ref.empty()) {
 				size_t n=boost::lexical_cast<size_t>(ref);
 
@@ -616,11 +808,10 @@ TokenGroup RawText::_encodeProcessedItems(const std::string &src,
 			} // Otherwise just eat it
 		} else {
 			std::string pre=std::string(prev, src.end());
-			if (!pre.empty()) r.push_back(TokenPtr(new RawText(pre)));
+			if (!pre.empty()) r.push_back(arena.make<RawText>(pre));
 			break;
 		}
 	}
-	return r;
 }
 
 std::string RawText::_restoreProcessedItems(const std::string &src,
@@ -696,35 +887,40 @@ void Container::writeToken(size_t indent, std::ostream& out) const {
 			(*ii)->writeToken(indent+1, out);
 }
 
-optional<TokenGroup> Container::processSpanElements(const LinkIds& idTable) {
-	TokenGroup t;
+bool Container::processSpanElements(const LinkIds& idTable, TokenArena& arena,
+	TokenGroup&)
+{
+	TokenGroup t, subt;
+	t.reserve(mSubTokens.size());
 	for (CTokenGroupIter ii=mSubTokens.begin(), iie=mSubTokens.end(); ii!=iie;
 		++ii)
 	{
+		subt.clear();
 		if ((*ii)->text()) {
-			optional<TokenGroup> subt=(*ii)->processSpanElements(idTable);
-			if (subt) {
-				if (subt->size()>1) t.push_back(TokenPtr(new Container(*subt)));
-				else if (!subt->empty()) t.push_back(*subt->begin());
+			if ((*ii)->processSpanElements(idTable, arena, subt)) {
+				if (subt.size()>1) {
+					Container *c=arena.make<Container>();
+					c->swapSubtokens(subt);
+					t.push_back(c);
+				} else if (!subt.empty()) t.push_back(subt.front());
 			} else t.push_back(*ii);
 		} else {
-			optional<TokenGroup> subt=(*ii)->processSpanElements(idTable);
-			if (subt) {
-				const Container *c=dynamic_cast<const Container*>((*ii).get());
+			if ((*ii)->processSpanElements(idTable, arena, subt)) {
+				const Container *c=dynamic_cast<const Container*>(*ii);
 				assert(c!=0);
-				t.push_back(c->clone(*subt));
+				t.push_back(c->clone(arena, subt));
 			} else t.push_back(*ii);
 		}
 	}
 	swapSubtokens(t);
-	return none;
+	return false;
 }
 
 UnorderedList::UnorderedList(const TokenGroup& contents, bool paragraphMode) {
 	if (paragraphMode) {
 		// Change each of the text items into paragraphs
 		for (CTokenGroupIter i=contents.begin(), ie=contents.end(); i!=ie; ++i) {
-			token::ListItem *item=dynamic_cast<token::ListItem*>((*i).get());
+			token::ListItem *item=dynamic_cast<token::ListItem*>(*i);
 			assert(item!=0);
 			item->inhibitParagraphs(false);
 			mSubTokens.push_back(*i);
@@ -772,4 +968,27 @@ void Image::writeAsHtml(std::ostream& out) const {
 }
 
 } // namespace token
+
+TokenArena::~TokenArena() {
+	for (std::vector<Token*>::reverse_iterator i=mTokens.rbegin(),
+		ie=mTokens.rend(); i!=ie; ++i) (*i)->~Token();
+	for (std::vector<char*>::const_iterator i=mBlocks.begin(),
+		ie=mBlocks.end(); i!=ie; ++i) ::operator delete(*i);
+}
+
+void *TokenArena::_allocate(size_t size) {
+	// Enough for any token's members.
+	const size_t cAlignment=16;
+	size=(size+cAlignment-1) & ~(cAlignment-1);
+	assert(size<=cBlockSize);
+
+	if (cBlockSize-mUsed<size) {
+		mBlocks.push_back(static_cast<char*>(::operator new(cBlockSize)));
+		mUsed=0;
+	}
+	void *r=mBlocks.back()+mUsed;
+	mUsed+=size;
+	return r;
+}
+
 } // namespace markdown
@@ -10,6 +10,8 @@
 
 #include "markdown.h"
 
+#include <new>
+#include <utility>
 #include <vector>
 
 namespace markdown {
@@ -39,9 +41,38 @@ class LinkIds {
 	Table mTable;
 };
 
+// Allocates the tokens of a Document from large blocks, so building its
+// token tree doesn't allocate once per token and tearing it down doesn't
+// touch reference counts. Tokens live until the arena is destroyed.
+class TokenArena: private boost::noncopyable {
+	public:
+	TokenArena(): mUsed(cBlockSize) { }
+	~TokenArena();
+
+	template <class T, class... Args>
+	T *make(Args&&... args) {
+		T *t=new (_allocate(sizeof(T))) T(std::forward<Args>(args)...);
+		mTokens.push_back(t);
+		return t;
+	}
+
+	// The number of tokens allocated.
+	size_t size() const { return mTokens.size(); }
+
+	private:
+	static const size_t cBlockSize=64*1024;
+
+	void *_allocate(size_t size);
+
+	std::vector<char*> mBlocks;
+	size_t mUsed; // In the last block
+	std::vector<Token*> mTokens;
+};
+
 class Token {
 	public:
 	Token() { }
+	virtual ~Token() { }
 
 	virtual void writeAsHtml(std::ostream&) const=0;
 	virtual void writeAsOriginal(std::ostream& out) const { writeAsHtml(out); }
@@ -51,8 +82,10 @@ class Token {
 		writeToken(out);
 	}
 
-	virtual optional<TokenGroup> processSpanElements(const LinkIds& idTable)
-		{ return none; }
+	// Appends the tokens that replace this one once span-level markup has
+	// been found to tokens, and returns true; or returns false if it stays.
+	virtual bool processSpanElements(const LinkIds& idTable, TokenArena& arena,
+		TokenGroup& tokens) { return false; }
 
 	virtual optional<const std::string&> text() const { return none; }
 
@@ -76,6 +109,25 @@ size_t isValidTag(const std::string& tag, bool nonBlockFirst=false);
 
 enum EncodingFlags { cAmps=0x01, cDoubleAmps=0x02, cAngles=0x04, cQuotes=0x08 };
 
+// Returns src with the characters encodingFlags names replaced by entities.
+// Under cAmps, a '&' stays as it is if "&amp;" follows it directly or at the
+// start of a later line, or a numeric entity ("&#38;", "&#x26;") follows it
+// anywhere in src.
+std::string encodeString(const std::string& src, int encodingFlags);
+
+// encodeString finds the characters it might replace 16 or 32 bytes at a
+// time, with the fastest kernel the CPU supports, picked at startup. Every
+// kernel gives exactly the output of the scalar one.
+enum EncodingKernel { cScalarKernel, cSse2Kernel, cAvx2Kernel };
+
+// The best kernel this CPU supports.
+EncodingKernel bestEncodingKernel();
+// The kernel currently in use.
+EncodingKernel encodingKernel();
+// Switches kernels, for tests and benchmarks. Returns false, without
+// switching, if the CPU doesn't support the kernel.
+bool useEncodingKernel(EncodingKernel kernel);
+
 class TextHolder: public Token {
 	public:
 	TextHolder(const std::string& text, bool canContainMarkup, unsigned int
@@ -103,19 +155,20 @@ class RawText: public TextHolder {
 
 	virtual void writeToken(std::ostream& out) const { out << "RawText: " << *text() << '\n'; }
 
-	virtual optional<TokenGroup> processSpanElements(const LinkIds& idTable);
+	virtual bool processSpanElements(const LinkIds& idTable, TokenArena& arena,
+		TokenGroup& tokens);
 
 	private:
 	typedef std::vector<TokenPtr> ReplacementTable;
 
-	static std::string _processHtmlTagAttributes(std::string src, ReplacementTable& replacements);
-	static std::string _processCodeSpans(std::string src, ReplacementTable& replacements);
+	static std::string _processHtmlTagAttributes(std::string src, ReplacementTable& replacements, TokenArena& arena);
+	static std::string _processCodeSpans(std::string src, ReplacementTable& replacements, TokenArena& arena);
 	static std::string _processEscapedCharacters(const std::string& src);
-	static std::string _processLinksImagesAndTags(const std::string& src, ReplacementTable& replacements, const LinkIds& idTable);
-	static std::string _processSpaceBracketedGroupings(const std::string& src, ReplacementTable& replacements);
-	static TokenGroup _processBoldAndItalicSpans(const std::string& src, ReplacementTable& replacements);
+	static std::string _processLinksImagesAndTags(const std::string& src, ReplacementTable& replacements, const LinkIds& idTable, TokenArena& arena);
+	static std::string _processSpaceBracketedGroupings(const std::string& src, ReplacementTable& replacements, TokenArena& arena);
+	static void _processBoldAndItalicSpans(const std::string& src, ReplacementTable& replacements, TokenArena& arena, TokenGroup& tokens);
 
-	static TokenGroup _encodeProcessedItems(const std::string& src, ReplacementTable& replacements);
+	static void _encodeProcessedItems(const std::string& src, ReplacementTable& replacements, TokenArena& arena, TokenGroup& tokens);
 	static std::string _restoreProcessedItems(const std::string &src, ReplacementTable& replacements);
 };
 
@@ -223,7 +276,10 @@ class Container: public Token {
 		mParagraphMode(false) { }
 
 	const TokenGroup& subTokens() const { return mSubTokens; }
-	void appendSubtokens(TokenGroup& tokens) { mSubTokens.splice(mSubTokens.end(), tokens); }
+	void appendSubtokens(TokenGroup& tokens) {
+		mSubTokens.insert(mSubTokens.end(), tokens.begin(), tokens.end());
+		tokens.clear();
+	}
 	void swapSubtokens(TokenGroup& tokens) { mSubTokens.swap(tokens); }
 
 	virtual bool isContainer() const { return true; }
@@ -233,9 +289,10 @@ class Container: public Token {
 	virtual void writeToken(std::ostream& out) const { out << "Container: error!" << '\n'; }
 	virtual void writeToken(size_t indent, std::ostream& out) const;
 
-	virtual optional<TokenGroup> processSpanElements(const LinkIds& idTable);
+	virtual bool processSpanElements(const LinkIds& idTable, TokenArena& arena,
+		TokenGroup& tokens);
 
-	virtual TokenPtr clone(const TokenGroup& newContents) const { return TokenPtr(new Container(newContents)); }
+	virtual TokenPtr clone(TokenArena& arena, const TokenGroup& newContents) const { return arena.make<Container>(newContents); }
 	virtual std::string containerName() const { return "Container"; }
 
 	protected:
@@ -247,13 +304,10 @@ class InlineHtmlBlock: public Container {
 	public:
 	InlineHtmlBlock(const TokenGroup& contents, bool isBlockTag=false):
 		Container(contents), mIsBlockTag(isBlockTag) { }
-	InlineHtmlBlock(const std::string& contents): mIsBlockTag(false) {
-		mSubTokens.push_back(TokenPtr(new InlineHtmlContents(contents)));
-	}
 
 	virtual bool inhibitParagraphs() const { return !mIsBlockTag; }
 
-	virtual TokenPtr clone(const TokenGroup& newContents) const { return TokenPtr(new InlineHtmlBlock(newContents)); }
+	virtual TokenPtr clone(TokenArena& arena, const TokenGroup& newContents) const { return arena.make<InlineHtmlBlock>(newContents); }
 	virtual std::string containerName() const { return "InlineHtmlBlock"; }
 
 	// Inline HTML blocks always end with a blank line, so report it as one for
@@ -273,7 +327,7 @@ class ListItem: public Container {
 
 	virtual bool inhibitParagraphs() const { return mInhibitParagraphs; }
 
-	virtual TokenPtr clone(const TokenGroup& newContents) const { return TokenPtr(new ListItem(newContents)); }
+	virtual TokenPtr clone(TokenArena& arena, const TokenGroup& newContents) const { return arena.make<ListItem>(newContents); }
 	virtual std::string containerName() const { return "ListItem"; }
 
 	protected:
@@ -288,7 +342,7 @@ class UnorderedList: public Container {
 	public:
 	UnorderedList(const TokenGroup& contents, bool paragraphMode=false);
 
-	virtual TokenPtr clone(const TokenGroup& newContents) const { return TokenPtr(new UnorderedList(newContents)); }
+	virtual TokenPtr clone(TokenArena& arena, const TokenGroup& newContents) const { return arena.make<UnorderedList>(newContents); }
 	virtual std::string containerName() const { return "UnorderedList"; }
 
 	protected:
@@ -301,7 +355,7 @@ class OrderedList: public UnorderedList {
 	OrderedList(const TokenGroup& contents, bool paragraphMode=false):
 		UnorderedList(contents, paragraphMode) { }
 
-	virtual TokenPtr clone(const TokenGroup& newContents) const { return TokenPtr(new OrderedList(newContents)); }
+	virtual TokenPtr clone(TokenArena& arena, const TokenGroup& newContents) const { return arena.make<OrderedList>(newContents); }
 	virtual std::string containerName() const { return "OrderedList"; }
 
 	protected:
@@ -313,7 +367,7 @@ class BlockQuote: public Container {
 	public:
 	BlockQuote(const TokenGroup& contents): Container(contents) { }
 
-	virtual TokenPtr clone(const TokenGroup& newContents) const { return TokenPtr(new BlockQuote(newContents)); }
+	virtual TokenPtr clone(TokenArena& arena, const TokenGroup& newContents) const { return arena.make<BlockQuote>(newContents); }
 	virtual std::string containerName() const { return "BlockQuote"; }
 
 	protected:
@@ -326,7 +380,7 @@ class Paragraph: public Container {
 	Paragraph() { }
 	Paragraph(const TokenGroup& contents): Container(contents) { }
 
-	virtual TokenPtr clone(const TokenGroup& newContents) const { return TokenPtr(new Paragraph(newContents)); }
+	virtual TokenPtr clone(TokenArena& arena, const TokenGroup& newContents) const { return arena.make<Paragraph>(newContents); }
 	virtual std::string containerName() const { return "Paragraph"; }
 
 	protected:
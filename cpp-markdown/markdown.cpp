@@ -9,10 +9,10 @@
 #include "markdown-tokens.h"
 
 #include <sstream>
+#include <algorithm>
 #include <cassert>
 
 #include <boost/regex.hpp>
-#include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
 
 using std::cerr;
@@ -55,18 +55,19 @@ optional<HtmlTagInfo> parseHtmlTag(std::string::const_iterator begin,
 	return none;
 }
 
-markdown::TokenGroup parseInlineHtmlText(const std::string& src) {
-	markdown::TokenGroup r;
+void parseInlineHtmlText(const std::string& src, markdown::TokenArena& arena,
+	markdown::TokenGroup& r)
+{
 	std::string::const_iterator prev=src.begin(), end=src.end();
 	while (1) {
 		boost::smatch m;
 		if (boost::regex_search(prev, end, m, cHtmlTokenExpression)) {
 			if (prev!=m[0].first) {
 				//cerr << "  Non-tag (" << std::distance(prev, m[0].first) << "): " << std::string(prev, m[0].first) << endl;
-				r.push_back(TokenPtr(new markdown::token::InlineHtmlContents(std::string(prev, m[0].first))));
+				r.push_back(arena.make<markdown::token::InlineHtmlContents>(std::string(prev, m[0].first)));
 			}
 			//cerr << "  Tag: " << m[1] << endl;
-			r.push_back(TokenPtr(new markdown::token::HtmlTag(m[1])));
+			r.push_back(arena.make<markdown::token::HtmlTag>(m[1]));
 			prev=m[0].second;
 		} else {
 			std::string eol;
@@ -75,11 +76,29 @@ markdown::TokenGroup parseInlineHtmlText(const std::string& src) {
 				//cerr << "  Non-tag: " << eol << endl;
 			}
 			eol+='\n';
-			r.push_back(TokenPtr(new markdown::token::InlineHtmlContents(eol)));
+			r.push_back(arena.make<markdown::token::InlineHtmlContents>(eol));
 			break;
 		}
 	}
-	return r;
+}
+
+// The block-level recognizers below scan each line by hand instead of
+// running a regular expression over it. Each one accepts exactly the lines
+// the expression quoted in it did, with the same captures, including the
+// ones that depend on the expression backtracking.
+
+size_t countLeading(const std::string& line, size_t pos, char c) {
+	size_t r=pos;
+	while (r<line.length() && line[r]==c) ++r;
+	return r-pos;
+}
+
+bool isDigit(char c) {
+	return (c>='0' && c<='9');
+}
+
+bool isLineSeparator(char c) {
+	return (c=='\n' || c=='\r' || c=='\f');
 }
 
 bool isHtmlCommentStart(std::string::const_iterator begin,
@@ -87,23 +106,130 @@ bool isHtmlCommentStart(std::string::const_iterator begin,
 {
 	// It can't be a single-line comment, those will already have been parsed
 	// by isBlankLine.
-	static const boost::regex cExpression("^<!--");
-	return boost::regex_search(begin, end, cExpression);
+	//
+	// Searching for ^<!-- also finds it after a form feed.
+	static const std::string cStart("<!--");
+	for (std::string::const_iterator i=begin; end-i>=4; ++i)
+		if ((i==begin || isLineSeparator(*(i-1))) && std::equal(cStart.begin(),
+			cStart.end(), i)) return true;
+	return false;
 }
 
 bool isHtmlCommentEnd(std::string::const_iterator begin,
 	std::string::const_iterator end)
 {
-	static const boost::regex cExpression(".*-- *>$");
-	return boost::regex_match(begin, end, cExpression);
+	// .*-- *>$
+	if (begin==end || *(end-1)!='>') return false;
+	--end;
+	while (end!=begin && *(end-1)==' ') --end;
+	return (end-begin>=2 && *(end-1)=='-' && *(end-2)=='-');
 }
 
 bool isBlankLine(const std::string& line) {
-	static const boost::regex cExpression(" {0,3}(<--(.*)-- *> *)* *");
-	return boost::regex_match(line, cExpression);
+	// " {0,3}(<--(.*)-- *> *)* *": nothing but spaces, or "<--" comments
+	// running to a "--" and '>' at the end of the line.
+	size_t start=countLeading(line, 0, ' ');
+	if (start==line.length()) return true;
+	if (start>3 || line.compare(start, 3, "<--")!=0) return false;
+
+	size_t close=line.find_last_not_of(' ');
+	if (line[close]!='>') return false;
+	size_t dashes=line.find_last_not_of(' ', close-1);
+	return (dashes>=start+4 && line[dashes]=='-' && line[dashes-1]=='-');
+}
+
+bool skipQuoteMarker(const std::string& line, size_t& pos) {
+	// " {0,3}>"
+	size_t next=pos;
+	while (next<pos+3 && next<line.length() && line[next]==' ') ++next;
+	if (next==line.length() || line[next]!='>') return false;
+	pos=next+1;
+	return true;
+}
+
+bool matchBlockQuote(const std::string& line, size_t& level, std::string&
+	content)
+{
+	// ^((?: {0,3}>)+) (.*)$ -- the prefix is as many markers as can be
+	// followed by a space.
+	level=0;
+	size_t pos=0, contentStart=0;
+	for (size_t markers=1; skipQuoteMarker(line, pos); ++markers) {
+		if (pos<line.length() && line[pos]==' ') {
+			level=markers;
+			contentStart=pos+1;
+		}
+	}
+	if (level==0) return false;
+	content=line.substr(contentStart);
+	return true;
+}
+
+bool matchQuoteContinuation(const std::string& line, size_t level,
+	std::string& content)
+{
+	// ^((?: {0,3}>){level}) ?(.*)$
+	size_t pos=0;
+	for (size_t n=0; n<level; ++n)
+		if (!skipQuoteMarker(line, pos)) return false;
+	if (pos<line.length() && line[pos]==' ') ++pos;
+	content=line.substr(pos);
+	return true;
+}
+
+bool matchUnorderedItem(const std::string& line, size_t& indent, char&
+	marker, std::string& content)
+{
+	// ^( *)([*+-]) +([^*-].*)$ -- an item that would start with '*' or '-'
+	// (or nothing) takes back one of the spaces, if there are two or more.
+	indent=countLeading(line, 0, ' ');
+	if (indent==line.length()) return false;
+	marker=line[indent];
+	if (marker!='*' && marker!='+' && marker!='-') return false;
+
+	size_t spaces=countLeading(line, indent+1, ' '), start=indent+1+spaces;
+	if (spaces==0) return false;
+	if (start==line.length() || line[start]=='*' || line[start]=='-') {
+		if (spaces<2) return false;
+		--start;
+	}
+	content=line.substr(start);
+	return true;
 }
 
-optional<TokenPtr> parseInlineHtml(CTokenGroupIter& i, CTokenGroupIter end) {
+bool matchOrderedItem(const std::string& line, size_t& indent, std::string&
+	content)
+{
+	// ^( *)([0-9]+)\. +(.*)$
+	indent=countLeading(line, 0, ' ');
+	size_t pos=indent;
+	while (pos<line.length() && isDigit(line[pos])) ++pos;
+	if (pos==indent || pos==line.length() || line[pos]!='.') return false;
+
+	size_t spaces=countLeading(line, pos+1, ' ');
+	if (spaces==0) return false;
+	content=line.substr(pos+1+spaces);
+	return true;
+}
+
+bool isSublistStart(const std::string& line, size_t indent) {
+	// ^ {indent} +(([*+-])|([0-9]+\.)) +.*$
+	size_t pos=countLeading(line, 0, ' ');
+	if (pos<=indent || pos==line.length()) return false;
+	if (line[pos]=='*' || line[pos]=='+' || line[pos]=='-') {
+		++pos;
+	} else {
+		size_t digits=pos;
+		while (digits<line.length() && isDigit(line[digits])) ++digits;
+		if (digits==pos || digits==line.length() || line[digits]!='.') return false;
+		pos=digits+1;
+	}
+	return (pos<line.length() && line[pos]==' ');
+}
+
+optional<TokenPtr> parseInlineHtml(CTokenGroupIter& i, CTokenGroupIter end,
+	markdown::TokenArena& arena)
+{
 	// Preconditions: Previous line was blank, or this is the first line.
 	if ((*i)->text()) {
 		const std::string& line(*(*i)->text());
@@ -128,8 +254,7 @@ optional<TokenPtr> parseInlineHtml(CTokenGroupIter& i, CTokenGroupIter end) {
 				// We encode HTML tags so that their contents gets properly
 				// handled -- i.e. "<div style=">"/>" becomes <div style="&gt;"/>
 				if ((*i)->text()) {
-					markdown::TokenGroup t=parseInlineHtmlText(*(*i)->text());
-					contents.splice(contents.end(), t);
+					parseInlineHtmlText(*(*i)->text(), arena, contents);
 				} else contents.push_back(*i);
 
 				prevLine=i;
@@ -148,7 +273,7 @@ optional<TokenPtr> parseInlineHtml(CTokenGroupIter& i, CTokenGroupIter end) {
 
 			if (lines>1 || markdown::token::isValidTag(tagInfo->tagName, true)>1) {
 				i=prevLine;
-				return TokenPtr(new markdown::token::InlineHtmlBlock(contents));
+				return arena.make<markdown::token::InlineHtmlBlock>(contents);
 			} else {
 				// Single-line HTML "blocks" whose initial tags are span-tags
 				// don't qualify as inline HTML.
@@ -164,7 +289,7 @@ optional<TokenPtr> parseInlineHtml(CTokenGroupIter& i, CTokenGroupIter end) {
 
 			bool done=false;
 			do {
-				if ((*i)->text()) contents.push_back(TokenPtr(new markdown::token::InlineHtmlComment(*(*i)->text()+'\n')));
+				if ((*i)->text()) contents.push_back(arena.make<markdown::token::InlineHtmlComment>(*(*i)->text()+'\n'));
 				else contents.push_back(*i);
 
 				prevLine=i;
@@ -180,7 +305,7 @@ optional<TokenPtr> parseInlineHtml(CTokenGroupIter& i, CTokenGroupIter end) {
 				}
 			} while (i!=end && !done);
 			i=prevLine;
-			return TokenPtr(new markdown::token::InlineHtmlBlock(contents));
+			return arena.make<markdown::token::InlineHtmlBlock>(contents);
 		}
 	}
 
@@ -210,7 +335,9 @@ optional<std::string> isCodeBlockLine(CTokenGroupIter& i, CTokenGroupIter end) {
 	return none;
 }
 
-optional<TokenPtr> parseCodeBlock(CTokenGroupIter& i, CTokenGroupIter end) {
+optional<TokenPtr> parseCodeBlock(CTokenGroupIter& i, CTokenGroupIter end,
+	markdown::TokenArena& arena)
+{
 	if (!(*i)->isBlankLine()) {
 		optional<std::string> contents=isCodeBlockLine(i, end);
 		if (contents) {
@@ -221,7 +348,7 @@ optional<TokenPtr> parseCodeBlock(CTokenGroupIter& i, CTokenGroupIter end) {
 				if (contents) out << *contents << '\n';
 				else break;
 			}
-			return TokenPtr(new markdown::token::CodeBlock(out.str()));
+			return arena.make<markdown::token::CodeBlock>(out.str());
 		}
 	}
 	return none;
@@ -229,27 +356,16 @@ optional<TokenPtr> parseCodeBlock(CTokenGroupIter& i, CTokenGroupIter end) {
 
 
 
-size_t countQuoteLevel(const std::string& prefixString) {
-	size_t r=0;
-	for (std::string::const_iterator qi=prefixString.begin(),
-		qie=prefixString.end(); qi!=qie; ++qi)
-			if (*qi=='>') ++r;
-	return r;
-}
-
-optional<TokenPtr> parseBlockQuote(CTokenGroupIter& i, CTokenGroupIter end) {
-	static const boost::regex cBlockQuoteExpression("^((?: {0,3}>)+) (.*)$");
-	// Useful captures: 1=prefix, 2=content
-
+optional<TokenPtr> parseBlockQuote(CTokenGroupIter& i, CTokenGroupIter end,
+	markdown::TokenArena& arena)
+{
 	if (!(*i)->isBlankLine() && (*i)->text() && (*i)->canContainMarkup()) {
 		const std::string& line(*(*i)->text());
-		boost::smatch m;
-		if (boost::regex_match(line, m, cBlockQuoteExpression)) {
-			size_t quoteLevel=countQuoteLevel(m[1]);
-			boost::regex continuationExpression=boost::regex("^((?: {0,3}>){"+boost::lexical_cast<std::string>(quoteLevel)+"}) ?(.*)$");
-
+		size_t quoteLevel;
+		std::string content;
+		if (matchBlockQuote(line, quoteLevel, content)) {
 			markdown::TokenGroup subTokens;
-			subTokens.push_back(TokenPtr(new markdown::token::RawText(m[2])));
+			subTokens.push_back(arena.make<markdown::token::RawText>(content));
 
 			// The next line can be a continuation of this quote (with or
 			// without the prefix string) or a blank line. Blank lines are
@@ -266,40 +382,48 @@ optional<TokenPtr> parseBlockQuote(CTokenGroupIter& i, CTokenGroupIter end) {
 						break;
 					} else {
 						const std::string& line(*(*ii)->text());
-						if (boost::regex_match(line, m, continuationExpression)) {
-							if (m[1].matched && m[1].length()>0) {
-								i=++ii;
-								subTokens.push_back(TokenPtr(new markdown::token::BlankLine));
-								subTokens.push_back(TokenPtr(new markdown::token::RawText(m[2])));
-							} else break;
+						if (matchQuoteContinuation(line, quoteLevel, content)) {
+							i=++ii;
+							subTokens.push_back(arena.make<markdown::token::BlankLine>());
+							subTokens.push_back(arena.make<markdown::token::RawText>(content));
 						} else break;
 					}
 				} else {
 					const std::string& line(*(*i)->text());
-					if (boost::regex_match(line, m, continuationExpression)) {
-						assert(m[2].matched);
-						if (!isBlankLine(m[2])) subTokens.push_back(TokenPtr(new markdown::token::RawText(m[2])));
-						else subTokens.push_back(TokenPtr(new markdown::token::BlankLine(m[2])));
+					if (matchQuoteContinuation(line, quoteLevel, content)) {
+						if (!isBlankLine(content)) subTokens.push_back(arena.make<markdown::token::RawText>(content));
+						else subTokens.push_back(arena.make<markdown::token::BlankLine>(content));
 						++i;
 					} else break;
 				}
 			}
 
-			return TokenPtr(new markdown::token::BlockQuote(subTokens));
+			return arena.make<markdown::token::BlockQuote>(subTokens);
 		}
 	}
 	return none;
 }
 
-optional<TokenPtr> parseListBlock(CTokenGroupIter& i, CTokenGroupIter end, bool sub=false) {
-	static const boost::regex cUnorderedListExpression("^( *)([*+-]) +([^*-].*)$");
-	static const boost::regex cOrderedListExpression("^( *)([0-9]+)\\. +(.*)$");
+bool matchListItem(const std::string& line, bool ordered, size_t indent, char
+	startChar, std::string& content)
+{
+	// Another item of the same list: ^ {indent}\<startChar> +([^*-].*)$ or
+	// ^ {indent}[0-9]+\. +(.*)$
+	size_t itemIndent;
+	char itemChar;
+	if (ordered) return (matchOrderedItem(line, itemIndent, content) && itemIndent==indent);
+	return (matchUnorderedItem(line, itemIndent, itemChar, content) &&
+		itemIndent==indent && itemChar==startChar);
+}
 
+optional<TokenPtr> parseListBlock(CTokenGroupIter& i, CTokenGroupIter end,
+	markdown::TokenArena& arena, bool sub=false)
+{
 	enum ListType { cNone, cUnordered, cOrdered };
 	ListType type=cNone;
 	if (!(*i)->isBlankLine() && (*i)->text() && (*i)->canContainMarkup()) {
-		boost::regex nextItemExpression, startSublistExpression;
 		size_t indent=0;
+		char startChar=0;
 
 		const std::string& line(*(*i)->text());
 
@@ -307,36 +431,22 @@ optional<TokenPtr> parseListBlock(CTokenGroupIter& i, CTokenGroupIter end, bool
 
 		markdown::TokenGroup subTokens, subItemTokens;
 
-		boost::smatch m;
-		if (boost::regex_match(line, m, cUnorderedListExpression)) {
-			indent=m[1].length();
+		std::string content;
+		if (matchUnorderedItem(line, indent, startChar, content)) {
 			if (sub || indent<4) {
 				type=cUnordered;
-				char startChar=*m[2].first;
-				subItemTokens.push_back(TokenPtr(new markdown::token::RawText(m[3])));
-
-				std::ostringstream next;
-				next << "^" << std::string(indent, ' ') << "\\" << startChar << " +([^*-].*)$";
-				nextItemExpression=next.str();
+				subItemTokens.push_back(arena.make<markdown::token::RawText>(content));
 			}
-		} else if (boost::regex_match(line, m, cOrderedListExpression)) {
-			indent=m[1].length();
+		} else if (matchOrderedItem(line, indent, content)) {
 			if (sub || indent<4) {
 				type=cOrdered;
-				subItemTokens.push_back(TokenPtr(new markdown::token::RawText(m[3])));
-
-				std::ostringstream next;
-				next << "^" << std::string(indent, ' ') << "[0-9]+\\. +(.*)$";
-				nextItemExpression=next.str();
+				subItemTokens.push_back(arena.make<markdown::token::RawText>(content));
 			}
 		}
 
 		if (type!=cNone) {
 			CTokenGroupIter originalI=i;
 			size_t itemCount=1;
-			std::ostringstream sub;
-			sub << "^" << std::string(indent, ' ') << " +(([*+-])|([0-9]+\\.)) +.*$";
-			startSublistExpression=sub.str();
 
 			// There are several options for the next line. It's another item in
 			// this list (in which case this one is done); it's a continuation
@@ -351,12 +461,13 @@ optional<TokenPtr> parseListBlock(CTokenGroupIter& i, CTokenGroupIter end, bool
 			// (more than the list itself), then it's another continuation of
 			// the current item. Otherwise it's either a new paragraph (and this
 			// list is ended) or the beginning of a sub-list.
-			static const boost::regex cContinuedItemExpression("^ *([^ ].*)$");
-
-			boost::regex continuedAfterBlankLineExpression("^ {"+
-				boost::lexical_cast<std::string>(indent+4)+"}([^ ].*)$");
-			boost::regex codeBlockAfterBlankLineExpression("^ {"+
-				boost::lexical_cast<std::string>(indent+8)+"}(.*)$");
+			//
+			// After a blank line, a continuation is indented by exactly
+			// indent+4 spaces (^ {indent+4}([^ ].*)$) and a code block by at
+			// least indent+8 (^ {indent+8}(.*)$).
+			const size_t continuedIndent=indent+4, codeBlockIndent=indent+8;
+			const bool ordered=(type==cOrdered);
+			std::string itemText;
 
 			enum NextItemType { cUnknown, cEndOfList, cAnotherItem };
 			NextItemType nextItem=cUnknown;
@@ -372,51 +483,51 @@ optional<TokenPtr> parseListBlock(CTokenGroupIter& i, CTokenGroupIter end, bool
 						nextItem=cEndOfList;
 					} else if ((*ii)->text()) {
 						const std::string& line(*(*ii)->text());
-						if (boost::regex_match(line, startSublistExpression)) {
+						size_t lineIndent=countLeading(line, 0, ' ');
+						if (isSublistStart(line, indent)) {
 							setParagraphMode=true;
 							++itemCount;
 							i=ii;
-							optional<TokenPtr> p=parseListBlock(i, end, true);
+							optional<TokenPtr> p=parseListBlock(i, end, arena, true);
 							assert(p);
 							subItemTokens.push_back(*p);
 							continue;
-						} else if (boost::regex_match(line, m, nextItemExpression)) {
+						} else if (matchListItem(line, ordered, indent, startChar, itemText)) {
 							setParagraphMode=true;
 							i=ii;
 							nextItem=cAnotherItem;
-						} else if (boost::regex_match(line, m, continuedAfterBlankLineExpression)) {
-							assert(m[1].matched);
-							subItemTokens.push_back(TokenPtr(new markdown::token::BlankLine()));
-							subItemTokens.push_back(TokenPtr(new markdown::token::RawText(m[1])));
+						} else if (lineIndent==continuedIndent && lineIndent<line.length()) {
+							subItemTokens.push_back(arena.make<markdown::token::BlankLine>());
+							subItemTokens.push_back(arena.make<markdown::token::RawText>(line.substr(lineIndent)));
 							i=++ii;
 							continue;
-						} else if (boost::regex_match(line, m, codeBlockAfterBlankLineExpression)) {
+						} else if (lineIndent>=codeBlockIndent) {
 							setParagraphMode=true;
 							++itemCount;
-							assert(m[1].matched);
-							subItemTokens.push_back(TokenPtr(new markdown::token::BlankLine()));
+							subItemTokens.push_back(arena.make<markdown::token::BlankLine>());
 
-							std::string codeBlock=m[1]+'\n';
+							std::string codeBlock=line.substr(codeBlockIndent)+'\n';
 							++ii;
 							while (ii!=end) {
 								if ((*ii)->isBlankLine()) {
 									CTokenGroupIter iii=ii;
 									++iii;
+									if (iii==end) break;
 									const std::string& nextLine(*(*iii)->text());
-									if (boost::regex_match(nextLine, m, codeBlockAfterBlankLineExpression)) {
-										codeBlock+='\n'+m[1]+'\n';
+									if (countLeading(nextLine, 0, ' ')>=codeBlockIndent) {
+										codeBlock+='\n'+nextLine.substr(codeBlockIndent)+'\n';
 										ii=iii;
 									} else break;
 								} else if ((*ii)->text()) {
 									const std::string& line(*(*ii)->text());
-									if (boost::regex_match(line, m, codeBlockAfterBlankLineExpression)) {
-										codeBlock+=m[1]+'\n';
+									if (countLeading(line, 0, ' ')>=codeBlockIndent) {
+										codeBlock+=line.substr(codeBlockIndent)+'\n';
 									} else break;
 								} else break;
 								++ii;
 							}
 
-							subItemTokens.push_back(TokenPtr(new markdown::token::CodeBlock(codeBlock)));
+							subItemTokens.push_back(arena.make<markdown::token::CodeBlock>(codeBlock));
 							i=ii;
 							continue;
 						} else {
@@ -425,24 +536,27 @@ optional<TokenPtr> parseListBlock(CTokenGroupIter& i, CTokenGroupIter end, bool
 					} else break;
 				} else if ((*i)->text()) {
 					const std::string& line(*(*i)->text());
-					if (boost::regex_match(line, startSublistExpression)) {
+					if (isSublistStart(line, indent)) {
 						++itemCount;
-						optional<TokenPtr> p=parseListBlock(i, end, true);
+						optional<TokenPtr> p=parseListBlock(i, end, arena, true);
 						assert(p);
 						subItemTokens.push_back(*p);
 						continue;
-					} else if (boost::regex_match(line, m, nextItemExpression)) {
+					} else if (matchListItem(line, ordered, indent, startChar, itemText)) {
 						nextItem=cAnotherItem;
 					} else {
-						if (boost::regex_match(line, m, cUnorderedListExpression)
-							|| boost::regex_match(line, m, cOrderedListExpression))
+						size_t otherIndent;
+						char otherChar;
+						if (matchUnorderedItem(line, otherIndent, otherChar, content)
+							|| matchOrderedItem(line, otherIndent, content))
 						{
 							// Belongs to the parent list
 							nextItem=cEndOfList;
 						} else {
-							boost::regex_match(line, m, cContinuedItemExpression);
-							assert(m[1].matched);
-							subItemTokens.push_back(TokenPtr(new markdown::token::RawText(m[1])));
+							// ^ *([^ ].*)$
+							size_t start=countLeading(line, 0, ' ');
+							assert(start<line.length());
+							subItemTokens.push_back(arena.make<markdown::token::RawText>(line.substr(start)));
 							++i;
 							continue;
 						}
@@ -450,13 +564,13 @@ optional<TokenPtr> parseListBlock(CTokenGroupIter& i, CTokenGroupIter end, bool
 				} else nextItem=cEndOfList;
 
 				if (!subItemTokens.empty()) {
-					subTokens.push_back(TokenPtr(new markdown::token::ListItem(subItemTokens)));
+					subTokens.push_back(arena.make<markdown::token::ListItem>(subItemTokens));
 					subItemTokens.clear();
 				}
 
 				assert(nextItem!=cUnknown);
 				if (nextItem==cAnotherItem) {
-					subItemTokens.push_back(TokenPtr(new markdown::token::RawText(m[1])));
+					subItemTokens.push_back(arena.make<markdown::token::RawText>(itemText));
 					++itemCount;
 					++i;
 				} else { // nextItem==cEndOfList
@@ -466,15 +580,15 @@ optional<TokenPtr> parseListBlock(CTokenGroupIter& i, CTokenGroupIter end, bool
 
 			// In case we hit the end with an unterminated item...
 			if (!subItemTokens.empty()) {
-				subTokens.push_back(TokenPtr(new markdown::token::ListItem(subItemTokens)));
+				subTokens.push_back(arena.make<markdown::token::ListItem>(subItemTokens));
 				subItemTokens.clear();
 			}
 
 			if (itemCount>1 || indent!=0) {
 				if (type==cUnordered) {
-					return TokenPtr(new markdown::token::UnorderedList(subTokens, setParagraphMode));
+					return arena.make<markdown::token::UnorderedList>(subTokens, setParagraphMode);
 				} else {
-					return TokenPtr(new markdown::token::OrderedList(subTokens, setParagraphMode));
+					return arena.make<markdown::token::OrderedList>(subTokens, setParagraphMode);
 				}
 			} else {
 				// It looked like a list, but turned out to be a false alarm.
@@ -486,30 +600,109 @@ optional<TokenPtr> parseListBlock(CTokenGroupIter& i, CTokenGroupIter end, bool
 	return none;
 }
 
+bool matchReferenceTitle(const std::string& line, size_t pos, std::string&
+	title)
+{
+	// (?: *(?:('|")(.*)\3)|(?:\((.*)\)))$ -- the title runs to the end of
+	// the line.
+	size_t last=line.length()-1, quote=pos+countLeading(line, pos, ' ');
+	if (quote<last && (line[quote]=='"' || line[quote]=='\'') && line[last]==line[quote]) {
+		title=line.substr(quote+1, last-quote-1);
+		return true;
+	} else if (pos<last && line[pos]=='(' && line[last]==')') {
+		title=line.substr(pos+1, last-pos-1);
+		return true;
+	}
+	return false;
+}
+
+bool matchReferenceUrl(const std::string& line, size_t start, std::string& url,
+	optional<std::string>& title)
+{
+	// ([^ >]+)>?(title)?$ -- the longest URL that leaves a match, taking the
+	// closing '>' whenever it can.
+	size_t run=start;
+	while (run<line.length() && line[run]!=' ' && line[run]!='>') ++run;
+	if (run==start) return false;
+
+	std::string t;
+	title=none;
+	url=line.substr(start, run-start);
+	if (run==line.length()) return true;
+	if (line[run]=='>') {
+		if (matchReferenceTitle(line, run+1, t)) {
+			title=t;
+			return true;
+		} else if (run+1==line.length()) return true;
+	} else if (matchReferenceTitle(line, run, t)) {
+		title=t;
+		return true;
+	}
+
+	// Failing that, a shorter URL directly followed by its title.
+	for (size_t end=run-1; end>start; --end) {
+		if (matchReferenceTitle(line, end, t)) {
+			url=line.substr(start, end-start);
+			title=t;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool matchReference(const std::string& line, std::string& id, std::string& url,
+	optional<std::string>& title)
+{
+	// ^ {0,3}\[(.+)\]: +<?([^ >]+)>?(?: *(?:('|")(.*)\3)|(?:\((.*)\)))?$
+	// The id runs to the last "]:" the rest of the line matches after, and
+	// an opening '<' is taken out of the URL if that leaves a match.
+	size_t open=countLeading(line, 0, ' ');
+	if (open>3 || open==line.length() || line[open]!='[') return false;
+
+	for (size_t close=line.rfind("]:"); close!=std::string::npos && close>open+1;
+		close=line.rfind("]:", close-1))
+	{
+		size_t spaces=countLeading(line, close+2, ' '), start=close+2+spaces;
+		if (spaces==0) continue;
+		if ((start<line.length() && line[start]=='<' && matchReferenceUrl(line,
+			start+1, url, title)) || matchReferenceUrl(line, start, url, title))
+		{
+			id=line.substr(open+1, close-open-1);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool matchSeparateTitle(const std::string& line, std::string& title) {
+	// ^ *(?:(?:('|")(.*)\1)|(?:\((.*)\))) *$
+	size_t open=countLeading(line, 0, ' ');
+	if (open==line.length()) return false;
+	size_t close=line.find_last_not_of(' ');
+	char first=line[open], last=line[close];
+	if (close>open && (((first=='"' || first=='\'') && last==first) ||
+		(first=='(' && last==')')))
+	{
+		title=line.substr(open+1, close-open-1);
+		return true;
+	}
+	return false;
+}
+
 bool parseReference(CTokenGroupIter& i, CTokenGroupIter end, markdown::LinkIds &idTable) {
 	if ((*i)->text()) {
-		static const boost::regex cReference("^ {0,3}\\[(.+)\\]: +<?([^ >]+)>?(?: *(?:('|\")(.*)\\3)|(?:\\((.*)\\)))?$");
-		// Useful captures: 1=id, 2=url, 4/5=title
-
 		const std::string& line1(*(*i)->text());
-		boost::smatch m;
-		if (boost::regex_match(line1, m, cReference)) {
-			std::string id(m[1]), url(m[2]), title;
-			if (m[4].matched) title=m[4];
-			else if (m[5].matched) title=m[5];
+		std::string id, url, title;
+		optional<std::string> inlineTitle;
+		if (matchReference(line1, id, url, inlineTitle)) {
+			if (inlineTitle) title=*inlineTitle;
 			else {
 				CTokenGroupIter ii=i;
 				++ii;
 				if (ii!=end && (*ii)->text()) {
 					// It could be on the next line
-					static const boost::regex cSeparateTitle("^ *(?:(?:('|\")(.*)\\1)|(?:\\((.*)\\))) *$");
-					// Useful Captures: 2/3=title
-
 					const std::string& line2(*(*ii)->text());
-					if (boost::regex_match(line2, m, cSeparateTitle)) {
-						++i;
-						title=(m[2].matched ? m[2] : m[3]);
-					}
+					if (matchSeparateTitle(line2, title)) ++i;
 				}
 			}
 
@@ -521,42 +714,76 @@ bool parseReference(CTokenGroupIter& i, CTokenGroupIter end, markdown::LinkIds &
 }
 
 void flushParagraph(std::string& paragraphText, markdown::TokenGroup&
-	paragraphTokens, markdown::TokenGroup& finalTokens, bool noParagraphs)
+	paragraphTokens, markdown::TokenGroup& finalTokens, bool noParagraphs,
+	markdown::TokenArena& arena)
 {
 	if (!paragraphText.empty()) {
-		paragraphTokens.push_back(TokenPtr(new markdown::token::RawText(paragraphText)));
+		paragraphTokens.push_back(arena.make<markdown::token::RawText>(paragraphText));
 		paragraphText.clear();
 	}
 
 	if (!paragraphTokens.empty()) {
 		if (noParagraphs) {
 			if (paragraphTokens.size()>1) {
-				finalTokens.push_back(TokenPtr(new markdown::token::Container(paragraphTokens)));
+				finalTokens.push_back(arena.make<markdown::token::Container>(paragraphTokens));
 			} else finalTokens.push_back(*paragraphTokens.begin());
-		} else finalTokens.push_back(TokenPtr(new markdown::token::Paragraph(paragraphTokens)));
+		} else finalTokens.push_back(arena.make<markdown::token::Paragraph>(paragraphTokens));
 		paragraphTokens.clear();
 	}
 }
 
-optional<TokenPtr> parseHeader(CTokenGroupIter& i, CTokenGroupIter end) {
+bool matchHashHeader(const std::string& line, size_t& level, std::string&
+	content)
+{
+	// ^(#{1,6}) +(.*?) *#*$ -- the content drops any closing hashes and the
+	// spaces before them.
+	level=countLeading(line, 0, '#');
+	if (level<1 || level>6 || level==line.length() || line[level]!=' ') return false;
+
+	size_t begin=level+countLeading(line, level, ' '), end=line.length();
+	while (end>begin && line[end-1]=='#') --end;
+	while (end>begin && line[end-1]==' ') --end;
+	content=line.substr(begin, end-begin);
+	return true;
+}
+
+bool isHeaderUnderline(const std::string& line) {
+	// ^([-=])\1*$
+	if (line.empty() || (line[0]!='-' && line[0]!='=')) return false;
+	return (countLeading(line, 0, line[0])==line.length());
+}
+
+bool isHorizontalRule(const std::string& line) {
+	// ^ {0,3}((?:-|\*|_) *){3,}$
+	size_t pos=countLeading(line, 0, ' '), marks=0;
+	if (pos>3) return false;
+	for (; pos<line.length(); ++pos) {
+		if (line[pos]=='-' || line[pos]=='*' || line[pos]=='_') ++marks;
+		else if (line[pos]!=' ') return false;
+	}
+	return (marks>=3);
+}
+
+optional<TokenPtr> parseHeader(CTokenGroupIter& i, CTokenGroupIter end,
+	markdown::TokenArena& arena)
+{
 	if (!(*i)->isBlankLine() && (*i)->text() && (*i)->canContainMarkup()) {
 		// Hash-mark type
-		static const boost::regex cHashHeaders("^(#{1,6}) +(.*?) *#*$");
 		const std::string& line=*(*i)->text();
-		boost::smatch m;
-		if (boost::regex_match(line, m, cHashHeaders))
-			return TokenPtr(new markdown::token::Header(m[1].length(), m[2]));
+		size_t level;
+		std::string content;
+		if (matchHashHeader(line, level, content))
+			return arena.make<markdown::token::Header>(level, content);
 
 		// Underlined type
 		CTokenGroupIter ii=i;
 		++ii;
 		if (ii!=end && !(*ii)->isBlankLine() && (*ii)->text() && (*ii)->canContainMarkup()) {
-			static const boost::regex cUnderlinedHeaders("^([-=])\\1*$");
 			const std::string& line=*(*ii)->text();
-			if (boost::regex_match(line, m, cUnderlinedHeaders)) {
-				char typeChar=std::string(m[1])[0];
-				TokenPtr p=TokenPtr(new markdown::token::Header((typeChar=='='
-					? 1 : 2), *(*i)->text()));
+			if (isHeaderUnderline(line)) {
+				char typeChar=line[0];
+				TokenPtr p=arena.make<markdown::token::Header>((typeChar=='='
+					? 1 : 2), *(*i)->text());
 				i=ii;
 				return p;
 			}
@@ -565,17 +792,41 @@ optional<TokenPtr> parseHeader(CTokenGroupIter& i, CTokenGroupIter end) {
 	return none;
 }
 
-optional<TokenPtr> parseHorizontalRule(CTokenGroupIter& i, CTokenGroupIter end) {
+optional<TokenPtr> parseHorizontalRule(CTokenGroupIter& i, CTokenGroupIter end,
+	markdown::TokenArena& arena)
+{
 	if (!(*i)->isBlankLine() && (*i)->text() && (*i)->canContainMarkup()) {
-		static const boost::regex cHorizontalRules("^ {0,3}((?:-|\\*|_) *){3,}$");
 		const std::string& line=*(*i)->text();
-		if (boost::regex_match(line, cHorizontalRules)) {
-			return TokenPtr(new markdown::token::HtmlTag("hr/"));
+		if (isHorizontalRule(line)) {
+			return arena.make<markdown::token::HtmlTag>("hr/");
 		}
 	}
 	return none;
 }
 
+// A stream buffer that appends everything written to it to a string, so a
+// document can be written straight into the caller's buffer instead of into
+// an ostringstream that is then copied out.
+class StringAppender: public std::streambuf {
+	public:
+	StringAppender(std::string& out): mOut(out) { }
+
+	protected:
+	virtual std::streamsize xsputn(const char *s, std::streamsize n) {
+		mOut.append(s, n);
+		return n;
+	}
+
+	virtual int_type overflow(int_type c) {
+		if (!traits_type::eq_int_type(c, traits_type::eof()))
+			mOut.push_back(traits_type::to_char_type(c));
+		return traits_type::not_eof(c);
+	}
+
+	private:
+	std::string& mOut;
+};
+
 } // namespace
 
 
@@ -605,21 +856,23 @@ const size_t Document::cSpacesPerInitialTab=4; // Required by Markdown format
 const size_t Document::cDefaultSpacesPerTab=cSpacesPerInitialTab;
 
 Document::Document(size_t spacesPerTab): cSpacesPerTab(spacesPerTab),
-	mTokenContainer(new token::Container), mIdTable(new LinkIds),
-	mProcessed(false)
+	mArena(new TokenArena), mTokenContainer(mArena->make<token::Container>()),
+	mIdTable(new LinkIds), mSourceSize(0), mProcessed(false)
 {
 	// This space deliberately blank ;-)
 }
 
 Document::Document(std::istream& in, size_t spacesPerTab):
-	cSpacesPerTab(spacesPerTab), mTokenContainer(new token::Container),
-	mIdTable(new LinkIds), mProcessed(false)
+	cSpacesPerTab(spacesPerTab), mArena(new TokenArena),
+	mTokenContainer(mArena->make<token::Container>()), mIdTable(new LinkIds),
+	mSourceSize(0), mProcessed(false)
 {
 	read(in);
 }
 
 Document::~Document() {
 	delete mIdTable;
+	delete mArena;
 }
 
 bool Document::read(const std::string& src) {
@@ -656,16 +909,17 @@ bool Document::_getline(std::istream& in, std::string& line) {
 bool Document::read(std::istream& in) {
 	if (mProcessed) return false;
 
-	token::Container *tokens=dynamic_cast<token::Container*>(mTokenContainer.get());
+	token::Container *tokens=dynamic_cast<token::Container*>(mTokenContainer);
 	assert(tokens!=0);
 
 	std::string line;
 	TokenGroup tgt;
 	while (_getline(in, line)) {
+		mSourceSize+=line.length()+1;
 		if (isBlankLine(line)) {
-			tgt.push_back(TokenPtr(new token::BlankLine(line)));
+			tgt.push_back(mArena->make<token::BlankLine>(line));
 		} else {
-			tgt.push_back(TokenPtr(new token::RawText(line)));
+			tgt.push_back(mArena->make<token::RawText>(line));
 		}
 	}
 	tokens->appendSubtokens(tgt);
@@ -678,6 +932,21 @@ void Document::write(std::ostream& out) {
 	mTokenContainer->writeAsHtml(out);
 }
 
+void Document::write(std::string& out) {
+	size_t estimate=estimatedHtmlSize();
+	if (out.capacity()-out.size()<estimate) out.reserve(out.size()+estimate);
+
+	StringAppender appender(out);
+	std::ostream stream(&appender);
+	write(stream);
+}
+
+size_t Document::estimatedHtmlSize() const {
+	// The HTML of the test corpus is 1.15 to 1.7 times its markdown, lists
+	// and rules growing most, so half again covers most documents.
+	return mSourceSize+mSourceSize/2;
+}
+
 void Document::writeTokens(std::ostream& out) {
 	_process();
 	mTokenContainer->writeToken(0, out);
@@ -689,7 +958,8 @@ void Document::_process() {
 		_processInlineHtmlAndReferences();
 		_processBlocksItems(mTokenContainer);
 		_processParagraphLines(mTokenContainer);
-		mTokenContainer->processSpanElements(*mIdTable);
+		TokenGroup unused;
+		mTokenContainer->processSpanElements(*mIdTable, *mArena, unused);
 		mProcessed=true;
 	}
 }
@@ -700,19 +970,24 @@ void Document::_mergeMultilineHtmlTags() {
 
 	TokenGroup processed;
 
-	token::Container *tokens=dynamic_cast<token::Container*>(mTokenContainer.get());
+	token::Container *tokens=dynamic_cast<token::Container*>(mTokenContainer);
 	assert(tokens!=0);
 
 	for (TokenGroup::const_iterator i=tokens->subTokens().begin(),
 		ie=tokens->subTokens().end(); i!=ie; ++i)
 	{
-		if ((*i)->text() && boost::regex_match(*(*i)->text(), cHtmlTokenStart)) {
+		// Neither expression can match unless the first line starts with '<'
+		// and the second ends with '>', which rules out most lines cheaply.
+		if ((*i)->text() && !(*i)->text()->empty() && (*(*i)->text())[0]=='<' &&
+			boost::regex_match(*(*i)->text(), cHtmlTokenStart))
+		{
 			TokenGroup::const_iterator i2=i;
 			++i2;
 			if (i2!=tokens->subTokens().end() && (*i2)->text() &&
+				!(*i2)->text()->empty() && *(*i2)->text()->rbegin()=='>' &&
 				boost::regex_match(*(*i2)->text(), cHtmlTokenEnd))
 			{
-				processed.push_back(TokenPtr(new markdown::token::RawText(*(*i)->text()+' '+*(*i2)->text())));
+				processed.push_back(mArena->make<markdown::token::RawText>(*(*i)->text()+' '+*(*i2)->text()));
 				++i;
 				continue;
 			}
@@ -725,7 +1000,7 @@ void Document::_mergeMultilineHtmlTags() {
 void Document::_processInlineHtmlAndReferences() {
 	TokenGroup processed;
 
-	token::Container *tokens=dynamic_cast<token::Container*>(mTokenContainer.get());
+	token::Container *tokens=dynamic_cast<token::Container*>(mTokenContainer);
 	assert(tokens!=0);
 
 	for (TokenGroup::const_iterator ii=tokens->subTokens().begin(),
@@ -733,7 +1008,7 @@ void Document::_processInlineHtmlAndReferences() {
 	{
 		if ((*ii)->text()) {
 			if (processed.empty() || processed.back()->isBlankLine()) {
-				optional<TokenPtr> inlineHtml=parseInlineHtml(ii, iie);
+				optional<TokenPtr> inlineHtml=parseInlineHtml(ii, iie, *mArena);
 				if (inlineHtml) {
 					processed.push_back(*inlineHtml);
 					if (ii==iie) break;
@@ -759,7 +1034,7 @@ void Document::_processInlineHtmlAndReferences() {
 void Document::_processBlocksItems(TokenPtr inTokenContainer) {
 	if (!inTokenContainer->isContainer()) return;
 
-	token::Container *tokens=dynamic_cast<token::Container*>(inTokenContainer.get());
+	token::Container *tokens=dynamic_cast<token::Container*>(inTokenContainer);
 	assert(tokens!=0);
 
 	TokenGroup processed;
@@ -769,11 +1044,11 @@ void Document::_processBlocksItems(TokenPtr inTokenContainer) {
 	{
 		if ((*ii)->text()) {
 			optional<TokenPtr> subitem;
-			if (!subitem) subitem=parseHeader(ii, iie);
-			if (!subitem) subitem=parseHorizontalRule(ii, iie);
-			if (!subitem) subitem=parseListBlock(ii, iie);
-			if (!subitem) subitem=parseBlockQuote(ii, iie);
-			if (!subitem) subitem=parseCodeBlock(ii, iie);
+			if (!subitem) subitem=parseHeader(ii, iie, *mArena);
+			if (!subitem) subitem=parseHorizontalRule(ii, iie, *mArena);
+			if (!subitem) subitem=parseListBlock(ii, iie, *mArena);
+			if (!subitem) subitem=parseBlockQuote(ii, iie, *mArena);
+			if (!subitem) subitem=parseCodeBlock(ii, iie, *mArena);
 
 			if (subitem) {
 				_processBlocksItems(*subitem);
@@ -790,7 +1065,7 @@ void Document::_processBlocksItems(TokenPtr inTokenContainer) {
 }
 
 void Document::_processParagraphLines(TokenPtr inTokenContainer) {
-	token::Container *tokens=dynamic_cast<token::Container*>(inTokenContainer.get());
+	token::Container *tokens=dynamic_cast<token::Container*>(inTokenContainer);
 	assert(tokens!=0);
 
 	bool noPara=tokens->inhibitParagraphs();
@@ -805,23 +1080,23 @@ void Document::_processParagraphLines(TokenPtr inTokenContainer) {
 		iie=tokens->subTokens().end(); ii!=iie; ++ii)
 	{
 		if ((*ii)->text() && (*ii)->canContainMarkup() && !(*ii)->inhibitParagraphs()) {
-			static const boost::regex cExpression("^(.*)  $");
+			// ^(.*)  $
+			const std::string& line=*(*ii)->text();
 			if (!paragraphText.empty()) paragraphText+=" ";
 
-			boost::smatch m;
-			if (boost::regex_match(*(*ii)->text(), m, cExpression)) {
-				paragraphText += m[1];
-				flushParagraph(paragraphText, paragraphTokens, processed, noPara);
-				processed.push_back(TokenPtr(new markdown::token::HtmlTag("br/")));
-			} else paragraphText += *(*ii)->text();
+			if (line.length()>=2 && line.compare(line.length()-2, 2, "  ")==0) {
+				paragraphText.append(line, 0, line.length()-2);
+				flushParagraph(paragraphText, paragraphTokens, processed, noPara, *mArena);
+				processed.push_back(mArena->make<markdown::token::HtmlTag>("br/"));
+			} else paragraphText += line;
 		} else {
-			flushParagraph(paragraphText, paragraphTokens, processed, noPara);
+			flushParagraph(paragraphText, paragraphTokens, processed, noPara, *mArena);
 			processed.push_back(*ii);
 		}
 	}
 
 	// Make sure the last paragraph is properly flushed too.
-	flushParagraph(paragraphText, paragraphTokens, processed, noPara);
+	flushParagraph(paragraphText, paragraphTokens, processed, noPara, *mArena);
 
 	tokens->swapSubtokens(processed);
 }
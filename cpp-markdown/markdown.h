@@ -10,10 +10,9 @@
 
 #include <iostream>
 #include <string>
-#include <list>
+#include <vector>
 
 #include <boost/noncopyable.hpp>
-#include <boost/shared_ptr.hpp>
 #include <boost/optional.hpp>
 #include <boost/unordered_map.hpp>
 
@@ -25,9 +24,12 @@ namespace markdown {
 	// Forward references.
 	class Token;
 	class LinkIds;
+	class TokenArena;
 
-	typedef boost::shared_ptr<Token> TokenPtr;
-	typedef std::list<TokenPtr> TokenGroup;
+	// Tokens belong to the TokenArena of the Document that created them, and
+	// are destroyed along with it.
+	typedef Token* TokenPtr;
+	typedef std::vector<TokenPtr> TokenGroup;
 
 	class Document: private boost::noncopyable {
 		public:
@@ -41,8 +43,15 @@ namespace markdown {
 		bool read(const std::string&);
 		bool read(std::istream&);
 		void write(std::ostream&);
+		// Appends the HTML to out, growing it by estimatedHtmlSize() first
+		// if it has less room than that.
+		void write(std::string& out);
 		void writeTokens(std::ostream&); // For debugging
 
+		// Roughly how many bytes of HTML the input read so far makes, for
+		// sizing the buffer it's written to.
+		size_t estimatedHtmlSize() const;
+
 		// The class is marked noncopyable because it uses reference-counted
 		// links to things that get changed during processing. If you want to
 		// copy it, use the `copy` function to explicitly say that.
@@ -59,8 +68,10 @@ namespace markdown {
 		static const size_t cSpacesPerInitialTab, cDefaultSpacesPerTab;
 
 		const size_t cSpacesPerTab;
+		TokenArena *mArena;
 		TokenPtr mTokenContainer;
 		LinkIds *mIdTable;
+		size_t mSourceSize;
 		bool mProcessed;
 	};
 
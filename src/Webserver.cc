@@ -1,23 +1,54 @@
-// Based on Boost library blocking_tcp_echo_server example.
-// http://www.boost.org/doc/libs/1_55_0/doc/html/boost_asio/example/cpp11/echo/blocking_tcp_echo_server.cpp
+// Based on Boost library async_tcp_echo_server example.
+// http://www.boost.org/doc/libs/1_55_0/doc/html/boost_asio/example/cpp11/echo/async_tcp_echo_server.cpp
 
+#include "file_cache.h"
+#include "markdown_cache.h"
 #include "request_handler.h"
+#include "response_compressor.h"
 #include "server_status_tracker.h"
 #include "Webserver.h"
 #include <boost/asio.hpp>
+#include <csignal>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <thread>
 #include <utility>
+#include <vector>
 
 using boost::asio::ip::tcp;
 
+Webserver::Webserver()
+    : port(0), num_threads(0),
+      keepalive_timeout(DEFAULT_KEEPALIVE_TIMEOUT),
+      keepalive_requests(DEFAULT_KEEPALIVE_REQUESTS),
+      max_header_size(DEFAULT_MAX_HEADER_SIZE),
+      max_body_size(DEFAULT_MAX_BODY_SIZE),
+      reload_pending(false), stopping(false),
+      handlers(std::make_shared<HandlerTable>()) {
+}
+
 bool Webserver::load_configs(NginxConfig config) {
     if (config.statements_.size() == 0) {
         std::cerr << "Error: Empty config.\n";
         return false;
     }
 
+    // Everything is loaded into new settings and a new handler table, which
+    // only replace the current ones if the whole config is valid.
+    size_t new_port = 0;
+    size_t new_num_threads = 0;
+    size_t new_keepalive_timeout = DEFAULT_KEEPALIVE_TIMEOUT;
+    size_t new_keepalive_requests = DEFAULT_KEEPALIVE_REQUESTS;
+    size_t new_max_header_size = DEFAULT_MAX_HEADER_SIZE;
+    size_t new_max_body_size = DEFAULT_MAX_BODY_SIZE;
+    size_t new_file_cache_size = DEFAULT_FILE_CACHE_SIZE;
+    size_t new_markdown_cache_size = DEFAULT_MARKDOWN_CACHE_SIZE;
+    size_t new_gzip_level = DEFAULT_GZIP_LEVEL;
+    size_t new_gzip_min_length = DEFAULT_GZIP_MIN_LENGTH;
+    size_t new_gzip_cache_size = DEFAULT_GZIP_CACHE_SIZE;
+    std::shared_ptr<HandlerTable> table = std::make_shared<HandlerTable>();
+
     for (size_t i = 0; i < config.statements_.size(); i++) {
         std::shared_ptr<NginxConfigStatement> parent_statement = config.statements_[i];
         NginxConfig child_config;
@@ -47,25 +78,67 @@ bool Webserver::load_configs(NginxConfig config) {
 
         // Parse statements
         if (first_token == "port" && third_token == "") {
-            if (has_child) {
+            if (has_child || !parse_number(second_token, &new_port) || new_port > 65535) {
                 return syntax_error(parent_statement);
             }
-
-            bool is_number = (second_token.find_first_not_of("1234567890") == std::string::npos);
-            if (is_number) {
-                port = std::stoi(second_token);
+        }
+        else if (first_token == "threads" && third_token == "") {
+            if (has_child || !parse_number(second_token, &new_num_threads) || new_num_threads == 0) {
+                return syntax_error(parent_statement);
             }
-            else {
+        }
+        else if (first_token == "keepalive_timeout" && third_token == "") {
+            if (has_child || !parse_number(second_token, &new_keepalive_timeout)) {
+                return syntax_error(parent_statement);
+            }
+        }
+        else if (first_token == "keepalive_requests" && third_token == "") {
+            if (has_child || !parse_number(second_token, &new_keepalive_requests)) {
+                return syntax_error(parent_statement);
+            }
+        }
+        else if (first_token == "max_header_size" && third_token == "") {
+            if (has_child || !parse_number(second_token, &new_max_header_size) || new_max_header_size == 0) {
+                return syntax_error(parent_statement);
+            }
+        }
+        else if (first_token == "max_body_size" && third_token == "") {
+            if (has_child || !parse_number(second_token, &new_max_body_size)) {
+                return syntax_error(parent_statement);
+            }
+        }
+        else if (first_token == "file_cache_size" && third_token == "") {
+            if (has_child || !parse_number(second_token, &new_file_cache_size)) {
+                return syntax_error(parent_statement);
+            }
+        }
+        else if (first_token == "markdown_cache_size" && third_token == "") {
+            if (has_child || !parse_number(second_token, &new_markdown_cache_size)) {
+                return syntax_error(parent_statement);
+            }
+        }
+        else if (first_token == "gzip_level" && third_token == "") {
+            if (has_child || !parse_number(second_token, &new_gzip_level) || new_gzip_level > 9) {
+                return syntax_error(parent_statement);
+            }
+        }
+        else if (first_token == "gzip_min_length" && third_token == "") {
+            if (has_child || !parse_number(second_token, &new_gzip_min_length)) {
+                return syntax_error(parent_statement);
+            }
+        }
+        else if (first_token == "gzip_cache_size" && third_token == "") {
+            if (has_child || !parse_number(second_token, &new_gzip_cache_size)) {
                 return syntax_error(parent_statement);
             }
         }
         else if (first_token == "path" && third_token != "") {
-                if (!add_handler(second_token, child_config, third_token)) {
+                if (!add_handler(table.get(), second_token, child_config, third_token)) {
                     return false;
                 }
         }
         else if (first_token == "default" && third_token == "") {
-                if (!add_handler(first_token, child_config, second_token)) {
+                if (!add_handler(table.get(), first_token, child_config, second_token)) {
                     return false;
                 }
         }
@@ -74,6 +147,38 @@ bool Webserver::load_configs(NginxConfig config) {
         }
     }
 
+    // The listening socket and worker pool can't change under a running server.
+    if (acceptor && (new_port != port || new_num_threads != num_threads)) {
+        std::cerr << "Warning: port and threads only change on restart.\n";
+    }
+    else {
+        port = new_port;
+        num_threads = new_num_threads;
+    }
+    keepalive_timeout = new_keepalive_timeout;
+    keepalive_requests = new_keepalive_requests;
+    max_header_size = new_max_header_size;
+    max_body_size = new_max_body_size;
+    FileCache::GetInstance().set_capacity(new_file_cache_size);
+    MarkdownCache::GetInstance().set_capacity(new_markdown_cache_size);
+    ResponseCompressor::GetInstance().configure(new_gzip_level, new_gzip_min_length, new_gzip_cache_size);
+
+    table->compile();
+    ServerStatusTracker::GetInstance().SetHandlerMappings(table->mappings());
+    {
+        std::lock_guard<std::mutex> lock(handlers_mutex);
+        handlers = table;
+    }
+    return true;
+}
+
+bool Webserver::parse_number(const std::string& token, size_t* value) {
+    // Only accept plain decimal numbers short enough to not overflow.
+    if (token.empty() || token.length() > 9 ||
+        token.find_first_not_of("1234567890") != std::string::npos) {
+        return false;
+    }
+    *value = std::stoul(token);
     return true;
 }
 
@@ -83,7 +188,8 @@ bool Webserver::syntax_error(std::shared_ptr<NginxConfigStatement> parent_statem
     return false;
 }
 
-bool Webserver::add_handler(std::string uri_prefix, NginxConfig child_config, std::string handler_name) {
+bool Webserver::add_handler(HandlerTable* table, std::string uri_prefix, NginxConfig child_config,
+                            std::string handler_name) {
     const char* name = handler_name.c_str();
 
     RequestHandler* handler = RequestHandler::CreateByName(name);
@@ -95,24 +201,21 @@ bool Webserver::add_handler(std::string uri_prefix, NginxConfig child_config, st
 
     if (handler->Init(uri_prefix, child_config) != RequestHandler::Status::OK) {
         std::cerr << "Error: Invalid handler config.\n";
+        delete handler;
         return false;
     }
-    std::unordered_map<std::string, RequestHandler*>::const_iterator found = handler_map.find(uri_prefix);
-    // If mapping already exists, return false, else add to map
-    if (found != handler_map.end()) {
+    // If mapping already exists, return false, else add to the table
+    if (!table->add(uri_prefix, handler, handler_name)) {
         std::cerr << "Error: " << uri_prefix << " is already mapped.\n";
         return false;
-    } else {
-        handler_map[uri_prefix] = handler;
     }
 
-    ServerStatusTracker::GetInstance().RecordHandlerMapping(uri_prefix, handler_name);
-
     return true;
 }
 
 bool Webserver::parse_config(const char* file_name) {
 	// Try to parse the config file.
+	config_file = file_name;
 	if (config_parser.Parse(file_name, &config_out)) {
         // Put configs into map
         return load_configs(config_out);
@@ -123,86 +226,156 @@ bool Webserver::parse_config(const char* file_name) {
 	}
 }
 
-RequestHandler* Webserver::get_handler(std::string uri) {
-    std::unordered_map<std::string, RequestHandler*>::const_iterator found = handler_map.find(uri);
-    // Get the uri_prefix
-    if (found != handler_map.end()) {
-        return found->second;
-    } else {
-        std::string prefix = find_prefix(uri);
-        found = handler_map.find(prefix);
-        if (found != handler_map.end()) {
-            return found->second;
-        }
-        else {
-            found = handler_map.find("default");
-            return found->second;
-        }
+bool Webserver::reload_config() {
+    NginxConfigParser parser;
+    NginxConfig config;
+    if (!parser.Parse(config_file.c_str(), &config) || !load_configs(config)) {
+        std::cerr << "Error: Could not reload " << config_file << ", keeping the current config.\n";
+        return false;
     }
+
+    std::cout << "Reloaded " << config_file << std::endl;
+    return true;
+}
+
+RequestHandler* Webserver::get_handler(boost::string_ref uri) {
+    return get_handlers()->find(uri);
+}
+
+std::shared_ptr<const HandlerTable> Webserver::get_handlers() {
+    std::lock_guard<std::mutex> lock(handlers_mutex);
+    return handlers;
 }
 
 unsigned short Webserver::get_port() {
     return port;
 }
 
-void Webserver::session(tcp::socket sock) {
-    try {
-        for (;;) {
-            char request[MAX_LENGTH];
-            boost::system::error_code error;
+size_t Webserver::get_num_threads() {
+    // Default to one worker per core.
+    if (num_threads == 0) {
+        size_t cores = std::thread::hardware_concurrency();
+        return cores > 0 ? cores : 1;
+    }
+    return num_threads;
+}
 
-            // Read the request.
-            size_t request_length = sock.read_some(boost::asio::buffer(request), error);
+size_t Webserver::get_keepalive_timeout() {
+    return keepalive_timeout;
+}
 
-            const std::unique_ptr<Request> req = Request::Parse(std::string(request, request_length));
+size_t Webserver::get_keepalive_requests() {
+    return keepalive_requests;
+}
 
-            RequestHandler* handler = get_handler(req->uri());
-            Response resp;
+size_t Webserver::get_max_header_size() {
+    return max_header_size;
+}
 
-            if (handler->HandleRequest(*req, &resp) == RequestHandler::Status::FILE_NOT_FOUND) {
-                handler = get_handler("default");
-                handler->HandleRequest(*req, &resp);
-                std::cerr << "Error: File not found.\n";
-            }
+size_t Webserver::get_max_body_size() {
+    return max_body_size;
+}
 
-            ServerStatusTracker::GetInstance().RecordRequest(req->uri(), resp.status_code());
+BufferPool& Webserver::get_buffer_pool() {
+    return buffer_pool;
+}
 
-            boost::asio::write(sock, boost::asio::buffer(resp.ToString()));
-            return;
-        }
-    }
-    catch (std::exception& e) {
-        std::cerr << "Exception in thread: " << e.what() << "\n";
+void Webserver::handle_request(const Request& req, Response* resp) {
+    // Keeps this request's handlers alive even if the config is reloaded
+    // before it finishes.
+    std::shared_ptr<const HandlerTable> table = get_handlers();
+    RequestHandler* handler = table->find(req.uri());
+
+    if (handler->HandleRequest(req, resp) == RequestHandler::Status::FILE_NOT_FOUND) {
+        handler = table->find("default");
+        handler->HandleRequest(req, resp);
+        std::cerr << "Error: File not found.\n";
     }
+
+    ResponseCompressor::GetInstance().compress(req, resp);
+
+    ServerStatusTracker::GetInstance().RecordRequest(req.uri().to_string(), resp->status_code());
 }
 
 void Webserver::run_server(boost::asio::io_service& io_service) {
     // Listen on the given port
-    tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port));
-    
-    for (;;) {
-        // Create a socket to accept connections on the port
-        tcp::socket sock(io_service);
-        acceptor.accept(sock);
-        std::thread(&Webserver::session, this, std::move(sock)).detach();
+    acceptor.reset(new tcp::acceptor(io_service, tcp::endpoint(tcp::v4(), port)));
+    start_accept(io_service);
+
+    // Reload the config on SIGHUP, on a thread of its own.
+    reload_signals.reset(new boost::asio::signal_set(io_service, SIGHUP));
+    reloader = std::thread(&Webserver::run_reloader, this);
+    wait_for_reload();
+
+    // Run the io_service on a fixed pool of worker threads. This thread is
+    // one of the workers.
+    size_t workers = get_num_threads();
+    std::cout << "Serving on port " << port << " with " << workers << " worker threads" << std::endl;
+
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < workers; i++) {
+        pool.emplace_back([&io_service]() { io_service.run(); });
+    }
+    io_service.run();
+
+    for (auto& worker : pool) {
+        worker.join();
     }
+
+    {
+        std::lock_guard<std::mutex> lock(reload_mutex);
+        stopping = true;
+    }
+    reload_requested.notify_one();
+    reloader.join();
 }
 
-std::string Webserver::find_prefix(std::string uri) {
-    std::string longest = "";
-    size_t last = uri.find_last_of("/");
-    std::string prefix = uri.substr(0, last);
+void Webserver::start_accept(boost::asio::io_service& io_service) {
+    std::shared_ptr<Connection> conn(new Connection(io_service, *this));
+    acceptor->async_accept(conn->socket(),
+        std::bind(&Webserver::handle_accept, this, std::ref(io_service), conn, std::placeholders::_1));
+}
+
+void Webserver::handle_accept(boost::asio::io_service& io_service, std::shared_ptr<Connection> conn,
+                              const boost::system::error_code& error) {
+    if (!error) {
+        conn->start();
+    }
+    else {
+        std::cerr << "Error: Could not accept connection: " << error.message() << "\n";
+    }
 
-    for (auto it : handler_map) {
-        std::string map = it.first;
+    start_accept(io_service);
+}
 
-        if (prefix.find(map) == 0 && (prefix.find("/", map.length()) == map.length() || 
-            map.length() == prefix.length() || map.length() == 1)) {
-            if (map.length() > longest.length()) {
-                longest = map;
+void Webserver::wait_for_reload() {
+    reload_signals->async_wait([this](const boost::system::error_code& error, int) {
+        if (!error) {
+            {
+                std::lock_guard<std::mutex> lock(reload_mutex);
+                reload_pending = true;
             }
+            reload_requested.notify_one();
+            wait_for_reload();
+        }
+    });
+}
+
+void Webserver::run_reloader() {
+    std::unique_lock<std::mutex> lock(reload_mutex);
+    while (true) {
+        reload_requested.wait(lock, [this]() { return reload_pending || stopping; });
+        if (stopping) {
+            return;
         }
+        // Signals caught while reloading are coalesced into one more reload.
+        reload_pending = false;
+        lock.unlock();
+        reload_config();
+        lock.lock();
     }
+}
 
-    return longest;
+std::string Webserver::find_prefix(std::string uri) {
+    return get_handlers()->find_prefix(uri);
 }
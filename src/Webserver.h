@@ -1,31 +1,91 @@
 #ifndef WEBSERVER_H
 #define WEBSERVER_H
 
+#include "buffer_pool.h"
 #include "config_parser.h"
+#include "connection.h"
+#include "handler_table.h"
 #include "request_handler.h"
 #include <boost/asio.hpp>
-#include <unordered_map>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 
-const int MAX_LENGTH = 4096;
+// Defaults for persistent connections. Timeout is in seconds.
+const size_t DEFAULT_KEEPALIVE_TIMEOUT = 5;
+const size_t DEFAULT_KEEPALIVE_REQUESTS = 100;
+
+// Largest request head (request line and headers) and body accepted, in bytes.
+const size_t DEFAULT_MAX_HEADER_SIZE = 8192;
+const size_t DEFAULT_MAX_BODY_SIZE = 1024 * 1024;
 
 class Webserver {
 public:
+    Webserver();
     bool load_configs(NginxConfig config);
     bool parse_config(const char* file_name);
+    // Parses the config file again and swaps in its handlers. Requests
+    // already running finish on the old handlers. On failure the current
+    // config stays in place.
+    bool reload_config();
     void run_server(boost::asio::io_service& io_service);
-    void session(boost::asio::ip::tcp::socket sock);
+    void handle_request(const Request& req, Response* resp);
+    bool parse_number(const std::string& token, size_t* value);
     bool syntax_error(std::shared_ptr<NginxConfigStatement> parent_statement);
-    bool add_handler(std::string uri_prefix, NginxConfig child_config, std::string handler_name);
-    virtual RequestHandler* get_handler(std::string uri);
+    bool add_handler(HandlerTable* table, std::string uri_prefix, NginxConfig child_config,
+                     std::string handler_name);
+    // The handler only stays valid until the next reload; hold on to
+    // get_handlers() to keep it alive longer.
+    virtual RequestHandler* get_handler(boost::string_ref uri);
+    std::shared_ptr<const HandlerTable> get_handlers();
     unsigned short get_port();
+    size_t get_num_threads();
+    size_t get_keepalive_timeout();
+    size_t get_keepalive_requests();
+    size_t get_max_header_size();
+    size_t get_max_body_size();
+    BufferPool& get_buffer_pool();
     std::string buffer_to_string(const boost::asio::streambuf &buffer);
     std::string find_prefix(std::string uri);
 
 private:
+    void start_accept(boost::asio::io_service& io_service);
+    void handle_accept(boost::asio::io_service& io_service, std::shared_ptr<Connection> conn,
+                       const boost::system::error_code& error);
+    void wait_for_reload();
+    // Runs reload_config each time SIGHUP is caught, until the server stops.
+    // Handlers walk their roots when they are set up, which must not hold up
+    // the workers serving requests.
+    void run_reloader();
+
     NginxConfigParser config_parser;
     NginxConfig config_out;
+    std::string config_file;
+    // Fixed once the server is running.
     unsigned short port;
-    std::unordered_map<std::string, RequestHandler*> handler_map;
+    size_t num_threads;
+    // May change on reload while connections read them.
+    std::atomic<size_t> keepalive_timeout;
+    std::atomic<size_t> keepalive_requests;
+    std::atomic<size_t> max_header_size;
+    std::atomic<size_t> max_body_size;
+    BufferPool buffer_pool;
+    std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor;
+    std::unique_ptr<boost::asio::signal_set> reload_signals;
+    std::thread reloader;
+    std::mutex reload_mutex;
+    std::condition_variable reload_requested;
+    bool reload_pending;
+    bool stopping;
+    // The current handlers. Each request copies the pointer and keeps the
+    // table alive until it is done; a reload only replaces the pointer. The
+    // mutex is held just for the copy or the swap (GCC 4.8 has no
+    // std::atomic_load for shared_ptr).
+    std::shared_ptr<const HandlerTable> handlers;
+    std::mutex handlers_mutex;
 };
 
 #endif
@@ -0,0 +1,37 @@
+#include "buffer_pool.h"
+#include <utility>
+
+BufferPool::BufferPool(size_t buffer_size, size_t max_buffers, size_t max_retained_size)
+    : buffer_size_(buffer_size), max_buffers_(max_buffers),
+      max_retained_size_(max_retained_size) {
+}
+
+std::string BufferPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!buffers_.empty()) {
+            std::string buffer = std::move(buffers_.back());
+            buffers_.pop_back();
+            return buffer;
+        }
+    }
+
+    return std::string(buffer_size_, '\0');
+}
+
+void BufferPool::release(std::string buffer) {
+    // Let oversized buffers go so one large request doesn't pin its memory.
+    if (buffer.size() < buffer_size_ || buffer.capacity() > max_retained_size_) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffers_.size() < max_buffers_) {
+        buffers_.push_back(std::move(buffer));
+    }
+}
+
+size_t BufferPool::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return buffers_.size();
+}
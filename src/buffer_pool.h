@@ -0,0 +1,40 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+const size_t INITIAL_BUFFER_SIZE = 4096;
+
+// Thread-safe pool of reusable receive buffers. Connections acquire a buffer
+// when they start and release it when they are destroyed, so steady-state
+// traffic does not allocate a new buffer per connection. Buffers that grew
+// past max_retained_size while reading a large request are freed rather
+// than pooled.
+//
+// Usage:
+//   BufferPool pool;
+//   std::string buffer = pool.acquire();
+//   ...
+//   pool.release(std::move(buffer));
+class BufferPool {
+ public:
+    BufferPool(size_t buffer_size = INITIAL_BUFFER_SIZE, size_t max_buffers = 1024,
+               size_t max_retained_size = 64 * 1024);
+
+    // Returns a buffer of at least buffer_size bytes.
+    std::string acquire();
+    void release(std::string buffer);
+
+    size_t size();
+
+ private:
+    size_t buffer_size_;
+    size_t max_buffers_;
+    size_t max_retained_size_;
+    std::mutex mutex_;
+    std::vector<std::string> buffers_;
+};
+
+#endif  // BUFFER_POOL_H
@@ -0,0 +1,116 @@
+#include "byte_range.h"
+#include "header_map.h"
+#include <algorithm>
+
+namespace byte_range {
+namespace {
+
+void skip_spaces(boost::string_ref* s) {
+    while (!s->empty() && (s->front() == ' ' || s->front() == '\t')) {
+        s->remove_prefix(1);
+    }
+}
+
+// Parses a run of digits, without overflowing.
+bool parse_number(boost::string_ref* s, size_t* value) {
+    size_t digits = 0;
+    *value = 0;
+    while (digits < s->size() && (*s)[digits] >= '0' && (*s)[digits] <= '9') {
+        if (*value > (static_cast<size_t>(-1) - 9) / 10) {
+            return false;
+        }
+        *value = *value * 10 + ((*s)[digits] - '0');
+        digits++;
+    }
+    s->remove_prefix(digits);
+    return digits > 0;
+}
+
+}  // namespace
+
+Result parse(boost::string_ref header, size_t length, std::vector<Range>* ranges) {
+    ranges->clear();
+
+    skip_spaces(&header);
+    if (header.size() < 6 || !header_names::equals(header.substr(0, 6), "bytes=")) {
+        return IGNORE;
+    }
+    header.remove_prefix(6);
+
+    size_t num_specs = 0;
+    while (true) {
+        skip_spaces(&header);
+
+        // "first-last", "first-" or "-suffix_length"
+        size_t first = 0;
+        size_t last = 0;
+        bool has_first = parse_number(&header, &first);
+        if (header.empty() || header.front() != '-') {
+            return IGNORE;
+        }
+        header.remove_prefix(1);
+        bool has_last = parse_number(&header, &last);
+
+        if (!has_first && !has_last) {
+            return IGNORE;
+        }
+        if (has_first && has_last && last < first) {
+            return IGNORE;
+        }
+        if (++num_specs > MAX_RANGES) {
+            return IGNORE;
+        }
+
+        if (!has_first) {
+            // The last bytes of the file.
+            if (last > 0 && length > 0) {
+                Range range = {length - std::min(last, length), length - 1};
+                ranges->push_back(range);
+            }
+        } else if (first < length) {
+            Range range = {first, has_last ? std::min(last, length - 1) : length - 1};
+            ranges->push_back(range);
+        }
+
+        skip_spaces(&header);
+        if (header.empty()) {
+            break;
+        }
+        if (header.front() != ',') {
+            return IGNORE;
+        }
+        header.remove_prefix(1);
+    }
+
+    if (ranges->empty()) {
+        return NOT_SATISFIABLE;
+    }
+
+    std::sort(ranges->begin(), ranges->end(), [](const Range& a, const Range& b) {
+        return a.first < b.first;
+    });
+    size_t merged = 0;
+    for (size_t i = 1; i < ranges->size(); i++) {
+        Range& previous = (*ranges)[merged];
+        const Range& range = (*ranges)[i];
+        if (range.first <= previous.last + 1) {
+            previous.last = std::max(previous.last, range.last);
+        } else {
+            (*ranges)[++merged] = range;
+        }
+    }
+    ranges->resize(merged + 1);
+
+    return SATISFIABLE;
+}
+
+std::string content_range(const Range& range, size_t length) {
+    return "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" +
+           std::to_string(length);
+}
+
+std::string unsatisfied_range(size_t length) {
+    return "bytes */" + std::to_string(length);
+}
+
+}  // namespace byte_range
@@ -0,0 +1,48 @@
+#ifndef BYTE_RANGE_H
+#define BYTE_RANGE_H
+
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Parsing of Range request headers (RFC 7233) for static files.
+namespace byte_range {
+
+// The bytes [first, last] of a file.
+struct Range {
+    size_t first;
+    size_t last;
+
+    size_t length() const {
+        return last - first + 1;
+    }
+};
+
+enum Result {
+    // No usable Range header: send the whole file.
+    IGNORE,
+    // Send the ranges with 206 Partial Content.
+    SATISFIABLE,
+    // No range overlaps the file: send 416 Range Not Satisfiable.
+    NOT_SATISFIABLE
+};
+
+// More ranges than this in one header are ignored, as a guard against
+// requests for the same bytes over and over.
+const size_t MAX_RANGES = 16;
+
+// Parses a header like "bytes=0-99,200-,-50" against a file of the given
+// length. Satisfiable ranges are clamped to the file, sorted, and merged
+// where they overlap or touch. Malformed headers and units other than bytes
+// are ignored.
+Result parse(boost::string_ref header, size_t length, std::vector<Range>* ranges);
+
+// The Content-Range value for a range of a file, e.g. "bytes 0-99/1000".
+std::string content_range(const Range& range, size_t length);
+// The Content-Range value of a 416 response, e.g. "bytes */1000".
+std::string unsatisfied_range(size_t length);
+
+}  // namespace byte_range
+
+#endif  // BYTE_RANGE_H
@@ -0,0 +1,283 @@
+// Based on Boost library async_tcp_echo_server example.
+// http://www.boost.org/doc/libs/1_55_0/doc/html/boost_asio/example/cpp11/echo/async_tcp_echo_server.cpp
+
+#include "connection.h"
+#include "Webserver.h"
+#include <boost/algorithm/string/predicate.hpp>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <iostream>
+
+using boost::asio::ip::tcp;
+
+Connection::Connection(boost::asio::io_service& io_service, Webserver& server)
+    : socket_(io_service), strand_(io_service), timer_(io_service),
+      server_(server), buffered_(0), file_sent_(0), requests_served_(0), keep_alive_(false) {
+}
+
+Connection::~Connection() {
+    if (!buffer_.empty()) {
+        server_.get_buffer_pool().release(std::move(buffer_));
+    }
+}
+
+tcp::socket& Connection::socket() {
+    return socket_;
+}
+
+void Connection::start() {
+    buffer_ = server_.get_buffer_pool().acquire();
+    do_read();
+}
+
+bool Connection::wants_keep_alive(const Request& req) {
+    // HTTP/1.1 connections persist unless the client asks to close them.
+    // HTTP/1.0 connections close unless the client asks to keep them alive.
+    bool keep_alive = (req.version() == "HTTP/1.1");
+
+    const boost::string_ref* connection = req.headers().find("Connection");
+    if (connection) {
+        if (boost::algorithm::icontains(*connection, "close")) {
+            keep_alive = false;
+        } else if (boost::algorithm::icontains(*connection, "keep-alive")) {
+            keep_alive = true;
+        }
+    }
+
+    return keep_alive;
+}
+
+void Connection::do_read() {
+    // Make room for more data, growing up to the largest request we accept.
+    if (buffered_ == buffer_.size()) {
+        size_t needed = parser_.head_complete() ? parser_.request_length() : buffered_ + 1;
+        buffer_.resize(std::max(needed, buffer_.size() * 2));
+    }
+
+    // Drop the connection if the client stays idle for too long.
+    timer_.expires_from_now(boost::posix_time::seconds(server_.get_keepalive_timeout()));
+    timer_.async_wait(strand_.wrap(
+        std::bind(&Connection::handle_timeout, shared_from_this(), std::placeholders::_1)));
+
+    socket_.async_read_some(boost::asio::buffer(&buffer_[buffered_], buffer_.size() - buffered_),
+        strand_.wrap(std::bind(&Connection::handle_read, shared_from_this(),
+                               std::placeholders::_1, std::placeholders::_2)));
+}
+
+void Connection::handle_read(const boost::system::error_code& error, size_t bytes_transferred) {
+    timer_.cancel();
+
+    if (error) {
+        // Client closed the connection, or it timed out.
+        close();
+        return;
+    }
+
+    buffered_ += bytes_transferred;
+    process_buffer();
+}
+
+void Connection::process_buffer() {
+    bool had_head = parser_.head_complete();
+    RequestParser::Result result = parser_.parse(buffer_.data(), buffered_);
+
+    if (result == RequestParser::ERROR) {
+        send_error(Response::ResponseCode::BAD_REQUEST);
+        return;
+    }
+
+    if (!parser_.head_complete()) {
+        if (buffered_ >= server_.get_max_header_size()) {
+            send_error(Response::ResponseCode::REQUEST_HEADER_FIELDS_TOO_LARGE);
+            return;
+        }
+        do_read();
+        return;
+    }
+
+    // Check the limits once, when the head first comes in.
+    if (!had_head) {
+        if (parser_.head_length() > server_.get_max_header_size()) {
+            send_error(Response::ResponseCode::REQUEST_HEADER_FIELDS_TOO_LARGE);
+            return;
+        }
+        if (parser_.content_length() > server_.get_max_body_size()) {
+            send_error(Response::ResponseCode::PAYLOAD_TOO_LARGE);
+            return;
+        }
+    }
+
+    if (result == RequestParser::INCOMPLETE) {
+        do_read();
+        return;
+    }
+
+    handle_request(parser_.request_length());
+}
+
+void Connection::handle_request(size_t request_length) {
+    try {
+        // The request is a view of the receive buffer, which stays untouched
+        // until the handler is done with it.
+        const std::unique_ptr<Request> req = Request::Parse(parser_, buffer_.data(), request_length);
+        std::cout << "Request for " << req->uri() << std::endl;
+
+        Response resp;
+        server_.handle_request(*req, &resp);
+
+        requests_served_++;
+        keep_alive_ = wants_keep_alive(*req) &&
+                      requests_served_ < server_.get_keepalive_requests();
+
+        write_response(resp, req->version());
+
+        // Keep anything past this request for the next one.
+        std::memmove(&buffer_[0], &buffer_[request_length], buffered_ - request_length);
+        buffered_ -= request_length;
+        parser_.reset();
+    }
+    catch (std::exception& e) {
+        std::cerr << "Exception in connection: " << e.what() << "\n";
+        close();
+    }
+}
+
+void Connection::send_error(Response::ResponseCode code) {
+    // We can't tell where the next request would start, so close afterwards.
+    keep_alive_ = false;
+
+    Response resp;
+    resp.SetStatus(code);
+    resp.AddHeader("Content-Type", "text/html");
+    resp.SetBody("<html><body><h1>" + std::to_string(code) + "</h1></body></html>");
+    write_response(resp, "HTTP/1.1");
+}
+
+void Connection::write_response(Response& resp, boost::string_ref version) {
+#ifndef __linux__
+    // Without Linux's sendfile(), send files from memory.
+    if (resp.file_body()) {
+        resp.SetBody(resp.file_body()->Read(resp.file_offset(), resp.body_length()));
+    }
+#endif
+
+    // Frame every response so the client can find its end without us
+    // closing the connection.
+    resp.SetVersion(version == "HTTP/1.1" ? "HTTP/1.1" : "HTTP/1.0");
+    resp.RemoveHeader("Keep-Alive");
+    resp.RemoveHeader("Transfer-Encoding");
+    if (resp.status_code() == Response::ResponseCode::NOT_MODIFIED) {
+        // A 304 never has a body, and its Content-Length would describe the
+        // file the client already has.
+        resp.RemoveHeader("Content-Length");
+    } else {
+        resp.SetHeader("Content-Length", std::to_string(resp.body_length()));
+    }
+    resp.SetHeader("Connection", keep_alive_ ? "keep-alive" : "close");
+
+    // Send the head and body in one vectored write, without copying the
+    // body. Both stay alive in the connection until the write completes.
+    response_ = std::move(resp);
+    head_.clear();
+    response_.SerializeHead(&head_);
+
+    if (response_.file_body()) {
+        // Hold the head back until the file is queued behind it.
+        set_cork(true);
+        file_sent_ = 0;
+        boost::asio::async_write(socket_, boost::asio::buffer(head_),
+            strand_.wrap(std::bind(&Connection::send_file, shared_from_this(), std::placeholders::_1)));
+        return;
+    }
+
+    std::array<boost::asio::const_buffer, 2> buffers = {{
+        boost::asio::buffer(head_), boost::asio::buffer(response_.body().data(), response_.body().size())
+    }};
+    boost::asio::async_write(socket_, buffers,
+        strand_.wrap(std::bind(&Connection::handle_write, shared_from_this(),
+                               std::placeholders::_1, std::placeholders::_2)));
+}
+
+void Connection::handle_write(const boost::system::error_code& error, size_t bytes_transferred) {
+    if (error || !keep_alive_) {
+        close();
+        return;
+    }
+
+    // The next request may already be buffered.
+    process_buffer();
+}
+
+void Connection::send_file(const boost::system::error_code& error) {
+#ifdef __linux__
+    if (error) {
+        close();
+        return;
+    }
+
+    // sendfile() must not block the worker thread, so the socket is made
+    // non-blocking and we wait for it to be writable whenever it's full.
+    boost::system::error_code ignored;
+    socket_.native_non_blocking(true, ignored);
+
+    const FileBody& file = *response_.file_body();
+    size_t length = response_.body_length();
+    while (file_sent_ < length) {
+        off_t offset = response_.file_offset() + file_sent_;
+        ssize_t sent = ::sendfile(socket_.native_handle(), file.fd(), &offset, length - file_sent_);
+        if (sent > 0) {
+            file_sent_ += sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            socket_.async_write_some(boost::asio::null_buffers(),
+                strand_.wrap(std::bind(&Connection::send_file, shared_from_this(), std::placeholders::_1)));
+            return;
+        }
+
+        // A write error, or the file shrank and can't fill Content-Length.
+        close();
+        return;
+    }
+
+    set_cork(false);
+    handle_write(error, head_.size() + file_sent_);
+#endif
+}
+
+void Connection::set_cork(bool cork) {
+#ifdef TCP_CORK
+    int value = cork ? 1 : 0;
+    setsockopt(socket_.native_handle(), IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+#endif
+}
+
+void Connection::handle_timeout(const boost::system::error_code& error) {
+    // The timer is cancelled whenever a read completes.
+    if (error == boost::asio::error::operation_aborted) {
+        return;
+    }
+
+    if (timer_.expires_at() <= boost::asio::deadline_timer::traits_type::now()) {
+        close();
+    }
+}
+
+void Connection::close() {
+    boost::system::error_code ignored;
+    timer_.cancel(ignored);
+    socket_.shutdown(tcp::socket::shutdown_both, ignored);
+    socket_.close(ignored);
+}
@@ -0,0 +1,87 @@
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include "request_handler.h"
+#include "request_parser.h"
+#include <boost/asio.hpp>
+#include <memory>
+#include <string>
+
+class Webserver;
+
+// Represents a single client connection. All I/O is asynchronous on the
+// server's shared io_service, so a connection only occupies a worker thread
+// while one of its handlers is running. Each pending operation holds a
+// shared_ptr to the connection, which is destroyed once nothing is pending.
+//
+// Requests are framed rather than read in a single chunk: the connection
+// keeps reading into a growable buffer (taken from the server's BufferPool)
+// and feeding it to a RequestParser until it has the full head, then exactly
+// Content-Length bytes of body. Anything read past the end of a request is
+// kept for the next one. Heads larger than max_header_size and bodies larger
+// than max_body_size are rejected.
+//
+// Each response is sent as its serialized head plus the body in a single
+// vectored write, so the body is never copied into an output buffer. A file
+// body is sent after the head with sendfile(), with the socket corked so the
+// head and the start of the file share packets.
+//
+// Connections are persistent: after each response the connection waits for
+// another request until it is idle for keepalive_timeout seconds, has served
+// keepalive_requests requests, or either side asks to close it.
+//
+// Usage:
+//   std::shared_ptr<Connection> conn(new Connection(io_service, server));
+//   acceptor.async_accept(conn->socket(), ...);
+//   conn->start();
+class Connection : public std::enable_shared_from_this<Connection> {
+ public:
+    Connection(boost::asio::io_service& io_service, Webserver& server);
+    ~Connection();
+
+    boost::asio::ip::tcp::socket& socket();
+
+    // Begins reading the first request from the socket.
+    void start();
+
+    // Returns true if the client wants the connection kept open after
+    // responding to the given request.
+    static bool wants_keep_alive(const Request& req);
+
+ private:
+    void do_read();
+    void handle_read(const boost::system::error_code& error, size_t bytes_transferred);
+    void process_buffer();
+    void handle_request(size_t request_length);
+    void send_error(Response::ResponseCode code);
+    void write_response(Response& resp, boost::string_ref version);
+    void handle_write(const boost::system::error_code& error, size_t bytes_transferred);
+    // Sends the rest of the response's file body, waiting whenever the
+    // socket's send buffer is full.
+    void send_file(const boost::system::error_code& error);
+    void set_cork(bool cork);
+    void handle_timeout(const boost::system::error_code& error);
+    void close();
+
+    boost::asio::ip::tcp::socket socket_;
+    // Serializes the read/write handlers with the idle timer.
+    boost::asio::io_service::strand strand_;
+    boost::asio::deadline_timer timer_;
+    Webserver& server_;
+
+    // Receive buffer. Only the first buffered_ bytes hold data.
+    std::string buffer_;
+    size_t buffered_;
+    // Parses the request at the front of the buffer.
+    RequestParser parser_;
+
+    // The response being written, and its serialized head.
+    Response response_;
+    std::string head_;
+    // How much of the response's file body has been sent.
+    size_t file_sent_;
+    size_t requests_served_;
+    bool keep_alive_;
+};
+
+#endif  // CONNECTION_H
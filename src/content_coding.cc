@@ -0,0 +1,70 @@
+#include "content_coding.h"
+#include "header_map.h"
+
+namespace content_coding {
+namespace {
+
+void skip_spaces(boost::string_ref* s) {
+    while (!s->empty() && (s->front() == ' ' || s->front() == '\t')) {
+        s->remove_prefix(1);
+    }
+}
+
+// Whether the parameters of a coding, such as ";q=0.5", leave it acceptable.
+// Only a q-value of zero ("0", "0.0", "0.000") rules it out.
+bool acceptable(boost::string_ref parameters) {
+    while (!parameters.empty()) {
+        parameters.remove_prefix(1);
+        skip_spaces(&parameters);
+        size_t end = parameters.find(';');
+        boost::string_ref parameter = parameters.substr(0, end);
+        parameters = end == boost::string_ref::npos ? boost::string_ref() : parameters.substr(end);
+
+        if (parameter.size() < 2 || !header_names::equals(parameter.substr(0, 2), "q=")) {
+            continue;
+        }
+        parameter.remove_prefix(2);
+        while (!parameter.empty() && (parameter.back() == ' ' || parameter.back() == '\t')) {
+            parameter.remove_suffix(1);
+        }
+        if (parameter.empty() || parameter.front() != '0') {
+            return true;
+        }
+        return parameter.find_first_not_of("0.") != boost::string_ref::npos;
+    }
+    return true;
+}
+
+}  // namespace
+
+bool accepts(const boost::string_ref* header, boost::string_ref coding) {
+    if (!header) {
+        return false;
+    }
+
+    boost::string_ref codings = *header;
+    bool wildcard = false;
+    while (!codings.empty()) {
+        size_t end = codings.find(',');
+        boost::string_ref item = codings.substr(0, end);
+        codings = end == boost::string_ref::npos ? boost::string_ref() : codings.substr(end + 1);
+
+        skip_spaces(&item);
+        size_t parameters = item.find(';');
+        boost::string_ref name = item.substr(0, parameters);
+        while (!name.empty() && (name.back() == ' ' || name.back() == '\t')) {
+            name.remove_suffix(1);
+        }
+        bool ok = parameters == boost::string_ref::npos || acceptable(item.substr(parameters));
+
+        if (header_names::equals(name, coding)) {
+            return ok;
+        }
+        if (name == "*") {
+            wildcard = ok;
+        }
+    }
+    return wildcard;
+}
+
+}  // namespace content_coding
@@ -0,0 +1,17 @@
+#ifndef CONTENT_CODING_H
+#define CONTENT_CODING_H
+
+#include <boost/utility/string_ref.hpp>
+
+// Negotiation of content codings such as gzip against a request's
+// Accept-Encoding header (RFC 7231 section 5.3.4).
+namespace content_coding {
+
+// Whether a client that sent header accepts coding: it is listed, or "*" is
+// and coding isn't, with a nonzero q-value. A missing header (nullptr)
+// accepts no codings, so uncompressed content is always safe.
+bool accepts(const boost::string_ref* header, boost::string_ref coding);
+
+}  // namespace content_coding
+
+#endif  // CONTENT_CODING_H
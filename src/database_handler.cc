@@ -79,7 +79,7 @@ RequestHandler::Status DatabaseHandler::HandleRequest(const Request& request, Re
             return RequestHandler::Status::DATABASE_ERROR;
         } else {
             // Parse query from URI request
-            std::string query = ExtractQuery(request.uri());
+            std::string query = ExtractQuery(request.uri().to_string());
             if (query == "") {
                 // No query found in URI
                 std::cerr << PARAM_ERROR << std::endl << std::endl;
@@ -0,0 +1,264 @@
+#include "delimiter_scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DELIMITER_SCAN_X86 1
+#endif
+
+namespace delimiter_scan {
+namespace {
+
+bool is_control(unsigned char c) {
+    return (c < 0x20 && c != '\t') || c == 0x7f;
+}
+
+const char* scalar_find_control(const char* begin, const char* end) {
+    for (; begin < end; begin++) {
+        if (is_control(*begin)) {
+            break;
+        }
+    }
+    return begin;
+}
+
+const char* scalar_find_space_or_control(const char* begin, const char* end) {
+    for (; begin < end; begin++) {
+        if (*begin == ' ' || is_control(*begin)) {
+            break;
+        }
+    }
+    return begin;
+}
+
+const char* scalar_find_char(const char* begin, const char* end, char c) {
+    for (; begin < end; begin++) {
+        if (*begin == c) {
+            break;
+        }
+    }
+    return begin;
+}
+
+struct Kernels {
+    const char* (*find_control)(const char*, const char*);
+    const char* (*find_space_or_control)(const char*, const char*);
+    const char* (*find_char)(const char*, const char*, char);
+};
+
+const Kernels scalar_kernels = {
+    scalar_find_control, scalar_find_space_or_control, scalar_find_char
+};
+
+}  // namespace
+}  // namespace delimiter_scan
+
+#ifdef DELIMITER_SCAN_X86
+
+#include <immintrin.h>
+
+// Each kernel family is compiled for its own instruction set only: the
+// SSE4.2 kernels run on CPUs without AVX2, and the rest of the server on CPUs
+// with neither.
+#pragma GCC push_options
+#pragma GCC target("sse4.2")
+
+namespace delimiter_scan {
+namespace {
+
+// Byte ranges for _mm_cmpestri: everything below space except tab, and DEL.
+const char control_ranges[16] = "\x00\x08\x0a\x1f\x7f\x7f";
+const char space_or_control_ranges[16] = "\x00\x08\x0a\x1f\x7f\x7f  ";
+
+const char* sse42_find_ranges(const char* begin, const char* end, const char* ranges, int num_ranges) {
+    const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ranges));
+
+    for (; end - begin >= 16; begin += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        int index = _mm_cmpestri(r, num_ranges, v, 16,
+                                 _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_POSITIVE_POLARITY);
+        if (index != 16) {
+            return begin + index;
+        }
+    }
+    return nullptr;
+}
+
+const char* sse42_find_control(const char* begin, const char* end) {
+    const char* found = sse42_find_ranges(begin, end, control_ranges, 6);
+    return found ? found : scalar_find_control(begin + (end - begin) / 16 * 16, end);
+}
+
+const char* sse42_find_space_or_control(const char* begin, const char* end) {
+    const char* found = sse42_find_ranges(begin, end, space_or_control_ranges, 8);
+    return found ? found : scalar_find_space_or_control(begin + (end - begin) / 16 * 16, end);
+}
+
+const char* sse42_find_char(const char* begin, const char* end, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+
+    for (; end - begin >= 16; begin += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+        if (mask) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+    return scalar_find_char(begin, end, c);
+}
+
+}  // namespace
+}  // namespace delimiter_scan
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+namespace delimiter_scan {
+namespace {
+
+// Marks bytes that are control characters other than tab.
+__m256i avx2_control_mask(__m256i v) {
+    const __m256i below_space = _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1f)), v);
+    const __m256i tab = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'));
+    const __m256i del = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f));
+    return _mm256_or_si256(_mm256_andnot_si256(tab, below_space), del);
+}
+
+const char* avx2_find_control(const char* begin, const char* end) {
+    for (; end - begin >= 32; begin += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        unsigned mask = _mm256_movemask_epi8(avx2_control_mask(v));
+        if (mask) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+    return sse42_find_control(begin, end);
+}
+
+const char* avx2_find_space_or_control(const char* begin, const char* end) {
+    const __m256i space = _mm256_set1_epi8(' ');
+
+    for (; end - begin >= 32; begin += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        __m256i match = _mm256_or_si256(avx2_control_mask(v), _mm256_cmpeq_epi8(v, space));
+        unsigned mask = _mm256_movemask_epi8(match);
+        if (mask) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+    return sse42_find_space_or_control(begin, end);
+}
+
+const char* avx2_find_char(const char* begin, const char* end, char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+
+    for (; end - begin >= 32; begin += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle));
+        if (mask) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+    return sse42_find_char(begin, end, c);
+}
+
+}  // namespace
+}  // namespace delimiter_scan
+
+#pragma GCC pop_options
+
+#endif  // DELIMITER_SCAN_X86
+
+namespace delimiter_scan {
+namespace {
+
+#ifdef DELIMITER_SCAN_X86
+const Kernels sse42_kernels = {
+    sse42_find_control, sse42_find_space_or_control, sse42_find_char
+};
+
+const Kernels avx2_kernels = {
+    avx2_find_control, avx2_find_space_or_control, avx2_find_char
+};
+#endif
+
+bool supported(Kernel kernel) {
+#ifdef DELIMITER_SCAN_X86
+    __builtin_cpu_init();
+    switch (kernel) {
+        case SCALAR:
+            return true;
+        case SSE42:
+            return __builtin_cpu_supports("sse4.2");
+        case AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.2");
+    }
+    return false;
+#else
+    return kernel == SCALAR;
+#endif
+}
+
+const Kernels& kernels_for(Kernel kernel) {
+#ifdef DELIMITER_SCAN_X86
+    if (kernel == AVX2) {
+        return avx2_kernels;
+    }
+    if (kernel == SSE42) {
+        return sse42_kernels;
+    }
+#endif
+    return scalar_kernels;
+}
+
+// Starts out scalar so scans during static initialization are safe, then
+// switches to the best kernel before main() runs.
+Kernel active_kernel = SCALAR;
+const Kernels* active = &scalar_kernels;
+
+struct Dispatcher {
+    Dispatcher() {
+        use_kernel(best_kernel());
+    }
+};
+
+const Dispatcher dispatcher;
+
+}  // namespace
+
+const char* find_control(const char* begin, const char* end) {
+    return active->find_control(begin, end);
+}
+
+const char* find_space_or_control(const char* begin, const char* end) {
+    return active->find_space_or_control(begin, end);
+}
+
+const char* find_char(const char* begin, const char* end, char c) {
+    return active->find_char(begin, end, c);
+}
+
+Kernel best_kernel() {
+    if (supported(AVX2)) {
+        return AVX2;
+    }
+    if (supported(SSE42)) {
+        return SSE42;
+    }
+    return SCALAR;
+}
+
+Kernel kernel() {
+    return active_kernel;
+}
+
+bool use_kernel(Kernel kernel) {
+    if (!supported(kernel)) {
+        return false;
+    }
+    active_kernel = kernel;
+    active = &kernels_for(kernel);
+    return true;
+}
+
+}  // namespace delimiter_scan
@@ -0,0 +1,39 @@
+#ifndef DELIMITER_SCAN_H
+#define DELIMITER_SCAN_H
+
+#include <cstddef>
+
+// Vectorized searches for the delimiters that end HTTP header fields, shared
+// by RequestParser and Response::Parse. On x86 the fastest kernel the CPU
+// supports (AVX2, then SSE4.2) is picked at startup, falling back to plain
+// byte-by-byte loops elsewhere. Every kernel returns exactly what the scalar
+// one does.
+//
+// Each function searches [begin, end) and returns a pointer to the first
+// match, or end if there is none.
+namespace delimiter_scan {
+
+enum Kernel {
+    SCALAR,
+    SSE42,
+    AVX2
+};
+
+// Control characters other than horizontal tab, which end a header value.
+const char* find_control(const char* begin, const char* end);
+// Spaces and control characters other than tab, which end a request target.
+const char* find_space_or_control(const char* begin, const char* end);
+// A single byte, such as '\n' or ':'.
+const char* find_char(const char* begin, const char* end, char c);
+
+// The best kernel this CPU supports.
+Kernel best_kernel();
+// The kernel currently in use.
+Kernel kernel();
+// Switches kernels, for tests and benchmarks. Returns false, without
+// switching, if the CPU doesn't support the kernel.
+bool use_kernel(Kernel kernel);
+
+}  // namespace delimiter_scan
+
+#endif  // DELIMITER_SCAN_H
@@ -7,10 +7,10 @@ RequestHandler::Status EchoHandler::Init(const std::string& uri_prefix, const Ng
 
 // TODO: Implement
 RequestHandler::Status EchoHandler::HandleRequest(const Request& request, Response* response) {
-    std::string raw_request = request.raw_request();
+    boost::string_ref raw_request = request.raw_request();
     response->SetStatus(Response::ResponseCode::OK);
     response->AddHeader("Content-Type", "text/plain");
     response->AddHeader("Content-Length", std::to_string(raw_request.length()));
-    response->SetBody(raw_request);
+    response->SetBody(raw_request.to_string());
     return RequestHandler::Status::OK;
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "file_body.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+
+std::shared_ptr<const FileBody> FileBody::Open(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+    return std::make_shared<FileBody>(fd, st.st_size);
+}
+
+FileBody::FileBody(int fd, size_t length) : fd_(fd), length_(length) {
+}
+
+FileBody::~FileBody() {
+    close(fd_);
+}
+
+int FileBody::fd() const {
+    return fd_;
+}
+
+size_t FileBody::length() const {
+    return length_;
+}
+
+std::string FileBody::Read() const {
+    return Read(0, length_);
+}
+
+std::string FileBody::Read(size_t offset, size_t length) const {
+    std::string contents(length, '\0');
+    size_t done = 0;
+    while (done < length) {
+        ssize_t count = pread(fd_, &contents[done], length - done, offset + done);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        done += count;
+    }
+    contents.resize(done);
+    return contents;
+}
@@ -0,0 +1,40 @@
+#ifndef FILE_BODY_H
+#define FILE_BODY_H
+
+#include <sys/types.h>
+#include <memory>
+#include <string>
+
+// An open file used as a response body. The connection sends it straight
+// from the page cache with sendfile(), so a file of any size is served
+// without being read into memory. The file is closed when the last
+// response holding it is destroyed.
+//
+// Usage:
+//   std::shared_ptr<const FileBody> file = FileBody::Open(path);
+//   if (file) response->SetFileBody(file);
+class FileBody {
+ public:
+    // Opens a regular file, or returns nullptr.
+    static std::shared_ptr<const FileBody> Open(const std::string& path);
+
+    // Takes ownership of fd. length is the number of bytes to send.
+    FileBody(int fd, size_t length);
+    ~FileBody();
+
+    FileBody(const FileBody&) = delete;
+    FileBody& operator=(const FileBody&) = delete;
+
+    int fd() const;
+    size_t length() const;
+    // Reads the whole body, or length bytes from offset, into memory, for
+    // where sendfile() can't be used.
+    std::string Read() const;
+    std::string Read(size_t offset, size_t length) const;
+
+ private:
+    int fd_;
+    size_t length_;
+};
+
+#endif  // FILE_BODY_H
@@ -0,0 +1,175 @@
+#include "file_cache.h"
+#include "server_status_tracker.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <utility>
+
+FileCache& FileCache::GetInstance() {
+    static FileCache instance;
+    return instance;
+}
+
+FileCache::FileCache(size_t capacity) : capacity_(capacity), size_(0) {
+}
+
+FileCache::Contents FileCache::get(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+        Contents contents = find(path, st);
+        if (contents) {
+            return contents;
+        }
+    }
+
+    // Read outside the lock so other lookups aren't held up by the disk.
+    ServerStatusTracker::GetInstance().RecordFileCacheMiss();
+    Entry entry;
+    entry.path = path;
+    if (!read_file(path, &entry)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        erase(path);
+        return nullptr;
+    }
+    return insert(std::move(entry));
+}
+
+FileCache::Contents FileCache::get(const std::string& path, const FileBody& file, const struct stat& st) {
+    Contents contents = find(path, st);
+    if (contents) {
+        return contents;
+    }
+
+    ServerStatusTracker::GetInstance().RecordFileCacheMiss();
+    Entry entry;
+    entry.path = path;
+    entry.contents = std::make_shared<const std::string>(file.Read());
+    entry.mtime = st.st_mtim;
+    entry.size = st.st_size;
+    entry.inode = st.st_ino;
+    return insert(std::move(entry));
+}
+
+FileCache::Contents FileCache::find(const std::string& path, const struct stat& st) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = index_.find(path);
+    if (found == index_.end() || !matches(*found->second, st)) {
+        return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, found->second);
+    ServerStatusTracker::GetInstance().RecordFileCacheHit();
+    return found->second->contents;
+}
+
+FileCache::Contents FileCache::insert(Entry&& entry) {
+    Contents contents = entry.contents;
+    std::lock_guard<std::mutex> lock(mutex_);
+    erase(entry.path);
+    if (contents->size() > capacity_ / 8) {
+        return contents;
+    }
+
+    size_ += contents->size();
+    std::string path = entry.path;
+    entries_.push_front(std::move(entry));
+    index_[path] = entries_.begin();
+    evict();
+
+    return contents;
+}
+
+void FileCache::erase(const std::string& path) {
+    auto found = index_.find(path);
+    if (found != index_.end()) {
+        size_ -= found->second->contents->size();
+        entries_.erase(found->second);
+        index_.erase(found);
+    }
+}
+
+void FileCache::set_capacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    evict();
+}
+
+size_t FileCache::capacity() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+}
+
+size_t FileCache::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+size_t FileCache::num_entries() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void FileCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+    size_ = 0;
+}
+
+bool FileCache::matches(const Entry& entry, const struct stat& st) {
+    return entry.mtime.tv_sec == st.st_mtim.tv_sec && entry.mtime.tv_nsec == st.st_mtim.tv_nsec &&
+           entry.size == st.st_size && entry.inode == st.st_ino;
+}
+
+bool FileCache::read_file(const std::string& path, Entry* entry) {
+    // Validate against the file that was actually opened.
+    struct stat st;
+    Contents contents = read(path, &st);
+    if (!contents) {
+        return false;
+    }
+
+    entry->contents = contents;
+    entry->mtime = st.st_mtim;
+    entry->size = st.st_size;
+    entry->inode = st.st_ino;
+    return true;
+}
+
+FileCache::Contents FileCache::read(const std::string& path, struct stat* st) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    if (fstat(fd, st) != 0 || !S_ISREG(st->st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+
+    std::shared_ptr<std::string> contents = std::make_shared<std::string>(st->st_size, '\0');
+    size_t length = 0;
+    while (length < contents->size()) {
+        ssize_t count = ::read(fd, &(*contents)[length], contents->size() - length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        length += count;
+    }
+    close(fd);
+
+    // The file shrank while it was being read.
+    contents->resize(length);
+    return contents;
+}
+
+void FileCache::evict() {
+    while (size_ > capacity_ && !entries_.empty()) {
+        size_ -= entries_.back().contents->size();
+        index_.erase(entries_.back().path);
+        entries_.pop_back();
+        ServerStatusTracker::GetInstance().RecordFileCacheEviction();
+    }
+}
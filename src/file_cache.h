@@ -0,0 +1,88 @@
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include "file_body.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+const size_t DEFAULT_FILE_CACHE_SIZE = 64 * 1024 * 1024;
+
+// Thread-safe, memory-bounded LRU cache of file contents keyed by path, shared
+// by every StaticFileHandler. Contents are immutable and shared, so a response
+// can keep sending a body after it has been evicted or replaced.
+//
+// Every lookup revalidates the cached copy with a stat() of the path; if the
+// modification time, size or inode changed, the file is read again. Files
+// bigger than an eighth of the capacity are read but not cached, so one large
+// file can't flush everything else. Hits, misses and evictions are counted in
+// ServerStatusTracker.
+//
+// Usage:
+//   FileCache::Contents contents = FileCache::GetInstance().get(path);
+//   if (contents) response->SetBody(contents);
+class FileCache {
+ public:
+    using Contents = std::shared_ptr<const std::string>;
+
+    // The cache shared by the server's handlers.
+    static FileCache& GetInstance();
+
+    explicit FileCache(size_t capacity = DEFAULT_FILE_CACHE_SIZE);
+
+    // Returns the contents of the regular file at path, or nullptr if it
+    // can't be read.
+    Contents get(const std::string& path);
+    // Like get(), but trusts st as the file's current stat and reads from the
+    // already open file on a miss.
+    Contents get(const std::string& path, const FileBody& file, const struct stat& st);
+
+    // Reads the regular file at path without caching it, filling in the
+    // stat of the file actually read. Returns nullptr if it can't be read.
+    static Contents read(const std::string& path, struct stat* st);
+
+    // Limits the total size of cached contents, evicting as needed. 0
+    // disables caching.
+    void set_capacity(size_t capacity);
+    size_t capacity();
+    // Bytes of contents cached.
+    size_t size();
+    size_t num_entries();
+    void clear();
+
+ private:
+    struct Entry {
+        std::string path;
+        Contents contents;
+        struct timespec mtime;
+        off_t size;
+        ino_t inode;
+    };
+
+    static bool matches(const Entry& entry, const struct stat& st);
+    // The cached contents of path if they match st, or nullptr.
+    Contents find(const std::string& path, const struct stat& st);
+    // Caches a freshly read entry, if it isn't too big, and returns its
+    // contents.
+    Contents insert(Entry&& entry);
+    // Drops path's entry. The mutex must be held.
+    void erase(const std::string& path);
+    // Reads the file, filling in everything but entry->path.
+    static bool read_file(const std::string& path, Entry* entry);
+    // Drops least recently used entries until size_ fits capacity_.
+    void evict();
+
+    std::mutex mutex_;
+    size_t capacity_;
+    size_t size_;
+    // Most recently used first.
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+#endif  // FILE_CACHE_H
@@ -0,0 +1,41 @@
+#include "handler_table.h"
+
+HandlerTable::~HandlerTable() {
+    for (auto& handler : handler_map_) {
+        delete handler.second;
+    }
+}
+
+bool HandlerTable::add(const std::string& uri_prefix, RequestHandler* handler, const std::string& handler_name) {
+    if (!handler_map_.insert(std::make_pair(uri_prefix, handler)).second) {
+        delete handler;
+        return false;
+    }
+    mappings_.push_back(std::make_pair(uri_prefix, handler_name));
+    return true;
+}
+
+void HandlerTable::compile() {
+    routes_ = RouteTrie(RouteTrie::Routes(handler_map_.begin(), handler_map_.end()));
+}
+
+RequestHandler* HandlerTable::find(boost::string_ref uri) const {
+    RequestHandler* handler = routes_.find_exact(uri);
+    if (!handler) {
+        handler = routes_.find_longest_prefix(uri);
+    }
+    if (!handler) {
+        handler = routes_.find_exact("default");
+    }
+    return handler;
+}
+
+std::string HandlerTable::find_prefix(boost::string_ref uri) const {
+    boost::string_ref longest;
+    routes_.find_longest_prefix(uri, &longest);
+    return longest.to_string();
+}
+
+const ServerStatusTracker::HandlerList& HandlerTable::mappings() const {
+    return mappings_;
+}
@@ -0,0 +1,44 @@
+#ifndef HANDLER_TABLE_H
+#define HANDLER_TABLE_H
+
+#include "request_handler.h"
+#include "route_trie.h"
+#include "server_status_tracker.h"
+#include <boost/utility/string_ref.hpp>
+#include <string>
+#include <unordered_map>
+
+// The handlers created for one loaded config and the routes to them. A table
+// is filled in by Webserver::load_configs, then never changed: requests share
+// it read-only through a std::shared_ptr, and a config reload swaps in a new
+// table. The table owns its handlers and deletes them once the last request
+// holding it has finished.
+class HandlerTable {
+ public:
+    HandlerTable() = default;
+    ~HandlerTable();
+
+    HandlerTable(const HandlerTable&) = delete;
+    HandlerTable& operator=(const HandlerTable&) = delete;
+
+    // Takes ownership of handler. Returns false, and deletes the handler, if
+    // uri_prefix is already mapped.
+    bool add(const std::string& uri_prefix, RequestHandler* handler, const std::string& handler_name);
+    // Compiles the routes. Call once every handler has been added.
+    void compile();
+
+    // The handler for uri: an exact match, then the longest matching prefix,
+    // then the default. Returns nullptr if there is none.
+    RequestHandler* find(boost::string_ref uri) const;
+    // The longest route that is a prefix of uri, or "".
+    std::string find_prefix(boost::string_ref uri) const;
+    // (prefix, handler name) of each handler, in config order.
+    const ServerStatusTracker::HandlerList& mappings() const;
+
+ private:
+    std::unordered_map<std::string, RequestHandler*> handler_map_;
+    ServerStatusTracker::HandlerList mappings_;
+    RouteTrie routes_;
+};
+
+#endif  // HANDLER_TABLE_H
@@ -0,0 +1,111 @@
+#include "header_map.h"
+
+namespace header_names {
+namespace {
+
+const char* const names[NUM_NAMES] = {
+    "Accept",
+    "Accept-Encoding",
+    "Accept-Language",
+    "Accept-Ranges",
+    "Authorization",
+    "Cache-Control",
+    "Connection",
+    "Content-Encoding",
+    "Content-Length",
+    "Content-Range",
+    "Content-Type",
+    "Cookie",
+    "Date",
+    "ETag",
+    "Host",
+    "If-Modified-Since",
+    "If-None-Match",
+    "If-Range",
+    "Keep-Alive",
+    "Last-Modified",
+    "Location",
+    "Range",
+    "Referer",
+    "Server",
+    "Set-Cookie",
+    "Transfer-Encoding",
+    "User-Agent",
+    "Vary",
+};
+
+char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+// Open-addressed table from name hash to Id, a quarter full.
+const size_t TABLE_SIZE = 128;
+
+struct InternTable {
+    Id slots[TABLE_SIZE];
+    boost::string_ref spellings[NUM_NAMES];
+
+    InternTable() {
+        for (size_t i = 0; i < TABLE_SIZE; i++) {
+            slots[i] = OTHER;
+        }
+        for (int id = 0; id < NUM_NAMES; id++) {
+            spellings[id] = names[id];
+            size_t slot = hash(names[id]) & (TABLE_SIZE - 1);
+            while (slots[slot] != OTHER) {
+                slot = (slot + 1) & (TABLE_SIZE - 1);
+            }
+            slots[slot] = static_cast<Id>(id);
+        }
+    }
+};
+
+const InternTable& table() {
+    static const InternTable table;
+    return table;
+}
+
+}  // namespace
+
+uint32_t hash(boost::string_ref name) {
+    // FNV-1a over the lowercased name.
+    uint32_t h = 2166136261u;
+    for (char c : name) {
+        h = (h ^ static_cast<unsigned char>(to_lower(c))) * 16777619u;
+    }
+    return h;
+}
+
+bool equals(boost::string_ref a, boost::string_ref b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (to_lower(a[i]) != to_lower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Id intern(boost::string_ref name, uint32_t name_hash) {
+    const InternTable& t = table();
+    for (size_t slot = name_hash & (TABLE_SIZE - 1); t.slots[slot] != OTHER;
+         slot = (slot + 1) & (TABLE_SIZE - 1)) {
+        Id id = t.slots[slot];
+        if (equals(name, t.spellings[id])) {
+            return id;
+        }
+    }
+    return OTHER;
+}
+
+Id intern(boost::string_ref name) {
+    return intern(name, hash(name));
+}
+
+boost::string_ref canonical(Id id) {
+    return id < NUM_NAMES ? table().spellings[id] : boost::string_ref();
+}
+
+}  // namespace header_names
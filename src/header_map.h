@@ -0,0 +1,267 @@
+#ifndef HEADER_MAP_H
+#define HEADER_MAP_H
+
+#include <boost/utility/string_ref.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Interned names of the headers the server commonly reads or writes. Looking
+// one of these up in a HeaderMap is a single array access.
+namespace header_names {
+
+enum Id {
+    ACCEPT,
+    ACCEPT_ENCODING,
+    ACCEPT_LANGUAGE,
+    ACCEPT_RANGES,
+    AUTHORIZATION,
+    CACHE_CONTROL,
+    CONNECTION,
+    CONTENT_ENCODING,
+    CONTENT_LENGTH,
+    CONTENT_RANGE,
+    CONTENT_TYPE,
+    COOKIE,
+    DATE,
+    ETAG,
+    HOST,
+    IF_MODIFIED_SINCE,
+    IF_NONE_MATCH,
+    IF_RANGE,
+    KEEP_ALIVE,
+    LAST_MODIFIED,
+    LOCATION,
+    RANGE,
+    REFERER,
+    SERVER,
+    SET_COOKIE,
+    TRANSFER_ENCODING,
+    USER_AGENT,
+    VARY,
+    NUM_NAMES,
+    // Any other name.
+    OTHER = NUM_NAMES
+};
+
+// Case-insensitive hash of a header name.
+uint32_t hash(boost::string_ref name);
+// Case-insensitive (ASCII only, without locales) comparison of two names.
+bool equals(boost::string_ref a, boost::string_ref b);
+// Returns the Id of a header name, ignoring case, or OTHER.
+Id intern(boost::string_ref name, uint32_t name_hash);
+Id intern(boost::string_ref name);
+// The canonical spelling of an interned name.
+boost::string_ref canonical(Id id);
+
+}  // namespace header_names
+
+// Header fields in insertion order, with case-insensitive lookup by name.
+// Lookups of interned names go through a fixed table of first positions;
+// other names are found through a hash index that is only built the first
+// time one is looked up. Repeated headers keep every value, and find()
+// returns the first.
+//
+// String is std::string for headers the map owns, or boost::string_ref for
+// views into a buffer (as in Request).
+//
+// Usage:
+//   HeaderMap headers;
+//   headers.add("Content-Type", "text/html");
+//   const std::string* type = headers.find("content-type");
+//   for (auto& header : headers) { header.first, header.second }
+template <typename String>
+class BasicHeaderMap {
+ public:
+    // An entry is a (name, value) pair plus its interned name and hash.
+    struct Entry : std::pair<String, String> {
+        Entry(String name, String value, header_names::Id id, uint32_t name_hash)
+            : std::pair<String, String>(std::move(name), std::move(value)),
+              id(id), name_hash(name_hash) {
+        }
+
+        header_names::Id id;
+        uint32_t name_hash;
+    };
+
+    using const_iterator = typename std::vector<Entry>::const_iterator;
+
+    BasicHeaderMap() {
+        clear_positions();
+    }
+
+    void add(String name, String value) {
+        uint32_t name_hash = header_names::hash(name);
+        header_names::Id id = header_names::intern(name, name_hash);
+
+        if (id != header_names::OTHER && first_[id] == NONE) {
+            first_[id] = entries_.size();
+        }
+        entries_.push_back(Entry(std::move(name), std::move(value), id, name_hash));
+        index_.clear();
+    }
+
+    // Replaces every value of the header with one, keeping the position of
+    // the first, or adds it if missing.
+    void set(String name, String value) {
+        size_t position = position_of(name);
+        if (position == NONE) {
+            add(std::move(name), std::move(value));
+            return;
+        }
+
+        entries_[position].second = std::move(value);
+        erase_named(position, true);
+    }
+
+    // Removes every value of the header. Returns how many were removed.
+    size_t remove(boost::string_ref name) {
+        size_t position = position_of(name);
+        if (position == NONE) {
+            return 0;
+        }
+
+        size_t before = entries_.size();
+        erase_named(position, false);
+        return before - entries_.size();
+    }
+
+    // Returns the first value of the header, or nullptr if it is missing.
+    const String* find(boost::string_ref name) const {
+        size_t position = position_of(name);
+        return position == NONE ? nullptr : &entries_[position].second;
+    }
+
+    bool contains(boost::string_ref name) const {
+        return position_of(name) != NONE;
+    }
+
+    void clear() {
+        entries_.clear();
+        index_.clear();
+        clear_positions();
+    }
+
+    void reserve(size_t size) {
+        entries_.reserve(size);
+    }
+
+    size_t size() const {
+        return entries_.size();
+    }
+
+    bool empty() const {
+        return entries_.empty();
+    }
+
+    const Entry& operator[](size_t i) const {
+        return entries_[i];
+    }
+
+    const_iterator begin() const {
+        return entries_.begin();
+    }
+
+    const_iterator end() const {
+        return entries_.end();
+    }
+
+ private:
+    enum : uint32_t { NONE = UINT32_MAX };
+
+    // Position of the first entry named name, or NONE.
+    size_t position_of(boost::string_ref name) const {
+        uint32_t name_hash = header_names::hash(name);
+        header_names::Id id = header_names::intern(name, name_hash);
+
+        if (id != header_names::OTHER) {
+            return first_[id];
+        }
+
+        if (index_.empty()) {
+            build_index();
+        }
+
+        // Open addressing over the positions of uninterned names.
+        size_t mask = index_.size() - 1;
+        for (size_t slot = name_hash & mask; index_[slot] != NONE; slot = (slot + 1) & mask) {
+            const Entry& entry = entries_[index_[slot]];
+            if (entry.name_hash == name_hash && header_names::equals(entry.first, name)) {
+                return index_[slot];
+            }
+        }
+        return NONE;
+    }
+
+    // Indexes the first entry of each uninterned name, in a table at most
+    // half full so every probe sequence ends at an empty slot.
+    void build_index() const {
+        size_t slots = 4;
+        while (slots < entries_.size() * 2) {
+            slots *= 2;
+        }
+        index_.assign(slots, NONE);
+
+        for (size_t i = 0; i < entries_.size(); i++) {
+            const Entry& entry = entries_[i];
+            if (entry.id != header_names::OTHER) {
+                continue;
+            }
+
+            size_t slot = entry.name_hash & (slots - 1);
+            while (index_[slot] != NONE) {
+                if (entries_[index_[slot]].name_hash == entry.name_hash &&
+                    header_names::equals(entries_[index_[slot]].first, entry.first)) {
+                    break;
+                }
+                slot = (slot + 1) & (slots - 1);
+            }
+            if (index_[slot] == NONE) {
+                index_[slot] = i;
+            }
+        }
+    }
+
+    // Erases the entries named like the one at position, which must be the
+    // first with that name, optionally keeping that one.
+    void erase_named(size_t position, bool keep_first) {
+        const String name = entries_[position].first;
+        const uint32_t name_hash = entries_[position].name_hash;
+
+        auto same_name = [&name, name_hash](const Entry& entry) {
+            return entry.name_hash == name_hash && header_names::equals(entry.first, name);
+        };
+        auto first = entries_.begin() + position + (keep_first ? 1 : 0);
+        entries_.erase(std::remove_if(first, entries_.end(), same_name), entries_.end());
+        rebuild_positions();
+    }
+
+    void clear_positions() {
+        for (size_t i = 0; i < header_names::NUM_NAMES; i++) {
+            first_[i] = NONE;
+        }
+    }
+
+    void rebuild_positions() {
+        clear_positions();
+        index_.clear();
+        for (size_t i = 0; i < entries_.size(); i++) {
+            header_names::Id id = entries_[i].id;
+            if (id != header_names::OTHER && first_[id] == NONE) {
+                first_[id] = i;
+            }
+        }
+    }
+
+    std::vector<Entry> entries_;
+    // Position of the first entry with each interned name.
+    uint32_t first_[header_names::NUM_NAMES];
+    // Lazily built hash index of uninterned names; empty when stale.
+    mutable std::vector<uint32_t> index_;
+};
+
+using HeaderMap = BasicHeaderMap<std::string>;
+
+#endif  // HEADER_MAP_H
@@ -0,0 +1,123 @@
+#include "http_date.h"
+#include <cctype>
+#include <cstdio>
+
+namespace http_date {
+namespace {
+
+const char* const days[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+const char* const months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                              "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+bool literal(boost::string_ref* s, boost::string_ref text) {
+    if (!s->starts_with(text)) {
+        return false;
+    }
+    s->remove_prefix(text.size());
+    return true;
+}
+
+// Reads a day name, which isn't checked against the date.
+bool day_name(boost::string_ref* s) {
+    size_t letters = 0;
+    while (letters < s->size() && isalpha(static_cast<unsigned char>((*s)[letters]))) {
+        letters++;
+    }
+    s->remove_prefix(letters);
+    return letters >= 3;
+}
+
+bool month(boost::string_ref* s, int* value) {
+    for (int i = 0; i < 12; i++) {
+        if (literal(s, months[i])) {
+            *value = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool number(boost::string_ref* s, size_t digits, int* value) {
+    if (s->size() < digits) {
+        return false;
+    }
+    *value = 0;
+    for (size_t i = 0; i < digits; i++) {
+        if ((*s)[i] < '0' || (*s)[i] > '9') {
+            return false;
+        }
+        *value = *value * 10 + ((*s)[i] - '0');
+    }
+    s->remove_prefix(digits);
+    return true;
+}
+
+// "08:49:37"
+bool time_of_day(boost::string_ref* s, struct tm* tm) {
+    return number(s, 2, &tm->tm_hour) && literal(s, ":") && number(s, 2, &tm->tm_min) &&
+           literal(s, ":") && number(s, 2, &tm->tm_sec);
+}
+
+}  // namespace
+
+std::string format(time_t time) {
+    // strftime's names would follow the locale; HTTP needs English ones.
+    struct tm tm;
+    gmtime_r(&time, &tm);
+
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+             days[tm.tm_wday], tm.tm_mday, months[tm.tm_mon], tm.tm_year + 1900,
+             tm.tm_hour, tm.tm_min, tm.tm_sec);
+    return buffer;
+}
+
+bool parse(boost::string_ref date, time_t* time) {
+    struct tm tm = {};
+    int year = 0;
+
+    if (!day_name(&date)) {
+        return false;
+    }
+
+    if (literal(&date, ", ")) {
+        // "Sun, 06 Nov 1994 08:49:37 GMT" or "Sunday, 06-Nov-94 08:49:37 GMT"
+        if (!number(&date, 2, &tm.tm_mday)) {
+            return false;
+        }
+        if (literal(&date, " ")) {
+            if (!month(&date, &tm.tm_mon) || !literal(&date, " ") || !number(&date, 4, &year)) {
+                return false;
+            }
+        } else {
+            if (!literal(&date, "-") || !month(&date, &tm.tm_mon) || !literal(&date, "-") ||
+                !number(&date, 2, &year)) {
+                return false;
+            }
+            year += year < 70 ? 2000 : 1900;
+        }
+        if (!literal(&date, " ") || !time_of_day(&date, &tm) || !literal(&date, " GMT")) {
+            return false;
+        }
+    } else {
+        // "Sun Nov  6 08:49:37 1994"
+        if (!literal(&date, " ") || !month(&date, &tm.tm_mon) || !literal(&date, " ")) {
+            return false;
+        }
+        if (!(literal(&date, " ") ? number(&date, 1, &tm.tm_mday) : number(&date, 2, &tm.tm_mday)) ||
+            !literal(&date, " ") || !time_of_day(&date, &tm) || !literal(&date, " ") ||
+            !number(&date, 4, &year)) {
+            return false;
+        }
+    }
+
+    if (!date.empty() || tm.tm_mday < 1 || tm.tm_mday > 31 || tm.tm_hour > 23 || tm.tm_min > 59 ||
+        tm.tm_sec > 60) {
+        return false;
+    }
+    tm.tm_year = year - 1900;
+    *time = timegm(&tm);
+    return true;
+}
+
+}  // namespace http_date
@@ -0,0 +1,19 @@
+#ifndef HTTP_DATE_H
+#define HTTP_DATE_H
+
+#include <boost/utility/string_ref.hpp>
+#include <time.h>
+#include <string>
+
+// Dates as they appear in HTTP headers (RFC 7231 IMF-fixdate), such as
+// "Sun, 06 Nov 1994 08:49:37 GMT".
+namespace http_date {
+
+std::string format(time_t time);
+// Parses an IMF-fixdate, or one of the obsolete RFC 850 and asctime() forms
+// recipients must also accept. Returns false if date is none of them.
+bool parse(boost::string_ref date, time_t* time);
+
+}  // namespace http_date
+
+#endif  // HTTP_DATE_H
@@ -0,0 +1,203 @@
+#include "markdown_cache.h"
+#include "file_cache.h"
+#include "../cpp-markdown/markdown.h"
+#include <dirent.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Directory levels warm() descends below a root.
+const int MAX_WARM_DEPTH = 16;
+
+// Github styling goes around the rendered document.
+const char PAGE_HEADER[] =
+    "<link rel=\"stylesheet\" href=\"markdown.css\">"
+    "<style>"
+        ".markdown-body {"
+            "box-sizing: border-box;"
+            "min-width: 200px;"
+            "max-width: 980px;"
+            "margin: 0 auto;"
+            "padding: 45px;"
+        "}"
+    "</style>"
+    "<body class=\"markdown-body\">";
+const char PAGE_FOOTER[] = "</body>";
+
+bool has_md_extension(const std::string& name) {
+    return name.size() > 3 && name.compare(name.size() - 3, 3, ".md") == 0;
+}
+
+}  // namespace
+
+MarkdownCache& MarkdownCache::GetInstance() {
+    static MarkdownCache instance;
+    return instance;
+}
+
+MarkdownCache::MarkdownCache(size_t capacity) : capacity_(capacity), size_(0) {
+}
+
+MarkdownCache::Page MarkdownCache::get(const std::string& path, const struct stat& st) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = index_.find(path);
+        if (found != index_.end() && matches(*found->second, st)) {
+            entries_.splice(entries_.begin(), entries_, found->second);
+            return found->second->page;
+        }
+    }
+
+    // Read and render outside the lock; rendering can take a while.
+    Entry entry;
+    struct stat read_st;
+    FileCache::Contents markdown = FileCache::read(path, &read_st);
+    if (!markdown) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = index_.find(path);
+        if (found != index_.end()) {
+            size_ -= found->second->page->size();
+            entries_.erase(found->second);
+            index_.erase(found);
+        }
+        return nullptr;
+    }
+    entry.path = path;
+    entry.page = std::make_shared<const std::string>(render(*markdown));
+    entry.mtime = read_st.st_mtim;
+    entry.size = read_st.st_size;
+    entry.inode = read_st.st_ino;
+
+    Page page = entry.page;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = index_.find(path);
+    if (found != index_.end()) {
+        size_ -= found->second->page->size();
+        entries_.erase(found->second);
+        index_.erase(found);
+    }
+    if (page->size() > capacity_ / 8) {
+        return page;
+    }
+
+    size_ += page->size();
+    entries_.push_front(std::move(entry));
+    index_[path] = entries_.begin();
+    evict();
+
+    return page;
+}
+
+size_t MarkdownCache::warm(const std::string& root) {
+    return warm_directory(root.empty() ? "/" : root, MAX_WARM_DEPTH);
+}
+
+size_t MarkdownCache::warm_directory(const std::string& directory, int depth) {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        return 0;
+    }
+
+    std::string prefix = directory.back() == '/' ? directory : directory + "/";
+    std::vector<std::string> subdirectories;
+    size_t rendered = 0;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.empty() || name[0] == '.') {
+            continue;
+        }
+
+        std::string path = prefix + name;
+        struct stat st;
+        if (lstat(path.c_str(), &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            subdirectories.push_back(path);
+            continue;
+        }
+        if (!has_md_extension(name) || (S_ISLNK(st.st_mode) && stat(path.c_str(), &st) != 0) ||
+            !S_ISREG(st.st_mode)) {
+            continue;
+        }
+
+        // Stop once pages stop fitting, rather than evicting earlier ones.
+        if (!fits(st.st_size)) {
+            closedir(dir);
+            return rendered;
+        }
+        if (get(path, st)) {
+            rendered++;
+        }
+    }
+    closedir(dir);
+
+    if (depth > 0) {
+        for (auto& subdirectory : subdirectories) {
+            rendered += warm_directory(subdirectory, depth - 1);
+        }
+    }
+    return rendered;
+}
+
+std::string MarkdownCache::render(const std::string& markdown) {
+    markdown::Document doc;
+    doc.read(markdown);
+
+    // The page is sized once and written front to back: the header, the
+    // document appended straight into it, then the footer.
+    std::string page;
+    page.reserve(sizeof(PAGE_HEADER) - 1 + doc.estimatedHtmlSize() + sizeof(PAGE_FOOTER) - 1);
+    page.append(PAGE_HEADER, sizeof(PAGE_HEADER) - 1);
+    doc.write(page);
+    page.append(PAGE_FOOTER, sizeof(PAGE_FOOTER) - 1);
+    return page;
+}
+
+void MarkdownCache::set_capacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    evict();
+}
+
+size_t MarkdownCache::capacity() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+}
+
+size_t MarkdownCache::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+size_t MarkdownCache::num_entries() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void MarkdownCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+    size_ = 0;
+}
+
+bool MarkdownCache::matches(const Entry& entry, const struct stat& st) {
+    return entry.mtime.tv_sec == st.st_mtim.tv_sec && entry.mtime.tv_nsec == st.st_mtim.tv_nsec &&
+           entry.size == st.st_size && entry.inode == st.st_ino;
+}
+
+bool MarkdownCache::fits(size_t page_size) {
+    // Pages are usually a little bigger than their markdown.
+    std::lock_guard<std::mutex> lock(mutex_);
+    return page_size <= capacity_ / 8 && size_ + page_size <= capacity_;
+}
+
+void MarkdownCache::evict() {
+    while (size_ > capacity_ && !entries_.empty()) {
+        size_ -= entries_.back().page->size();
+        index_.erase(entries_.back().path);
+        entries_.pop_back();
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef MARKDOWN_CACHE_H
+#define MARKDOWN_CACHE_H
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+const size_t DEFAULT_MARKDOWN_CACHE_SIZE = 16 * 1024 * 1024;
+
+// Thread-safe, memory-bounded LRU cache of markdown files rendered to HTML
+// pages, shared by every StaticFileHandler. Rendering is the expensive part
+// of serving markdown, so each file is rendered once and then served from
+// here until its modification time, size or inode changes.
+//
+// Entries are revalidated against the stat() the caller already made of the
+// file. Pages are immutable and shared, like FileCache contents, so they can
+// be sent without copying and their gzip encodings are memoized.
+//
+// Usage:
+//   MarkdownCache::Page page = MarkdownCache::GetInstance().get(path, st);
+//   if (page) response->SetBody(page);
+class MarkdownCache {
+ public:
+    using Page = std::shared_ptr<const std::string>;
+
+    // The cache shared by the server's handlers.
+    static MarkdownCache& GetInstance();
+
+    explicit MarkdownCache(size_t capacity = DEFAULT_MARKDOWN_CACHE_SIZE);
+
+    // Returns the page for the markdown file at path, whose stat is st, or
+    // nullptr if it can't be read.
+    Page get(const std::string& path, const struct stat& st);
+    // Renders every .md file under root, skipping hidden entries and
+    // symlinked directories, until the cache is full. Returns how many
+    // pages were rendered.
+    size_t warm(const std::string& root);
+
+    // Renders markdown into a page styled with markdown.css.
+    static std::string render(const std::string& markdown);
+
+    // Limits the total size of cached pages, evicting as needed. 0 disables
+    // caching.
+    void set_capacity(size_t capacity);
+    size_t capacity();
+    // Bytes of pages cached.
+    size_t size();
+    size_t num_entries();
+    void clear();
+
+ private:
+    struct Entry {
+        std::string path;
+        Page page;
+        struct timespec mtime;
+        off_t size;
+        ino_t inode;
+    };
+
+    static bool matches(const Entry& entry, const struct stat& st);
+    // Walks a directory for warm(), depth levels deep at most.
+    size_t warm_directory(const std::string& directory, int depth);
+    // Whether a page of this size would be cached.
+    bool fits(size_t page_size);
+    void evict();
+
+    std::mutex mutex_;
+    size_t capacity_;
+    size_t size_;
+    // Most recently used first.
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+#endif  // MARKDOWN_CACHE_H
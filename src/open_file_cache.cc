@@ -0,0 +1,133 @@
+#include "open_file_cache.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <utility>
+
+namespace {
+
+// Whether path stays below the root: relative, with no ".." segments.
+bool is_contained(boost::string_ref path) {
+    if (path.empty() || path.front() == '/') {
+        return false;
+    }
+    while (!path.empty()) {
+        size_t slash = path.find('/');
+        if (path.substr(0, slash) == "..") {
+            return false;
+        }
+        if (slash == boost::string_ref::npos) {
+            break;
+        }
+        path.remove_prefix(slash + 1);
+    }
+    return true;
+}
+
+bool same_file(const struct stat& a, const struct stat& b) {
+    return a.st_ino == b.st_ino && a.st_dev == b.st_dev && a.st_size == b.st_size &&
+           a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+}
+
+}  // namespace
+
+OpenFileCache::OpenFileCache(const std::string& root, size_t ttl_seconds, size_t max_entries)
+    : root_(root.empty() ? "/" : root), ttl_(std::chrono::seconds(ttl_seconds)), max_entries_(max_entries),
+      root_fd_(-1) {
+}
+
+OpenFileCache::~OpenFileCache() {
+    if (root_fd_ >= 0) {
+        close(root_fd_);
+    }
+}
+
+bool OpenFileCache::open(boost::string_ref path, File* file) {
+    if (!is_contained(path)) {
+        return false;
+    }
+    std::string key = path.to_string();
+    if (max_entries_ == 0) {
+        return open_uncached(key, file);
+    }
+
+    Clock::time_point now = Clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto found = index_.find(key);
+    if (found != index_.end()) {
+        Entry& entry = *found->second;
+        entries_.splice(entries_.begin(), entries_, found->second);
+        if (now < entry.expires) {
+            *file = entry.file;
+            return file->body != nullptr;
+        }
+
+        // Expired: keep the open file if the path still names it unchanged.
+        struct stat st;
+        int fd = root_fd();
+        if (entry.file.body && fd >= 0 && fstatat(fd, key.c_str(), &st, 0) == 0 &&
+            same_file(st, entry.file.st)) {
+            entry.expires = now + ttl_;
+            *file = entry.file;
+            return true;
+        }
+    }
+    lock.unlock();
+
+    // Open outside the lock so other lookups aren't held up by the disk.
+    Entry entry;
+    entry.path = key;
+    if (!open_uncached(key, &entry.file)) {
+        entry.file = File();
+    }
+    entry.expires = now + ttl_;
+    *file = entry.file;
+
+    lock.lock();
+    found = index_.find(key);
+    if (found != index_.end()) {
+        entries_.erase(found->second);
+        index_.erase(found);
+    }
+    entries_.push_front(std::move(entry));
+    index_[key] = entries_.begin();
+    while (entries_.size() > max_entries_) {
+        index_.erase(entries_.back().path);
+        entries_.pop_back();
+    }
+    return file->body != nullptr;
+}
+
+size_t OpenFileCache::num_entries() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+bool OpenFileCache::open_uncached(const std::string& path, File* file) {
+    int dir_fd;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dir_fd = root_fd();
+    }
+    if (dir_fd < 0) {
+        return false;
+    }
+
+    int fd = openat(dir_fd, path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    if (fstat(fd, &file->st) != 0 || !S_ISREG(file->st.st_mode)) {
+        close(fd);
+        return false;
+    }
+    file->body = std::make_shared<FileBody>(fd, file->st.st_size);
+    return true;
+}
+
+int OpenFileCache::root_fd() {
+    // A root that doesn't exist yet is looked for again on every miss.
+    if (root_fd_ < 0) {
+        root_fd_ = ::open(root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    return root_fd_;
+}
@@ -0,0 +1,79 @@
+#ifndef OPEN_FILE_CACHE_H
+#define OPEN_FILE_CACHE_H
+
+#include "file_body.h"
+#include <boost/utility/string_ref.hpp>
+#include <sys/stat.h>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Defaults for each StaticFileHandler's open file cache. The TTL is in
+// seconds; 0 entries disables the cache.
+const size_t DEFAULT_OPEN_FILE_CACHE_TTL = 1;
+const size_t DEFAULT_OPEN_FILE_CACHE_MAX = 256;
+
+// Thread-safe cache of open files under one static root, in the manner of
+// nginx's open_file_cache. The root directory is opened once and files are
+// opened with openat() relative to it, so only the path below the root is
+// resolved. Each entry holds the open file and its stat, or the fact that
+// the path doesn't exist, and is trusted without any syscall for ttl. After
+// that a fstatat() revalidates it, and the file is reopened only if it
+// changed. At most max_entries are kept, least recently used dropped first.
+//
+// Paths with ".." segments are refused, so nothing outside the root can be
+// opened through the cache.
+//
+// Usage:
+//   OpenFileCache files(root, DEFAULT_OPEN_FILE_CACHE_TTL, DEFAULT_OPEN_FILE_CACHE_MAX);
+//   OpenFileCache::File file;
+//   if (files.open("docs/index.html", &file)) { file.body, file.st }
+class OpenFileCache {
+ public:
+    struct File {
+        std::shared_ptr<const FileBody> body;
+        struct stat st;
+    };
+
+    OpenFileCache(const std::string& root, size_t ttl_seconds, size_t max_entries);
+    ~OpenFileCache();
+
+    OpenFileCache(const OpenFileCache&) = delete;
+    OpenFileCache& operator=(const OpenFileCache&) = delete;
+
+    // Opens the regular file at path, relative to the root, or returns false
+    // if there is none.
+    bool open(boost::string_ref path, File* file);
+
+    size_t num_entries();
+
+ private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string path;
+        // Empty if the path wasn't found.
+        File file;
+        Clock::time_point expires;
+    };
+
+    // Opens path without the cache.
+    bool open_uncached(const std::string& path, File* file);
+    // Opens the root directory if it isn't open yet.
+    int root_fd();
+
+    std::string root_;
+    Clock::duration ttl_;
+    size_t max_entries_;
+
+    std::mutex mutex_;
+    int root_fd_;
+    // Most recently used first.
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+#endif  // OPEN_FILE_CACHE_H
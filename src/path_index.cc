@@ -0,0 +1,250 @@
+#include "path_index.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace {
+
+// Directory levels indexed below a root.
+const int MAX_INDEX_DEPTH = 16;
+
+#ifdef __linux__
+const uint32_t WATCH_EVENTS = IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM |
+                              IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+
+std::string join(const std::string& directory, const std::string& name) {
+    return directory.empty() ? name : directory + "/" + name;
+}
+
+bool is_hidden(boost::string_ref name) {
+    return !name.empty() && name.front() == '.';
+}
+
+// Whether the index can answer for path: relative, with no empty, hidden,
+// "." or ".." segments.
+bool is_indexable(boost::string_ref path) {
+    while (true) {
+        size_t slash = path.find('/');
+        boost::string_ref segment = path.substr(0, slash);
+        if (segment.empty() || is_hidden(segment)) {
+            return false;
+        }
+        if (slash == boost::string_ref::npos) {
+            return true;
+        }
+        path.remove_prefix(slash + 1);
+    }
+}
+
+// Holds a PathIndex's lock, shared or exclusively, for a scope.
+class ReadLock {
+ public:
+    explicit ReadLock(pthread_rwlock_t* lock) : lock_(lock) { pthread_rwlock_rdlock(lock_); }
+    ~ReadLock() { pthread_rwlock_unlock(lock_); }
+
+ private:
+    pthread_rwlock_t* lock_;
+};
+
+class WriteLock {
+ public:
+    explicit WriteLock(pthread_rwlock_t* lock) : lock_(lock) { pthread_rwlock_wrlock(lock_); }
+    ~WriteLock() { pthread_rwlock_unlock(lock_); }
+
+ private:
+    pthread_rwlock_t* lock_;
+};
+
+}  // namespace
+
+PathIndex::PathIndex(const std::string& root, size_t max_entries)
+    : root_(root.empty() ? "/" : root), max_entries_(max_entries), inotify_fd_(-1), complete_(false) {
+    pthread_rwlock_init(&lock_, nullptr);
+    WriteLock lock(&lock_);
+    rebuild();
+}
+
+PathIndex::~PathIndex() {
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+    }
+    pthread_rwlock_destroy(&lock_);
+}
+
+bool PathIndex::may_exist(boost::string_ref path) {
+    {
+        ReadLock lock(&lock_);
+        if (!complete_ || !is_indexable(path) || indexed(path)) {
+            return true;
+        }
+    }
+
+    // Catch up on changes before calling it missing. Another lookup may have
+    // applied them since, so look again either way.
+    WriteLock lock(&lock_);
+    update();
+    return !complete_ || indexed(path);
+}
+
+bool PathIndex::complete() {
+    WriteLock lock(&lock_);
+    update();
+    return complete_;
+}
+
+size_t PathIndex::size() {
+    WriteLock lock(&lock_);
+    update();
+    return files_.size();
+}
+
+void PathIndex::rebuild() {
+    give_up();
+    if (max_entries_ == 0) {
+        return;
+    }
+
+#ifdef __linux__
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        return;
+    }
+    complete_ = add_directory("", MAX_INDEX_DEPTH);
+#endif
+}
+
+bool PathIndex::add_directory(const std::string& relative, int depth) {
+#ifdef __linux__
+    if (depth < 0) {
+        return give_up();
+    }
+
+    // Watch before listing, so nothing created in between is missed.
+    std::string path = relative.empty() ? root_ : root_ + "/" + relative;
+    int wd = inotify_add_watch(inotify_fd_, path.c_str(), WATCH_EVENTS | (relative.empty() ? 0 : IN_DONT_FOLLOW));
+    DIR* dir = wd < 0 ? nullptr : opendir(path.c_str());
+    if (!dir) {
+        return give_up();
+    }
+    directories_[wd] = relative;
+
+    std::vector<std::string> subdirectories;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.empty() || is_hidden(name)) {
+            continue;
+        }
+
+        std::string child = join(relative, name);
+        struct stat st;
+        if (lstat((path + "/" + name).c_str(), &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            subdirectories.push_back(child);
+        } else {
+            files_.insert(child);
+        }
+    }
+    closedir(dir);
+
+    if (files_.size() + directories_.size() + subdirectories.size() > max_entries_) {
+        return give_up();
+    }
+    for (auto& subdirectory : subdirectories) {
+        if (!add_directory(subdirectory, depth - 1)) {
+            return false;
+        }
+    }
+    return true;
+#else
+    return give_up();
+#endif
+}
+
+bool PathIndex::give_up() {
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+    complete_ = false;
+    files_.clear();
+    directories_.clear();
+    return false;
+}
+
+bool PathIndex::update() {
+#ifdef __linux__
+    if (inotify_fd_ < 0) {
+        return false;
+    }
+
+    bool changed = false;
+    bool rescan = false;
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+        changed = true;
+        for (char* next = buffer; next < buffer + length;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(next);
+            next += sizeof(struct inotify_event) + event->len;
+
+            // Lost events and moved or deleted directories are dealt with by
+            // starting over.
+            if (event->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT)) {
+                rescan = true;
+                continue;
+            }
+            auto directory = directories_.find(event->wd);
+            if (directory == directories_.end() || event->len == 0 || is_hidden(event->name)) {
+                continue;
+            }
+
+            std::string path = join(directory->second, event->name);
+            bool added = event->mask & (IN_CREATE | IN_MOVED_TO);
+            if (!(event->mask & IN_ISDIR)) {
+                if (added) {
+                    files_.insert(path);
+                } else {
+                    files_.erase(path);
+                }
+            } else if (added) {
+                int depth = MAX_INDEX_DEPTH - 1 - std::count(path.begin(), path.end(), '/');
+                if (!add_directory(path, depth)) {
+                    return true;
+                }
+            } else {
+                rescan = true;
+            }
+        }
+    }
+
+    if (rescan) {
+        rebuild();
+    }
+    return changed;
+#else
+    return false;
+#endif
+}
+
+bool PathIndex::indexed(boost::string_ref path) const {
+    if (files_.count(path.to_string())) {
+        return true;
+    }
+    // Anything below a symlink or other non-directory is out of sight.
+    for (size_t slash = path.rfind('/'); slash != boost::string_ref::npos; slash = path.rfind('/')) {
+        path = path.substr(0, slash);
+        if (files_.count(path.to_string())) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,77 @@
+#ifndef PATH_INDEX_H
+#define PATH_INDEX_H
+
+#include <boost/utility/string_ref.hpp>
+#include <pthread.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Most files and directories a StaticFileHandler indexes under its root,
+// unless the handler's config sets path_index_max. 0 disables the index.
+const size_t DEFAULT_PATH_INDEX_MAX = 64 * 1024;
+
+// Set of the files under one static root, built when the handler starts and
+// kept current with inotify, so requests for paths that don't exist can be
+// answered without touching the filesystem. Changes are applied lazily:
+// pending inotify events are read before a path is reported missing, so a
+// file is found as soon as it has been created.
+//
+// Lookups of indexed paths share a read lock, so workers serving existing
+// files don't wait on each other; only catching up on changes takes it
+// exclusively.
+//
+// The index only answers for what it has seen. Hidden entries (names
+// starting with '.') aren't indexed, symlinks aren't followed, and paths
+// through them may exist. If the root can't be watched, or holds more than
+// max_entries files and directories or nests too deeply, the index turns
+// itself off and every path may exist.
+//
+// Usage:
+//   PathIndex index(root);
+//   if (!index.may_exist("docs/index.html")) { definitely not there }
+class PathIndex {
+ public:
+    explicit PathIndex(const std::string& root, size_t max_entries = DEFAULT_PATH_INDEX_MAX);
+    ~PathIndex();
+
+    PathIndex(const PathIndex&) = delete;
+    PathIndex& operator=(const PathIndex&) = delete;
+
+    // Whether path, relative to the root, may name a file. false means it
+    // definitely doesn't.
+    bool may_exist(boost::string_ref path);
+    // Whether the whole root is indexed and watched.
+    bool complete();
+    // Number of files indexed.
+    size_t size();
+
+ private:
+    // Indexes the root from scratch.
+    void rebuild();
+    // Watches and indexes a directory below the root, and everything in it
+    // up to depth levels down. Returns false, turning the index off, if it
+    // can't.
+    bool add_directory(const std::string& relative, int depth);
+    // Turns the index off. Returns false.
+    bool give_up();
+    // Applies pending inotify events. Returns whether there were any.
+    bool update();
+    // Whether path, or a non-directory it passes through, is indexed.
+    bool indexed(boost::string_ref path) const;
+
+    std::string root_;
+    size_t max_entries_;
+
+    // A readers-writer lock guarding everything below; std::shared_timed_mutex
+    // needs C++14.
+    pthread_rwlock_t lock_;
+    int inotify_fd_;
+    bool complete_;
+    // Relative paths of everything but directories.
+    std::unordered_set<std::string> files_;
+    // Relative path of each watched directory, by watch descriptor.
+    std::unordered_map<int, std::string> directories_;
+};
+
+#endif  // PATH_INDEX_H
@@ -1,159 +1,189 @@
 #include "request_handler.h"
-#include <boost/algorithm/string/split.hpp>
-#include <boost/algorithm/string/classification.hpp>
-#include <sstream>
+#include "delimiter_scan.h"
+#include <iostream>
 #include <vector>
 
 /*
  * REQUEST
  */
+namespace {
+
+// Moves a view from one copy of the raw request to the same bytes in another.
+boost::string_ref rebase(boost::string_ref view, const char* from, const char* to) {
+    if (view.empty()) {
+        return boost::string_ref();
+    }
+    return boost::string_ref(to + (view.data() - from), view.size());
+}
+
+}  // namespace
+
+Request::Request(const Request& other) {
+    *this = other;
+}
+
+Request& Request::operator=(const Request& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    // Copies own their bytes, since the original may point into a buffer
+    // that is about to be reused.
+    std::string owned(rhs.raw_request_.data(), rhs.raw_request_.size());
+    const char* from = rhs.raw_request_.data();
+    const char* to = owned.data();
+
+    method_ = rebase(rhs.method_, from, to);
+    uri_ = rebase(rhs.uri_, from, to);
+    version_ = rebase(rhs.version_, from, to);
+    body_ = rebase(rhs.body_, from, to);
+
+    headers_.clear();
+    headers_.reserve(rhs.headers_.size());
+    for (auto& header : rhs.headers_) {
+        headers_.add(rebase(header.first, from, to), rebase(header.second, from, to));
+    }
+
+    owned_.swap(owned);
+    raw_request_ = boost::string_ref(owned_);
+    return *this;
+}
+
 std::unique_ptr<Request> Request::Parse(const std::string& raw_request){
+    std::unique_ptr<Request> request(new Request());
 
+    if (!request->reparse(raw_request)) {
+        return nullptr;
+    }
+
+    return request;
+}
+
+std::unique_ptr<Request> Request::Parse(const RequestParser& parser, const char* data, size_t length){
     std::unique_ptr<Request> request(new Request());
+    request->bind(parser, data, length);
+    return request;
+}
 
-    request->body_ = "";
-    request->method_ = "";
-    request->uri_ = "";
-    request->version_ = "";
-    request->cookie_ = "";
-    request->raw_request_ = raw_request;
-
-    std::istringstream request_stream(raw_request);
-    std::string request_line;
-
-    //handle first line
-    if (std::getline(request_stream, request_line)) {
-        std::vector<std::string> tokens;
-        boost::algorithm::split(tokens, request_line, boost::algorithm::is_any_of(" "));
-
-        if (!tokens.empty() && tokens.size() == 3) {
-            request->method_ = tokens[0];
-            request->uri_ = tokens[1];
-            request->version_ = tokens[2].substr(0, tokens[2].length()-1);
-            std::cout << "Request for " << request->uri_;
-        }
-        else {
-            return nullptr;
-        }
+void Request::bind(const RequestParser& parser, const char* data, size_t length) {
+    auto field = [data](const RequestParser::Span& span) {
+        return boost::string_ref(data + span.offset, span.length);
+    };
+
+    raw_request_ = boost::string_ref(data, length);
+    method_ = field(parser.method());
+    uri_ = field(parser.uri());
+    version_ = field(parser.version());
+    body_ = raw_request_.substr(parser.head_length());
+
+    headers_.clear();
+    headers_.reserve(parser.headers().size());
+    for (auto& header : parser.headers()) {
+        headers_.add(field(header.name), field(header.value));
     }
+}
+
+// Parses raw_request and takes ownership of it. Everything after the head is
+// the body, whatever its declared length.
+bool Request::reparse(std::string raw_request) {
+    RequestParser parser;
 
-    //handle the headers and body
-    while (std::getline(request_stream, request_line)){
-        std::vector<std::string> tokens;
-        std::string header_field;
-        std::string header_value;
-
-        if (!request_line.empty() && request_line.at(0) != '\r') {
-            std::size_t field_index = request_line.find_first_of(":");
-           
-            if (field_index != std::string::npos) {
-                header_field = request_line.substr(0, field_index);
-                header_value = request_line.substr(field_index+2, std::string::npos);
-                //delete carriage return
-                header_value = header_value.substr(0, header_value.length()-1);
-            }
-
-            //find the cookie for /private files
-            if (header_field == "Cookie") {
-                std::string cookie_name =  "private=";
-                std::size_t first = header_value.find(cookie_name);
-
-                if (first != std::string::npos) {
-                    first = first + cookie_name.length();
-                    std::size_t second = header_value.find(";", first);
-
-                    //if there are multiple cookies already, they are separated by ;
-                    //if not, just get the cookie
-                    if (second != std::string::npos) {
-                        request->cookie_ = header_value.substr(first, second - first);
-                    } else {
-                        request->cookie_ = header_value.substr(first);
-                    }
-                }
-            }
-            
-            //std::cout << "Header field: " << header_field << ", Header value: " << header_value << std::endl;
-            request->headers_.push_back( std::make_pair( header_field, header_value));
-        }
-        else {
-            while (std::getline(request_stream, request_line)){
-                request->body_ += request_line;
-            }
-        }
+    if (parser.parse(raw_request.data(), raw_request.size()) == RequestParser::ERROR ||
+        !parser.head_complete()) {
+        return false;
     }
-    std::cout << std::endl;
 
-    return request;
+    owned_.swap(raw_request);
+    bind(parser, owned_.data(), owned_.size());
+    return true;
 }
 
-std::string Request::raw_request() const {
+boost::string_ref Request::find_cookie(boost::string_ref header_value) {
+    boost::string_ref cookie_name = "private=";
+    std::size_t first = header_value.find(cookie_name);
+
+    if (first == boost::string_ref::npos) {
+        return boost::string_ref();
+    }
+
+    first = first + cookie_name.length();
+    std::size_t second = header_value.substr(first).find(';');
+
+    //if there are multiple cookies already, they are separated by ;
+    //if not, just get the cookie
+    return header_value.substr(first, second);
+}
+
+boost::string_ref Request::raw_request() const {
     return raw_request_;
 }
 
-std::string Request::method() const {
+boost::string_ref Request::method() const {
     return method_;
 }
 
-std::string Request::uri() const {
+boost::string_ref Request::uri() const {
     return uri_;
 }
 
-std::string Request::version() const {
+boost::string_ref Request::version() const {
     return version_;
 }
 
-std::string Request::cookie() const {
-    return cookie_;
+boost::string_ref Request::cookie() const {
+    //find the cookie for /private files
+    const boost::string_ref* cookie = headers_.find("Cookie");
+    return cookie ? find_cookie(*cookie) : boost::string_ref();
 }
 
-Request::Headers Request::headers() const {
+const Request::Headers& Request::headers() const {
     return headers_;
 }
 
-std::string Request::body() const {
+boost::string_ref Request::body() const {
     return body_;
 }
 
 void Request::update_header(std::pair<std::string, std::string> header){
-    bool updated = false;
-
-    for (auto it = headers_.begin(); it != headers_.end(); it++){
-    if (it->first == header.first){
-      it->second = header.second;
-      updated = true;
-      break;
-    }
-  }
-  if (!updated){
-    headers_.push_back(header);
-  }
-  update_raw_request();
+    Headers headers = headers_;
+    headers.set(header.first, header.second);
+    update_raw_request(uri_, version_, headers);
 }
 
 void Request::update_uri(std::string newUri){
-  uri_ = newUri;
-  update_raw_request();
+    update_raw_request(newUri, version_, headers_);
 }
 
 void Request::setVersion(const std::string& version){
-  version_ = version;
-  update_raw_request();
+    update_raw_request(uri_, version, headers_);
 }
 
-void Request::update_raw_request(){
-  std::string new_raw;
-  new_raw = method_ + " " + uri_ + " " + version() + "\r\n";
-  
-  for (auto header : headers_){
-    new_raw += header.first + ": " + header.second + "\r\n";
-  }
+void Request::update_raw_request(boost::string_ref uri, boost::string_ref version, const Headers& headers){
+    std::string new_raw;
+    auto append = [&new_raw](boost::string_ref s) {
+        new_raw.append(s.data(), s.size());
+    };
+
+    append(method_);
+    new_raw += " ";
+    append(uri);
+    new_raw += " ";
+    append(version);
+    new_raw += "\r\n";
+
+    for (auto& header : headers){
+        append(header.first);
+        new_raw += ": ";
+        append(header.second);
+        new_raw += "\r\n";
+    }
 
-  new_raw += "\r\n";
-  new_raw += body_;
-  new_raw += "\r\n";
-  
-  raw_request_ = new_raw; 
+    new_raw += "\r\n";
+    append(body_);
+
+    reparse(std::move(new_raw));
 }
+
 /*
  * RESPONSE
  */
@@ -164,6 +194,12 @@ Response& Response::operator=(const Response& rhs){
 
   this->headers_ = rhs.headers_;
   this->response_body_ = rhs.response_body_;
+  this->shared_body_ = rhs.shared_body_;
+  this->file_body_ = rhs.file_body_;
+  this->body_owner_ = rhs.body_owner_;
+  this->owned_data_ = rhs.owned_data_;
+  this->body_offset_ = rhs.body_offset_;
+  this->body_length_ = rhs.body_length_;
   this->status_ = rhs.status_;
   this->status_code_ = rhs.status_code_;
   this->version_ = rhs.version_;
@@ -176,11 +212,25 @@ std::unique_ptr<Response> Response::Parse(const std::string& raw_response){
 
   std::unique_ptr<Response> res = std::unique_ptr<Response>(new Response);
   res->raw_response_ = raw_response;
-  
+
+  const char* begin = raw_response.data();
+  const char* end = begin + raw_response.size();
+
+  // Returns the line starting at pos without its line ending, and moves pos
+  // to the start of the next line.
+  auto next_line = [end](const char*& pos) {
+    const char* line_end = delimiter_scan::find_char(pos, end, '\n');
+    boost::string_ref line(pos, line_end - pos);
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    pos = (line_end == end) ? end : line_end + 1;
+    return line;
+  };
 
   //EXTRACT FIRST LINE CONTENT
-  std::size_t first_line_pos = raw_response.find("\r\n");
-  std::string first_line = raw_response.substr(0, first_line_pos);
+  const char* pos = begin;
+  std::string first_line = next_line(pos).to_string();
 
   std::size_t version_pos = first_line.find(" ");
   res->version_ = first_line.substr(0, version_pos);
@@ -188,7 +238,7 @@ std::unique_ptr<Response> Response::Parse(const std::string& raw_response){
   std::size_t code_pos = first_line.find(" ", version_pos +1);
   std::string code_str = first_line.substr(version_pos + 1, code_pos - version_pos - 1);
   int code = 0;
-  if (code_str != "") {
+  if (code_str != "" && code_str.find_first_not_of("0123456789") == std::string::npos) {
     code = std::stoi(code_str);
   }
   
@@ -200,40 +250,36 @@ std::unique_ptr<Response> Response::Parse(const std::string& raw_response){
 
   res->SetStatus(rc);
 
-  //EXTRACT HEADERS
-  std::size_t headers_pos = raw_response.find("\r\n\r\n", 0);
-  std::string all_headers = raw_response.substr(first_line_pos + 2, headers_pos - first_line_pos - 1);
+  //EXTRACT HEADERS, up to the blank line
+  while (pos < end) {
+    boost::string_ref line = next_line(pos);
+    if (line.empty()) {
+      break;
+    }
 
-  int currentIndex = 0;
-  int previousIndex = -1;
+    const char* line_end = line.data() + line.size();
+    const char* colon = delimiter_scan::find_char(line.data(), line_end, ':');
+    if (colon == line_end) {
+      continue;
+    }
 
-  while ( all_headers.find(": ", currentIndex) != std::string::npos && previousIndex < currentIndex){
-    std::size_t headerName_pos = all_headers.find(": ", currentIndex); 
-    std::string headerName = all_headers.substr(currentIndex, headerName_pos - currentIndex);
-  
-    std::size_t headerValue_pos = all_headers.find("\r\n", headerName_pos + 1);   
-    std::string headerValue = all_headers.substr(headerName_pos + 2, headerValue_pos - headerName_pos -2);
-   
-    res->AddHeader(headerName, headerValue);
- 
-    previousIndex = currentIndex;
-    currentIndex = headerValue_pos + 2;
+    const char* value = colon + 1;
+    while (value < line_end && (*value == ' ' || *value == '\t')) {
+      value++;
+    }
+
+    res->AddHeader(std::string(line.data(), colon), std::string(value, line_end));
   }
 
   //EXTRACT BODY
-  std::string body = raw_response.substr(headers_pos + 4, raw_response.size() - (headers_pos + 4));
-  res->SetBody(body);
+  res->SetBody(std::string(pos, end));
   
   return res;
 }
 
 std::string Response::GetHeader(const std::string& headerName){
-  for (auto header : headers_){
-    if (header.first == headerName)
-      return header.second;
-  }
-
-  return "";
+  const std::string* value = headers_.find(headerName);
+  return value ? *value : "";
 }
 
 void Response::PrintHeaders(){
@@ -250,18 +296,33 @@ bool Response::convertCode(const int& code, ResponseCode& rc){
     case 200:
       rc = ResponseCode::OK;
       return true;
+    case 206:
+      rc = ResponseCode::PARTIAL_CONTENT;
+      return true;
     case 301:
       rc = ResponseCode::MOVED_PERMANENTLY;
       return true;
     case 302:
       rc = ResponseCode::FOUND;
       return true;
+    case 304:
+      rc = ResponseCode::NOT_MODIFIED;
+      return true;
     case 400:
       rc = ResponseCode::BAD_REQUEST;
       return true;
     case 404:
       rc = ResponseCode::NOT_FOUND;
       return true;
+    case 413:
+      rc = ResponseCode::PAYLOAD_TOO_LARGE;
+      return true;
+    case 416:
+      rc = ResponseCode::RANGE_NOT_SATISFIABLE;
+      return true;
+    case 431:
+      rc = ResponseCode::REQUEST_HEADER_FIELDS_TOO_LARGE;
+      return true;
     case 500:
       rc = ResponseCode::INTERNAL_SERVER_ERROR;
       return true;
@@ -280,18 +341,33 @@ void Response::SetStatus(const ResponseCode response_code) {
         case ResponseCode::OK:
             status_ = "200 OK";
             break;
+        case ResponseCode::PARTIAL_CONTENT:
+            status_ = "206 Partial Content";
+            break;
         case ResponseCode::MOVED_PERMANENTLY:
             status_ = "301 Moved Permanently";
             break;
         case ResponseCode::FOUND:
             status_ = "302 Found";
             break;
+        case ResponseCode::NOT_MODIFIED:
+            status_ = "304 Not Modified";
+            break;
         case ResponseCode::BAD_REQUEST:
             status_ = "400 Bad Request";
             break;
         case ResponseCode::NOT_FOUND:
             status_ = "404 Not Found";
             break;
+        case ResponseCode::PAYLOAD_TOO_LARGE:
+            status_ = "413 Payload Too Large";
+            break;
+        case ResponseCode::RANGE_NOT_SATISFIABLE:
+            status_ = "416 Range Not Satisfiable";
+            break;
+        case ResponseCode::REQUEST_HEADER_FIELDS_TOO_LARGE:
+            status_ = "431 Request Header Fields Too Large";
+            break;
         case ResponseCode::INTERNAL_SERVER_ERROR:
             status_ = "500 Internal Server Error";
             break;
@@ -307,38 +383,139 @@ void Response::AddHeader(const std::string& header_name, const std::string& head
         return;
     }
 
-    std::pair<std::string, std::string> header(header_name, header_value);
-    headers_.push_back(header);
+    headers_.add(header_name, header_value);
+}
+
+void Response::SetHeader(const std::string& header_name, const std::string& header_value) {
+    RemoveHeader(header_name);
+    AddHeader(header_name, header_value);
+}
+
+void Response::RemoveHeader(const std::string& header_name) {
+    headers_.remove(header_name);
+}
+
+void Response::SetVersion(const std::string& version) {
+    version_ = version;
 }
 
 void Response::SetBody(const std::string& body) {
     response_body_ = body;
+    shared_body_.reset();
+    file_body_.reset();
+    body_owner_.reset();
+}
+
+void Response::SetBody(std::shared_ptr<const std::string> body) {
+    size_t length = body->size();
+    SetBody(std::move(body), 0, length);
+}
+
+void Response::SetBody(std::shared_ptr<const std::string> body, size_t offset, size_t length) {
+    response_body_.clear();
+    shared_body_ = std::move(body);
+    file_body_.reset();
+    body_owner_.reset();
+    body_offset_ = offset;
+    body_length_ = length;
+}
+
+void Response::SetBody(std::shared_ptr<const void> owner, boost::string_ref body) {
+    response_body_.clear();
+    shared_body_.reset();
+    file_body_.reset();
+    body_owner_ = std::move(owner);
+    owned_data_ = body.data();
+    body_offset_ = 0;
+    body_length_ = body.size();
+}
+
+void Response::SetFileBody(std::shared_ptr<const FileBody> file) {
+    size_t length = file->length();
+    SetFileBody(std::move(file), 0, length);
+}
+
+void Response::SetFileBody(std::shared_ptr<const FileBody> file, size_t offset, size_t length) {
+    response_body_.clear();
+    shared_body_.reset();
+    body_owner_.reset();
+    file_body_ = std::move(file);
+    body_offset_ = offset;
+    body_length_ = length;
 }
 
 std::string Response::ToString() {
     // TODO: What if the status / body are not set?
+    std::string response;
+    response.reserve(HeadLength() + body_length());
+    SerializeHead(&response);
+    if (file_body_) {
+        response += file_body_->Read(body_offset_, body_length_);
+    } else {
+        response.append(body().data(), body().size());
+    }
+    return response;
+}
+
+const std::string& Response::version() const {
+    static const std::string default_version = "HTTP/1.0";
+    return version_.empty() ? default_version : version_;
+}
+
+size_t Response::HeadLength() const {
+    // Status line, then "name: value\r\n" per header, then a blank line.
+    size_t length = version().length() + 1 + status_.length() + 2;
+    for (auto& header_pair : headers_) {
+        length += header_pair.first.length() + 2 + header_pair.second.length() + 2;
+    }
+    return length + 2;
+}
+
+void Response::SerializeHead(std::string* out) const {
+    out->reserve(out->size() + HeadLength());
 
     // Response code
-    std::string response = "HTTP/1.0 " + status_ + "\r\n";
+    out->append(version()).append(" ").append(status_).append("\r\n");
 
     // Headers
-    for (auto &header_pair : headers_) {
-        response += header_pair.first + ": " + header_pair.second + "\r\n";
+    for (auto& header_pair : headers_) {
+        out->append(header_pair.first).append(": ").append(header_pair.second).append("\r\n");
     }
 
     // End of all headers
-    response += "\r\n";
+    out->append("\r\n");
+}
 
-    // Body
-    response += response_body_;
+boost::string_ref Response::body() const {
+    if (shared_body_) {
+        return boost::string_ref(shared_body_->data() + body_offset_, body_length_);
+    }
+    if (body_owner_) {
+        return boost::string_ref(owned_data_, body_length_);
+    }
+    return response_body_;
+}
 
-    return response;
+const std::shared_ptr<const std::string>& Response::shared_body() const {
+    return shared_body_;
+}
+
+const std::shared_ptr<const FileBody>& Response::file_body() const {
+    return file_body_;
+}
+
+size_t Response::file_offset() const {
+    return body_offset_;
 }
 
 Response::ResponseCode Response::status_code() {
     return status_code_;
 }
 
+size_t Response::body_length() const {
+    return file_body_ ? body_length_ : body().length();
+}
+
 /*
  * REQUEST HANDLER (BASE)
  */
@@ -4,6 +4,10 @@
 #define REQUEST_HANDLER_H
 
 #include "config_parser.h"
+#include "file_body.h"
+#include "header_map.h"
+#include "request_parser.h"
+#include <boost/utility/string_ref.hpp>
 #include <map>
 #include <memory>
 #include <string>
@@ -11,39 +15,64 @@
 
 // Represents an HTTP Request.
 //
+// The method, URI, version, headers and body are views into the raw request
+// rather than copies. A request built from a RequestParser refers to the
+// caller's buffer, which must outlive it; this is how the server hands the
+// connection's receive buffer to handlers without copying it. Requests built
+// from a string, copied, or modified own their bytes instead. Call
+// to_string() on a field to keep it beyond the request's lifetime.
+//
 // Usage:
 //   auto request = Request::Parse(raw_request);
 class Request {
  public:
-    static std::unique_ptr<Request> Parse(const std::string& raw_request);
+    using Headers = BasicHeaderMap<boost::string_ref>;
 
-    virtual std::string raw_request() const;
-    virtual std::string method() const;
-    virtual std::string uri() const;
-    std::string version() const;
-    virtual std::string cookie() const;
+    Request() = default;
+    Request(const Request& other);
+    Request& operator=(const Request& rhs);
+    virtual ~Request() = default;
+
+    // Returns nullptr unless raw_request starts with a complete, valid head.
+    // Everything after the head is taken as the body.
+    static std::unique_ptr<Request> Parse(const std::string& raw_request);
+    // Builds a request from a parser that has already parsed data[0, length),
+    // without copying data.
+    static std::unique_ptr<Request> Parse(const RequestParser& parser, const char* data, size_t length);
+
+    virtual boost::string_ref raw_request() const;
+    virtual boost::string_ref method() const;
+    virtual boost::string_ref uri() const;
+    boost::string_ref version() const;
+    virtual boost::string_ref cookie() const;
     
     //New function to update header for reverse_proxy
     //If the header doesn't exist, it is added to the request
+    //These rebuild the raw request, and leave it unchanged if the result
+    //would not parse.
     void update_header(std::pair<std::string, std::string> header);
     void update_uri(std::string newUri);
     void setVersion(const std::string& version);
 
-    using Headers = std::vector<std::pair<std::string, std::string>>;
-    Headers headers() const;
+    const Headers& headers() const;
 
-    virtual std::string body() const;
+    virtual boost::string_ref body() const;
 
  private:
-    void update_raw_request();
-  
-    std::string raw_request_;
-    std::string method_;
-    std::string uri_;
-    std::string version_;
-    std::string cookie_;
-    std::vector<std::pair<std::string, std::string>> headers_;
-    std::string body_;
+    static boost::string_ref find_cookie(boost::string_ref header_value);
+    void bind(const RequestParser& parser, const char* data, size_t length);
+    bool reparse(std::string raw_request);
+    void update_raw_request(boost::string_ref uri, boost::string_ref version, const Headers& headers);
+
+    // Holds the bytes when the request owns them.
+    std::string owned_;
+
+    boost::string_ref raw_request_;
+    boost::string_ref method_;
+    boost::string_ref uri_;
+    boost::string_ref version_;
+    Headers headers_;
+    boost::string_ref body_;
 };
 
 // Represents an HTTP response.
@@ -60,34 +89,83 @@ class Response {
  public:
     enum ResponseCode {
         OK = 200,
+        PARTIAL_CONTENT = 206,
         MOVED_PERMANENTLY = 301,
         FOUND = 302,
+        NOT_MODIFIED = 304,
         BAD_REQUEST = 400,
         NOT_FOUND = 404,
+        PAYLOAD_TOO_LARGE = 413,
+        RANGE_NOT_SATISFIABLE = 416,
+        REQUEST_HEADER_FIELDS_TOO_LARGE = 431,
         INTERNAL_SERVER_ERROR = 500,
         NOT_IMPLEMENTED = 501
     };
 
+    Response() = default;
+    Response(const Response& other) = default;
+    Response(Response&& other) = default;
     Response& operator=(const Response& rhs);
+    Response& operator=(Response&& rhs) = default;
     static std::unique_ptr<Response> Parse(const std::string& raw_response);
 
     void SetStatus(const ResponseCode response_code);
+    void SetVersion(const std::string& version);
     void AddHeader(const std::string& header_name, const std::string& header_value);
+    // Replaces every existing value of the header, or adds it if missing.
+    void SetHeader(const std::string& header_name, const std::string& header_value);
+    void RemoveHeader(const std::string& header_name);
     void SetBody(const std::string& body);
+    // Shares an immutable body, such as a cached file, without copying it.
+    void SetBody(std::shared_ptr<const std::string> body);
+    // Shares length bytes of body from offset.
+    void SetBody(std::shared_ptr<const std::string> body, size_t offset, size_t length);
+    // Shares a body held in memory that owner keeps alive, such as part of a
+    // mapped file.
+    void SetBody(std::shared_ptr<const void> owner, boost::string_ref body);
+    // Sends an open file, or length bytes of it from offset, as the body with
+    // sendfile(). body() is then empty.
+    void SetFileBody(std::shared_ptr<const FileBody> file);
+    void SetFileBody(std::shared_ptr<const FileBody> file, size_t offset, size_t length);
     bool convertCode(const int& code, ResponseCode& rc);
     
+    // Header names are case-insensitive. Returns "" if the header is missing.
     std::string GetHeader(const std::string& headerName);
     std::string ToString();
+    // Writes the status line and headers, ending with the blank line, into
+    // a buffer reserved to HeadLength() up front. The body can then be sent
+    // from body() without copying it next to the head.
+    void SerializeHead(std::string* out) const;
+    size_t HeadLength() const;
+    boost::string_ref body() const;
+    // The shared body set with SetBody, or nullptr.
+    const std::shared_ptr<const std::string>& shared_body() const;
+    // The file sent as the body, or nullptr, and the part of it to send.
+    const std::shared_ptr<const FileBody>& file_body() const;
+    size_t file_offset() const;
     ResponseCode status_code();
+    size_t body_length() const;
     
     void PrintHeaders();
  private:
+    const std::string& version() const;
+
     ResponseCode status_code_;
     std::string raw_response_;
     std::string version_;
     std::string status_;
     std::string response_body_;
-    std::vector<std::pair<std::string, std::string>> headers_;
+    // Set instead of response_body_ for a shared body.
+    std::shared_ptr<const std::string> shared_body_;
+    std::shared_ptr<const FileBody> file_body_;
+    // Set instead of response_body_ for a body owned elsewhere, which starts
+    // at owned_data_.
+    std::shared_ptr<const void> body_owner_;
+    const char* owned_data_ = nullptr;
+    // The part of shared_body_, file_body_ or owned_data_ that is the body.
+    size_t body_offset_ = 0;
+    size_t body_length_ = 0;
+    HeaderMap headers_;
 };
 
 // Represents the parent of all request handlers. Implementations should expect to
@@ -103,6 +181,8 @@ class RequestHandler {
         DATABASE_ERROR = 5
     };
 
+    virtual ~RequestHandler() = default;
+
     // Initializes the handler. Returns true if successful.
     // uri_prefix is the value in the config file that this handler will run for.
     // config is the contents of the child block for this handler ONLY.
@@ -0,0 +1,268 @@
+#include "request_parser.h"
+#include "delimiter_scan.h"
+#include <cstring>
+
+namespace {
+
+// RFC 7230 token characters, allowed in methods and header names.
+struct TokenTable {
+    bool chars[256];
+
+    TokenTable() {
+        for (int c = 0; c < 256; c++) {
+            chars[c] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                       (c != '\0' && std::strchr("!#$%&'*+-.^_`|~", c) != nullptr);
+        }
+    }
+};
+
+const TokenTable token_table;
+
+bool is_token(char c) {
+    return token_table.chars[static_cast<unsigned char>(c)];
+}
+
+// Control characters other than horizontal tab.
+bool is_ctl(char c) {
+    return (static_cast<unsigned char>(c) < 0x20 && c != '\t') || c == 0x7f;
+}
+
+// Case-insensitive comparison against a lowercase name.
+bool name_equals(const char* name, size_t length, const char* lower) {
+    size_t i = 0;
+    for (; i < length && lower[i] != '\0'; i++) {
+        char c = name[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = c - 'A' + 'a';
+        }
+        if (c != lower[i]) {
+            return false;
+        }
+    }
+    return i == length && lower[i] == '\0';
+}
+
+}  // namespace
+
+RequestParser::RequestParser() {
+    reset();
+}
+
+void RequestParser::reset() {
+    state_ = METHOD;
+    pos_ = 0;
+    mark_ = 0;
+    method_ = uri_ = version_ = name_ = Span{0, 0};
+    headers_.clear();
+    head_length_ = 0;
+    content_length_ = 0;
+    has_content_length_ = false;
+}
+
+RequestParser::Result RequestParser::parse(const char* data, size_t length) {
+    while (pos_ < length && state_ != BODY) {
+        char c = data[pos_];
+
+        switch (state_) {
+            case METHOD:
+                if (c == ' ') {
+                    if (pos_ == mark_) {
+                        return ERROR;
+                    }
+                    method_ = Span{mark_, pos_ - mark_};
+                    mark_ = pos_ + 1;
+                    state_ = URI;
+                } else if (!is_token(c)) {
+                    return ERROR;
+                }
+                break;
+
+            case URI:
+                // Skip straight to the next delimiter.
+                pos_ = delimiter_scan::find_space_or_control(data + pos_, data + length) - data;
+                if (pos_ == length) {
+                    return INCOMPLETE;
+                }
+                c = data[pos_];
+
+                if (c == ' ') {
+                    if (pos_ == mark_) {
+                        return ERROR;
+                    }
+                    uri_ = Span{mark_, pos_ - mark_};
+                    mark_ = pos_ + 1;
+                    state_ = VERSION;
+                } else {
+                    return ERROR;
+                }
+                break;
+
+            case VERSION:
+                if (c == '\r' || c == '\n') {
+                    if (pos_ == mark_) {
+                        return ERROR;
+                    }
+                    version_ = Span{mark_, pos_ - mark_};
+                    state_ = (c == '\r') ? REQUEST_LINE_LF : HEADER_START;
+                } else if (c == ' ' || is_ctl(c)) {
+                    return ERROR;
+                }
+                break;
+
+            case REQUEST_LINE_LF:
+            case HEADER_LF:
+                if (c != '\n') {
+                    return ERROR;
+                }
+                state_ = HEADER_START;
+                break;
+
+            case HEADER_START:
+                if (c == '\r') {
+                    state_ = HEAD_END_LF;
+                } else if (c == '\n') {
+                    finish_head();
+                } else if (is_token(c)) {
+                    mark_ = pos_;
+                    state_ = HEADER_NAME;
+                } else {
+                    // Includes obsolete line folding, which we don't accept.
+                    return ERROR;
+                }
+                break;
+
+            case HEADER_NAME:
+                if (c == ':') {
+                    name_ = Span{mark_, pos_ - mark_};
+                    mark_ = pos_ + 1;
+                    state_ = HEADER_VALUE_START;
+                } else if (!is_token(c)) {
+                    return ERROR;
+                }
+                break;
+
+            case HEADER_VALUE_START:
+                // Skip leading whitespace, then reparse this byte as the value.
+                if (c == ' ' || c == '\t') {
+                    break;
+                }
+                mark_ = pos_;
+                state_ = HEADER_VALUE;
+                continue;
+
+            case HEADER_VALUE:
+                // Values make up most of the head, so skip straight to the
+                // control character that ends this one.
+                pos_ = delimiter_scan::find_control(data + pos_, data + length) - data;
+                if (pos_ == length) {
+                    return INCOMPLETE;
+                }
+                c = data[pos_];
+
+                if (c != '\r' && c != '\n') {
+                    return ERROR;
+                }
+                if (!finish_header(data)) {
+                    return ERROR;
+                }
+                state_ = (c == '\r') ? HEADER_LF : HEADER_START;
+                break;
+
+            case HEAD_END_LF:
+                if (c != '\n') {
+                    return ERROR;
+                }
+                finish_head();
+                break;
+
+            case BODY:
+                break;
+        }
+
+        pos_++;
+    }
+
+    if (state_ == BODY && length >= request_length()) {
+        return COMPLETE;
+    }
+    return INCOMPLETE;
+}
+
+bool RequestParser::finish_header(const char* data) {
+    // The value ends at pos_, less any trailing whitespace.
+    size_t value_end = pos_;
+    while (value_end > mark_ && (data[value_end - 1] == ' ' || data[value_end - 1] == '\t')) {
+        value_end--;
+    }
+
+    Header header;
+    header.name = name_;
+    header.value = Span{mark_, value_end - mark_};
+    headers_.push_back(header);
+
+    const char* name = data + name_.offset;
+
+    if (name_equals(name, name_.length, "content-length")) {
+        const char* value = data + header.value.offset;
+        size_t length = 0;
+
+        if (header.value.length == 0 || header.value.length > 18) {
+            return false;
+        }
+        for (size_t i = 0; i < header.value.length; i++) {
+            if (value[i] < '0' || value[i] > '9') {
+                return false;
+            }
+            length = length * 10 + (value[i] - '0');
+        }
+
+        // Conflicting lengths make the framing ambiguous.
+        if (has_content_length_ && length != content_length_) {
+            return false;
+        }
+        content_length_ = length;
+        has_content_length_ = true;
+    } else if (name_equals(name, name_.length, "transfer-encoding")) {
+        // Only length-delimited bodies are supported.
+        return false;
+    }
+
+    return true;
+}
+
+void RequestParser::finish_head() {
+    head_length_ = pos_ + 1;
+    state_ = BODY;
+}
+
+bool RequestParser::head_complete() const {
+    return state_ == BODY;
+}
+
+size_t RequestParser::head_length() const {
+    return head_length_;
+}
+
+size_t RequestParser::content_length() const {
+    return content_length_;
+}
+
+size_t RequestParser::request_length() const {
+    return head_length_ + content_length_;
+}
+
+const RequestParser::Span& RequestParser::method() const {
+    return method_;
+}
+
+const RequestParser::Span& RequestParser::uri() const {
+    return uri_;
+}
+
+const RequestParser::Span& RequestParser::version() const {
+    return version_;
+}
+
+const std::vector<RequestParser::Header>& RequestParser::headers() const {
+    return headers_;
+}
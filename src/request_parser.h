@@ -0,0 +1,95 @@
+#ifndef REQUEST_PARSER_H
+#define REQUEST_PARSER_H
+
+#include <cstddef>
+#include <vector>
+
+// Single-pass, resumable HTTP/1.x request parser. Fields are recorded as
+// offsets into the caller's buffer instead of being copied out, so parsing a
+// request does not allocate once the header list has grown to size.
+//
+// The parser is fed the whole request buffer each time more data arrives and
+// picks up where it stopped, so a request split across several reads is only
+// scanned once. It accepts both CRLF and bare LF line endings. URIs and header
+// values are scanned with the vectorized searches in delimiter_scan.h.
+//
+// Usage:
+//   RequestParser parser;
+//   RequestParser::Result result = parser.parse(buffer, buffered);
+//   if (result == RequestParser::INCOMPLETE) { read more, parse again }
+//   if (result == RequestParser::COMPLETE) { parser.request_length() bytes are one request }
+//   parser.reset();  // Before parsing the next request.
+class RequestParser {
+ public:
+    enum Result {
+        COMPLETE,
+        INCOMPLETE,
+        ERROR
+    };
+
+    // Location of a field within the parsed buffer.
+    struct Span {
+        size_t offset;
+        size_t length;
+    };
+
+    struct Header {
+        Span name;
+        Span value;
+    };
+
+    RequestParser();
+
+    // Parses data[0, length). The first bytes must be the same ones passed to
+    // earlier calls since the last reset(); only the new ones are scanned.
+    Result parse(const char* data, size_t length);
+    void reset();
+
+    // True once the blank line ending the head has been parsed.
+    bool head_complete() const;
+    size_t head_length() const;
+    size_t content_length() const;
+    // Length of the head plus the body it declares.
+    size_t request_length() const;
+
+    const Span& method() const;
+    const Span& uri() const;
+    const Span& version() const;
+    const std::vector<Header>& headers() const;
+
+ private:
+    enum State {
+        METHOD,
+        URI,
+        VERSION,
+        REQUEST_LINE_LF,
+        HEADER_START,
+        HEADER_NAME,
+        HEADER_VALUE_START,
+        HEADER_VALUE,
+        HEADER_LF,
+        HEAD_END_LF,
+        BODY
+    };
+
+    bool finish_header(const char* data);
+    void finish_head();
+
+    State state_;
+    // Next byte to parse.
+    size_t pos_;
+    // Start of the field currently being parsed.
+    size_t mark_;
+
+    Span method_;
+    Span uri_;
+    Span version_;
+    Span name_;
+    std::vector<Header> headers_;
+
+    size_t head_length_;
+    size_t content_length_;
+    bool has_content_length_;
+};
+
+#endif  // REQUEST_PARSER_H
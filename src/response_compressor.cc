@@ -0,0 +1,191 @@
+#include "response_compressor.h"
+#include "content_coding.h"
+#include "header_map.h"
+#include <zlib.h>
+
+namespace {
+
+bool same_owner(const std::weak_ptr<const std::string>& a, const std::shared_ptr<const std::string>& b) {
+    return !a.owner_before(b) && !b.owner_before(a);
+}
+
+}  // namespace
+
+ResponseCompressor& ResponseCompressor::GetInstance() {
+    static ResponseCompressor instance;
+    return instance;
+}
+
+ResponseCompressor::ResponseCompressor(int level, size_t min_length, size_t cache_capacity)
+    : level_(level), min_length_(min_length), capacity_(cache_capacity), size_(0) {
+}
+
+bool ResponseCompressor::compress(const Request& request, Response* response) {
+    int level = level_;
+    boost::string_ref body = response->body();
+    if (level <= 0 || response->status_code() != Response::ResponseCode::OK || response->file_body() ||
+        body.size() < min_length_ || !response->GetHeader("Content-Encoding").empty() ||
+        !compressible(response->GetHeader("Content-Type"))) {
+        return false;
+    }
+
+    // The response depends on Accept-Encoding from here on, whether or not
+    // this client gets it compressed.
+    std::string vary = response->GetHeader("Vary");
+    if (vary.empty()) {
+        response->SetHeader("Vary", "Accept-Encoding");
+    } else if (vary.find("Accept-Encoding") == std::string::npos) {
+        response->SetHeader("Vary", vary + ", Accept-Encoding");
+    }
+
+    const boost::string_ref* accept_encoding = request.headers().find("Accept-Encoding");
+    if (!content_coding::accepts(accept_encoding, "gzip")) {
+        return false;
+    }
+
+    // If zlib fails the response goes out as it is.
+    const Body& shared = response->shared_body();
+    if (shared && shared->size() == body.size()) {
+        Body compressed = compress_shared(shared, level);
+        if (!compressed) {
+            return false;
+        }
+        response->SetBody(compressed);
+    } else {
+        std::string compressed = gzip(body, level);
+        if (compressed.empty()) {
+            return false;
+        }
+        response->SetBody(compressed);
+    }
+
+    // The compressed bytes differ from the original's, so the validator can
+    // only be weak, and byte ranges of them aren't offered.
+    response->SetHeader("Content-Encoding", "gzip");
+    std::string etag = response->GetHeader("ETag");
+    if (!etag.empty() && etag.compare(0, 2, "W/") != 0) {
+        response->SetHeader("ETag", "W/" + etag);
+    }
+    response->RemoveHeader("Accept-Ranges");
+    if (!response->GetHeader("Content-Length").empty()) {
+        response->SetHeader("Content-Length", std::to_string(response->body_length()));
+    }
+    return true;
+}
+
+void ResponseCompressor::configure(int level, size_t min_length, size_t cache_capacity) {
+    level_ = level;
+    min_length_ = min_length;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = cache_capacity;
+    evict();
+}
+
+bool ResponseCompressor::compressible(boost::string_ref content_type) {
+    content_type = content_type.substr(0, content_type.find(';'));
+    while (!content_type.empty() && content_type.back() == ' ') {
+        content_type.remove_suffix(1);
+    }
+
+    static const char* const types[] = {
+        "application/javascript", "application/json", "application/xml", "image/svg+xml",
+    };
+    if (content_type.size() >= 5 && header_names::equals(content_type.substr(0, 5), "text/")) {
+        return true;
+    }
+    for (const char* type : types) {
+        if (header_names::equals(content_type, type)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string ResponseCompressor::gzip(boost::string_ref data, int level) {
+    z_stream stream = z_stream();
+    // 16 added to the window bits asks for a gzip header and trailer.
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return std::string();
+    }
+
+    std::string out(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = out.size();
+
+    // deflateBound leaves room for the whole stream, so one call finishes.
+    int result = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END ? out : std::string();
+}
+
+ResponseCompressor::Body ResponseCompressor::compress_shared(const Body& body, int level) {
+    Key key(body.get(), level);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = index_.find(key);
+        if (found != index_.end() && same_owner(found->second->source, body)) {
+            entries_.splice(entries_.begin(), entries_, found->second);
+            return found->second->compressed;
+        }
+    }
+
+    // Compress outside the lock so other responses aren't held up.
+    Body compressed = std::make_shared<const std::string>(gzip(*body, level));
+    if (compressed->empty()) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = index_.find(key);
+    if (found != index_.end()) {
+        size_ -= found->second->compressed->size();
+        entries_.erase(found->second);
+        index_.erase(found);
+    }
+    if (compressed->size() <= capacity_ / 8) {
+        entries_.push_front(Entry{key, body, compressed});
+        index_[key] = entries_.begin();
+        size_ += compressed->size();
+        evict();
+    }
+    return compressed;
+}
+
+void ResponseCompressor::evict() {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->source.expired()) {
+            size_ -= it->compressed->size();
+            index_.erase(it->key);
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    while (size_ > capacity_ && !entries_.empty()) {
+        const Entry& last = entries_.back();
+        size_ -= last.compressed->size();
+        index_.erase(last.key);
+        entries_.pop_back();
+    }
+}
+
+size_t ResponseCompressor::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+size_t ResponseCompressor::num_entries() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void ResponseCompressor::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+    size_ = 0;
+}
@@ -0,0 +1,92 @@
+#ifndef RESPONSE_COMPRESSOR_H
+#define RESPONSE_COMPRESSOR_H
+
+#include "request_handler.h"
+#include <boost/utility/string_ref.hpp>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// zlib level (1-9, 0 disables), smallest body worth compressing, and bytes of
+// compressed bodies kept.
+const int DEFAULT_GZIP_LEVEL = 6;
+const size_t DEFAULT_GZIP_MIN_LENGTH = 1024;
+const size_t DEFAULT_GZIP_CACHE_SIZE = 16 * 1024 * 1024;
+
+// Gzips text responses for clients that accept it, as the last step before a
+// response is written. Only 200 responses with an in-memory body of a text
+// type are compressed; file bodies sent with sendfile() and bodies that are
+// already encoded are left alone.
+//
+// Compressing a shared body, such as a file from FileCache, is memoized in a
+// memory-bounded LRU keyed on the body itself, so each cached file is
+// compressed once per level rather than once per request. An entry is
+// dropped once its source body has been replaced and released.
+//
+// Usage:
+//   ResponseCompressor::GetInstance().compress(request, &response);
+class ResponseCompressor {
+ public:
+    using Body = std::shared_ptr<const std::string>;
+
+    // The compressor shared by the server's connections.
+    static ResponseCompressor& GetInstance();
+
+    explicit ResponseCompressor(int level = DEFAULT_GZIP_LEVEL, size_t min_length = DEFAULT_GZIP_MIN_LENGTH,
+                                size_t cache_capacity = DEFAULT_GZIP_CACHE_SIZE);
+
+    // Replaces response's body with its gzip encoding if it qualifies and the
+    // request accepts gzip. Returns true if it did.
+    bool compress(const Request& request, Response* response);
+
+    void configure(int level, size_t min_length, size_t cache_capacity);
+
+    // Whether a Content-Type is text that compresses well.
+    static bool compressible(boost::string_ref content_type);
+    // The gzip encoding of data, or "" if zlib fails. A gzip stream is never
+    // empty, even for empty data.
+    static std::string gzip(boost::string_ref data, int level);
+
+    // Bytes of compressed bodies cached.
+    size_t size();
+    size_t num_entries();
+    void clear();
+
+ private:
+    // The source body's address and the level. The address alone could be
+    // reused by a later body, so entries also check the source's owner.
+    using Key = std::pair<const std::string*, int>;
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<const std::string*>()(key.first) ^ static_cast<size_t>(key.second);
+        }
+    };
+    struct Entry {
+        Key key;
+        // Identifies the source body without keeping it alive.
+        std::weak_ptr<const std::string> source;
+        Body compressed;
+    };
+
+    // Returns the memoized compression of body, compressing it on a miss, or
+    // null if compressing fails. Failures aren't memoized.
+    Body compress_shared(const Body& body, int level);
+    // Drops entries whose source is gone, then least recently used ones
+    // until size_ fits capacity_.
+    void evict();
+
+    std::atomic<int> level_;
+    std::atomic<size_t> min_length_;
+
+    std::mutex mutex_;
+    size_t capacity_;
+    size_t size_;
+    // Most recently used first.
+    std::list<Entry> entries_;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+};
+
+#endif  // RESPONSE_COMPRESSOR_H
@@ -90,7 +90,7 @@ RequestHandler::Status ReverseProxyHandler::HandleRequest(const Request& request
 }
 
 Request ReverseProxyHandler::TransformRequest(const Request& incoming_request) {
-  auto transformedRequest = Request::Parse(incoming_request.raw_request());
+  auto transformedRequest = Request::Parse(incoming_request.raw_request().to_string());
 
   //Update Host with that specified in the config
   //TODO: Possibly error check host either in Init 
@@ -112,14 +112,15 @@ Request ReverseProxyHandler::TransformRequest(const Request& incoming_request) {
   //This logic is needed as a path of / ends with / whereas
   //every other path (like /proxy) doesn't
   std::string updatedURI = urlpath_;
-  if (incoming_request.uri().size() > prefix_.size()){
-    std::string uriShortened = incoming_request.uri().substr(prefix_.size());
+  boost::string_ref uri = incoming_request.uri();
+  if (uri.size() > prefix_.size()){
+    boost::string_ref uriShortened = uri.substr(prefix_.size());
     
     if (urlpath_.back() != uriShortened.front()){
-      updatedURI += incoming_request.uri().substr(prefix_.size());
+      updatedURI += uriShortened.to_string();
     }
     else{
-      updatedURI += incoming_request.uri().substr(prefix_.size() + 1);
+      updatedURI += uriShortened.substr(1).to_string();
     }
   }
 
@@ -174,7 +175,7 @@ Response::ResponseCode ReverseProxyHandler::ForwardRequest(const Request& reques
     
     //Since we update raw_request private member on each update
     //We can use send this string as our serialized request
-    boost::asio::write(socket, boost::asio::buffer(request.raw_request(), request.raw_request().size()));
+    boost::asio::write(socket, boost::asio::buffer(request.raw_request().data(), request.raw_request().size()));
     std::string raw_response = getRawResponse(socket);
 
     auto parsedResponse = Response::Parse(raw_response);
@@ -0,0 +1,165 @@
+#include "route_trie.h"
+#include <deque>
+#include <map>
+#include <memory>
+
+namespace {
+
+// Tree used while building, flattened into the trie's node array at the end.
+struct Builder {
+    std::map<std::string, std::unique_ptr<Builder>> children;
+    uint32_t route = UINT32_MAX;
+};
+
+// Calls visit(segment) for each '/'-separated segment of path, including
+// empty ones. "/" is a single empty segment, so the route "/" sits above
+// every rooted path.
+template <typename Visit>
+void for_each_segment(boost::string_ref path, Visit visit) {
+    if (path == "/") {
+        visit(boost::string_ref());
+        return;
+    }
+
+    while (true) {
+        size_t slash = path.find('/');
+        if (slash == boost::string_ref::npos) {
+            visit(path);
+            return;
+        }
+        if (!visit(path.substr(0, slash))) {
+            return;
+        }
+        path.remove_prefix(slash + 1);
+    }
+}
+
+}  // namespace
+
+RouteTrie::RouteTrie() : RouteTrie(Routes()) {
+}
+
+RouteTrie::RouteTrie(const Routes& routes) {
+    Builder root;
+    for (auto& route : routes) {
+        if (route.first.empty()) {
+            continue;
+        }
+
+        Builder* node = &root;
+        for_each_segment(route.first, [&node](boost::string_ref segment) {
+            std::unique_ptr<Builder>& next = node->children[segment.to_string()];
+            if (!next) {
+                next.reset(new Builder);
+            }
+            node = next.get();
+            return true;
+        });
+
+        // A later duplicate replaces the earlier route.
+        if (node->route == NO_ROUTE) {
+            node->route = routes_.size();
+            routes_.push_back(route);
+        } else {
+            routes_[node->route] = route;
+        }
+    }
+
+    // Lay the nodes out breadth first so each node's children are adjacent.
+    nodes_.push_back(Node{0, 0, NO_ROUTE, 0, 0});
+    std::deque<std::pair<const Builder*, uint32_t>> queue;
+    queue.push_back(std::make_pair(&root, 0));
+
+    while (!queue.empty()) {
+        const Builder* builder = queue.front().first;
+        uint32_t index = queue.front().second;
+        queue.pop_front();
+
+        nodes_[index].first_child = nodes_.size();
+        nodes_[index].num_children = builder->children.size();
+
+        for (auto& child : builder->children) {
+            Node node = {0, 0, child.second->route,
+                         static_cast<uint32_t>(segments_.size()),
+                         static_cast<uint32_t>(child.first.size())};
+            segments_ += child.first;
+            queue.push_back(std::make_pair(child.second.get(), static_cast<uint32_t>(nodes_.size())));
+            nodes_.push_back(node);
+        }
+    }
+}
+
+const RouteTrie::Node* RouteTrie::child(const Node& node, boost::string_ref segment) const {
+    // Binary search, in the same order std::map sorted them in.
+    size_t low = node.first_child;
+    size_t high = node.first_child + node.num_children;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        const Node& candidate = nodes_[mid];
+        int order = boost::string_ref(segments_.data() + candidate.segment_offset,
+                                      candidate.segment_length).compare(segment);
+        if (order == 0) {
+            return &candidate;
+        }
+        if (order < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return nullptr;
+}
+
+RequestHandler* RouteTrie::find_exact(boost::string_ref uri) const {
+    const Node* node = &nodes_[0];
+    for_each_segment(uri, [this, &node](boost::string_ref segment) {
+        node = node ? child(*node, segment) : nullptr;
+        return node != nullptr;
+    });
+
+    // "" and "/" share a node; only "/" can be a route.
+    if (!node || node->route == NO_ROUTE || routes_[node->route].first != uri) {
+        return nullptr;
+    }
+    return routes_[node->route].second;
+}
+
+RequestHandler* RouteTrie::find_longest_prefix(boost::string_ref uri, boost::string_ref* prefix) const {
+    size_t last = uri.rfind('/');
+    boost::string_ref directory = uri.substr(0, last);
+    if (directory.empty()) {
+        return nullptr;
+    }
+
+    // Walk the directory's segments one by one, remembering the deepest
+    // node that has a route. "/" is walked as two empty segments here.
+    uint32_t best = NO_ROUTE;
+    const Node* node = &nodes_[0];
+    while (node) {
+        size_t slash = directory.find('/');
+        boost::string_ref segment = directory.substr(0, slash);
+
+        node = child(*node, segment);
+        if (node && node->route != NO_ROUTE) {
+            best = node->route;
+        }
+
+        if (slash == boost::string_ref::npos) {
+            break;
+        }
+        directory.remove_prefix(slash + 1);
+    }
+
+    if (best == NO_ROUTE) {
+        return nullptr;
+    }
+    if (prefix) {
+        *prefix = routes_[best].first;
+    }
+    return routes_[best].second;
+}
+
+size_t RouteTrie::size() const {
+    return routes_.size();
+}
@@ -0,0 +1,64 @@
+#ifndef ROUTE_TRIE_H
+#define ROUTE_TRIE_H
+
+#include <boost/utility/string_ref.hpp>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+class RequestHandler;
+
+// Immutable trie of handler routes over '/'-separated path segments, built
+// once when the config is loaded. Lookups walk the URI a segment at a time
+// without allocating, so their cost depends on the length of the URI rather
+// than the number of routes.
+//
+// Routes match like Webserver's original prefix search: a URI is served by
+// the route equal to it, or else by the longest route that is a whole-segment
+// prefix of the URI's directory (everything before its last '/'). The route
+// "/" matches any directory that starts with '/'. Routes used for prefix
+// matching are expected to start with '/'.
+//
+// Usage:
+//   RouteTrie routes({{"/static", static_handler}, {"/", proxy_handler}});
+//   RequestHandler* handler = routes.find_exact(uri);
+//   if (!handler) handler = routes.find_longest_prefix(uri);
+class RouteTrie {
+ public:
+    using Routes = std::vector<std::pair<std::string, RequestHandler*>>;
+
+    RouteTrie();
+    // Empty route names are ignored.
+    explicit RouteTrie(const Routes& routes);
+
+    // Returns the handler for the route equal to uri, or nullptr.
+    RequestHandler* find_exact(boost::string_ref uri) const;
+    // Returns the handler for the longest route that is a prefix of uri's
+    // directory, or nullptr. If prefix is given, it is set to that route.
+    RequestHandler* find_longest_prefix(boost::string_ref uri, boost::string_ref* prefix = nullptr) const;
+
+    size_t size() const;
+
+ private:
+    struct Node {
+        // Children are stored contiguously, sorted by segment.
+        uint32_t first_child;
+        uint32_t num_children;
+        // Index into routes_, or NO_ROUTE.
+        uint32_t route;
+        // Location of this node's segment in segments_.
+        uint32_t segment_offset;
+        uint32_t segment_length;
+    };
+
+    enum : uint32_t { NO_ROUTE = UINT32_MAX };
+
+    const Node* child(const Node& node, boost::string_ref segment) const;
+
+    std::vector<Node> nodes_;
+    std::string segments_;
+    Routes routes_;
+};
+
+#endif  // ROUTE_TRIE_H
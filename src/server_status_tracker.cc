@@ -7,22 +7,49 @@ ServerStatusTracker& ServerStatusTracker::GetInstance() {
 
 void ServerStatusTracker::RecordRequest(const std::string& url, const Response::ResponseCode& response) {
     std::pair<std::string, Response::ResponseCode> request(url, response);
+    std::lock_guard<std::mutex> lock(mutex_);
     url_requests_.push_back(request);
 }
 
 void ServerStatusTracker::RecordHandlerMapping(const std::string& prefix, const std::string& handler_name) {
     std::pair<std::string, std::string> handler(prefix, handler_name);
+    std::lock_guard<std::mutex> lock(mutex_);
     handlers_.push_back(handler);
 }
 
+void ServerStatusTracker::SetHandlerMappings(const HandlerList& handlers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    handlers_ = handlers;
+}
+
+void ServerStatusTracker::RecordFileCacheHit() {
+    file_cache_hits_++;
+}
+
+void ServerStatusTracker::RecordFileCacheMiss() {
+    file_cache_misses_++;
+}
+
+void ServerStatusTracker::RecordFileCacheEviction() {
+    file_cache_evictions_++;
+}
+
+ServerStatusTracker::FileCacheStats ServerStatusTracker::GetFileCacheStats() const {
+    FileCacheStats stats = {file_cache_hits_, file_cache_misses_, file_cache_evictions_};
+    return stats;
+}
+
 ServerStatusTracker::RequestList ServerStatusTracker::GetRequests() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     return url_requests_;
 }
 
 ServerStatusTracker::HandlerList ServerStatusTracker::GetHandlers() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     return handlers_;
 }
 
 int ServerStatusTracker::GetNumRequests() {
+    std::lock_guard<std::mutex> lock(mutex_);
     return url_requests_.size();
 }
\ No newline at end of file
@@ -2,8 +2,13 @@
 #define SERVER_STATUS_TRACKER_H
 
 #include "request_handler.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 
-// Singleton class to keep track of server request information
+// Singleton class to keep track of server request information. Requests and
+// handler mappings are recorded from every worker thread and from config
+// reloads, so they are kept under a mutex.
 class ServerStatusTracker
 {
     public:
@@ -18,16 +23,33 @@ class ServerStatusTracker
 
         using HandlerList = std::vector<std::pair<std::string, std::string>>;
         HandlerList GetHandlers() const;
+        // Replaces every recorded mapping, as when the config is reloaded.
+        void SetHandlerMappings(const HandlerList& handlers);
+
+        // Counters for FileCache, safe to update from any thread.
+        struct FileCacheStats {
+            uint64_t hits;
+            uint64_t misses;
+            uint64_t evictions;
+        };
+        void RecordFileCacheHit();
+        void RecordFileCacheMiss();
+        void RecordFileCacheEviction();
+        FileCacheStats GetFileCacheStats() const;
 
         // Delete copy and assignment functions
         ServerStatusTracker(ServerStatusTracker const&) = delete;
         void operator=(ServerStatusTracker const&) = delete;
 
     private:
-        ServerStatusTracker() {} // Hide the constructor
+        ServerStatusTracker() : file_cache_hits_(0), file_cache_misses_(0), file_cache_evictions_(0) {} // Hide the constructor
 
+        mutable std::mutex mutex_;
         std::vector<std::pair<std::string, Response::ResponseCode>> url_requests_;
         std::vector<std::pair<std::string, std::string>> handlers_;
+        std::atomic<uint64_t> file_cache_hits_;
+        std::atomic<uint64_t> file_cache_misses_;
+        std::atomic<uint64_t> file_cache_evictions_;
 };
 
 #endif // SERVER_STATUS_TRACKER_H
\ No newline at end of file
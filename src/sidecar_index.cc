@@ -0,0 +1,61 @@
+#include "sidecar_index.h"
+
+SidecarIndex& SidecarIndex::GetInstance() {
+    static SidecarIndex instance;
+    return instance;
+}
+
+SidecarIndex::Sidecars SidecarIndex::find(const std::string& path, const struct stat& st) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = entries_.find(path);
+        if (found != entries_.end() && matches(found->second, st)) {
+            return found->second.sidecars;
+        }
+    }
+
+    // Look for the copies outside the lock.
+    Entry entry;
+    entry.mtime = st.st_mtim;
+    entry.size = st.st_size;
+    entry.inode = st.st_ino;
+    for (int i = 0; i < NUM_ENCODINGS; i++) {
+        Encoding encoding = static_cast<Encoding>(i);
+        struct stat sidecar;
+        if (stat((path + extension(encoding)).c_str(), &sidecar) == 0 && S_ISREG(sidecar.st_mode) &&
+            sidecar.st_mtime >= st.st_mtime) {
+            entry.sidecars.present |= 1u << encoding;
+            entry.sidecars.size[encoding] = sidecar.st_size;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.size() >= MAX_ENTRIES) {
+        entries_.clear();
+    }
+    entries_[path] = entry;
+    return entry.sidecars;
+}
+
+void SidecarIndex::forget(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(path);
+}
+
+void SidecarIndex::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+const char* SidecarIndex::coding(Encoding encoding) {
+    return encoding == BROTLI ? "br" : "gzip";
+}
+
+const char* SidecarIndex::extension(Encoding encoding) {
+    return encoding == BROTLI ? ".br" : ".gz";
+}
+
+bool SidecarIndex::matches(const Entry& entry, const struct stat& st) {
+    return entry.mtime.tv_sec == st.st_mtim.tv_sec && entry.mtime.tv_nsec == st.st_mtim.tv_nsec &&
+           entry.size == st.st_size && entry.inode == st.st_ino;
+}
@@ -0,0 +1,77 @@
+#ifndef SIDECAR_INDEX_H
+#define SIDECAR_INDEX_H
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Remembers which precompressed copies ("foo.css.br", "foo.css.gz") sit next
+// to each static file, shared by every StaticFileHandler. A file is only
+// searched for its copies the first time it is requested or after its own
+// stat changes, so serving it costs no extra syscalls. Copies older than the
+// file are stale and ignored.
+//
+// A copy added or removed without touching the original goes unnoticed
+// until the original changes; if a copy can't be read, call forget().
+//
+// Usage:
+//   SidecarIndex::Sidecars sidecars = SidecarIndex::GetInstance().find(path, st);
+//   if (sidecars.has(SidecarIndex::GZIP)) serve path + SidecarIndex::extension(SidecarIndex::GZIP)
+class SidecarIndex {
+ public:
+    // In order of preference, smallest output first.
+    enum Encoding {
+        BROTLI,
+        GZIP,
+        NUM_ENCODINGS
+    };
+
+    struct Sidecars {
+        bool has(Encoding encoding) const {
+            return (present & (1u << encoding)) != 0;
+        }
+        bool any() const {
+            return present != 0;
+        }
+
+        // Bit i is set if encoding i has a copy.
+        unsigned present = 0;
+        // Sizes of the copies that exist.
+        off_t size[NUM_ENCODINGS] = {};
+    };
+
+    // The index shared by the server's handlers.
+    static SidecarIndex& GetInstance();
+
+    // Returns the copies of the regular file at path, whose stat is st.
+    Sidecars find(const std::string& path, const struct stat& st);
+    // Drops what is known about path's copies.
+    void forget(const std::string& path);
+    void clear();
+
+    // The Content-Encoding token and file name suffix of an encoding.
+    static const char* coding(Encoding encoding);
+    static const char* extension(Encoding encoding);
+
+ private:
+    struct Entry {
+        struct timespec mtime;
+        off_t size;
+        ino_t inode;
+        Sidecars sidecars;
+    };
+
+    // The index is cleared when it grows past this, rather than tracking
+    // recency for what is a few bytes per file.
+    static const size_t MAX_ENTRIES = 64 * 1024;
+
+    static bool matches(const Entry& entry, const struct stat& st);
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+#endif  // SIDECAR_INDEX_H
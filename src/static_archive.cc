@@ -0,0 +1,211 @@
+#include "static_archive.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const char MAGIC[8] = {'W', 'S', 'A', 'R', 'C', 'H', 'V', '1'};
+
+struct Header {
+    char magic[8];
+    uint64_t num_entries;
+    uint64_t index_offset;
+    uint64_t index_length;
+};
+
+// Bodies are numbered as in Entry: the file itself, then each copy.
+const int NUM_BODIES = 1 + SidecarIndex::NUM_ENCODINGS;
+
+struct Record {
+    uint64_t offset[NUM_BODIES];
+    uint64_t length[NUM_BODIES];
+    int64_t last_modified;
+    uint32_t path_length;
+    uint32_t type_length;
+    uint32_t etag_length;
+    uint32_t padding;
+};
+
+size_t padded(size_t length) {
+    return (length + 7) & ~static_cast<size_t>(7);
+}
+
+}  // namespace
+
+SidecarIndex::Sidecars StaticArchive::Entry::sidecars() const {
+    SidecarIndex::Sidecars sidecars;
+    for (int i = 0; i < SidecarIndex::NUM_ENCODINGS; i++) {
+        if (!encoded[i].empty()) {
+            sidecars.present |= 1u << i;
+            sidecars.size[i] = encoded[i].size();
+        }
+    }
+    return sidecars;
+}
+
+std::shared_ptr<const StaticArchive> StaticArchive::Open(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        close(fd);
+        return nullptr;
+    }
+
+    // The mapping outlives the descriptor.
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::shared_ptr<StaticArchive> archive(new StaticArchive(static_cast<const char*>(data), st.st_size));
+    if (!archive->load()) {
+        return nullptr;
+    }
+    return archive;
+}
+
+bool StaticArchive::Write(const std::string& path, std::vector<File> files) {
+    std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.path < b.path; });
+    for (size_t i = 1; i < files.size(); i++) {
+        if (files[i].path == files[i - 1].path) {
+            return false;
+        }
+    }
+
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+
+    Header header = {};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.num_entries = files.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::string index;
+    uint64_t offset = sizeof(header);
+    for (auto& file : files) {
+        Record record = {};
+        for (int i = 0; i < NUM_BODIES; i++) {
+            const std::string& body = i == 0 ? file.body : file.encoded[i - 1];
+            record.offset[i] = offset;
+            record.length[i] = body.size();
+            out.write(body.data(), body.size());
+            offset += body.size();
+        }
+        record.last_modified = file.last_modified;
+        record.path_length = file.path.size();
+        record.type_length = file.content_type.size();
+        record.etag_length = file.etag.size();
+
+        index.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        for (const std::string* field : {&file.path, &file.content_type, &file.etag}) {
+            index.append(*field);
+            index.append(padded(field->size()) - field->size(), '\0');
+        }
+    }
+
+    // The index starts on an 8 byte boundary, so its records are aligned.
+    std::string padding(padded(offset) - offset, '\0');
+    out.write(padding.data(), padding.size());
+    header.index_offset = offset + padding.size();
+    header.index_length = index.size();
+    out.write(index.data(), index.size());
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+
+    if (!out || rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+StaticArchive::StaticArchive(const char* data, size_t length) : data_(data), length_(length) {
+}
+
+StaticArchive::~StaticArchive() {
+    munmap(const_cast<char*>(data_), length_);
+}
+
+bool StaticArchive::load() {
+    Header header;
+    memcpy(&header, data_, sizeof(header));
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.index_offset % 8 != 0 ||
+        header.index_offset > length_ || header.index_length > length_ - header.index_offset) {
+        return false;
+    }
+
+    // Every record takes more than this, which bounds the entry count.
+    if (header.num_entries > header.index_length / sizeof(Record)) {
+        return false;
+    }
+    entries_.reserve(header.num_entries);
+
+    size_t position = header.index_offset;
+    const size_t end = header.index_offset + header.index_length;
+    for (uint64_t n = 0; n < header.num_entries; n++) {
+        if (end - position < sizeof(Record)) {
+            return false;
+        }
+        Record record;
+        memcpy(&record, data_ + position, sizeof(record));
+        position += sizeof(record);
+
+        Entry entry;
+        entry.last_modified = record.last_modified;
+        for (int i = 0; i < NUM_BODIES; i++) {
+            if (record.offset[i] > header.index_offset || record.length[i] > header.index_offset - record.offset[i]) {
+                return false;
+            }
+            boost::string_ref body(data_ + record.offset[i], record.length[i]);
+            if (i == 0) {
+                entry.body = body;
+            } else {
+                entry.encoded[i - 1] = body;
+            }
+        }
+
+        boost::string_ref* fields[] = {&entry.path, &entry.content_type, &entry.etag};
+        uint32_t lengths[] = {record.path_length, record.type_length, record.etag_length};
+        for (int i = 0; i < 3; i++) {
+            if (end - position < padded(lengths[i])) {
+                return false;
+            }
+            *fields[i] = boost::string_ref(data_ + position, lengths[i]);
+            position += padded(lengths[i]);
+        }
+
+        if (!entries_.empty() && !(entries_.back().path < entry.path)) {
+            return false;
+        }
+        entries_.push_back(entry);
+    }
+    return true;
+}
+
+const StaticArchive::Entry* StaticArchive::find(boost::string_ref path) const {
+    auto found = std::lower_bound(entries_.begin(), entries_.end(), path,
+                                  [](const Entry& entry, boost::string_ref path) { return entry.path < path; });
+    if (found == entries_.end() || found->path != path) {
+        return nullptr;
+    }
+    return &*found;
+}
+
+size_t StaticArchive::size() const {
+    return entries_.size();
+}
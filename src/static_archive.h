@@ -0,0 +1,86 @@
+#ifndef STATIC_ARCHIVE_H
+#define STATIC_ARCHIVE_H
+
+#include "sidecar_index.h"
+#include <boost/utility/string_ref.hpp>
+#include <time.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A static root packed into one read-only file, for deployments whose files
+// never change. The archive is mapped into memory when it is opened, and
+// each file is served straight from the mapping: lookups are a binary search
+// of an in-memory index, and bodies are shared with responses without a
+// syscall or a copy. Each file carries its content type, a strong ETag and
+// modification time, and optionally precompressed copies.
+//
+// Archives are written by tools/static_pack in the byte order of the machine
+// that packs them:
+//   header  "WSARCHV1", entry count, index offset, index length (u64 each)
+//   bodies  every file and copy, back to back
+//   index   per file, sorted by path: offsets and lengths of its body and
+//           copies (u64, length 0 if absent), modification time (i64),
+//           path, type and ETag lengths (u32, plus padding), then those
+//           strings, padded to 8 bytes
+//
+// Usage:
+//   std::shared_ptr<const StaticArchive> archive = StaticArchive::Open(path);
+//   const StaticArchive::Entry* entry = archive->find("docs/index.html");
+//   if (entry) response->SetBody(archive, entry->body);
+class StaticArchive {
+ public:
+    struct Entry {
+        // The path below the packed root, without a leading '/'.
+        boost::string_ref path;
+        boost::string_ref content_type;
+        // The quoted strong validator of the body.
+        boost::string_ref etag;
+        time_t last_modified;
+        boost::string_ref body;
+        // Precompressed copies of the body; empty if absent.
+        boost::string_ref encoded[SidecarIndex::NUM_ENCODINGS];
+
+        // The copies as SidecarIndex would report them.
+        SidecarIndex::Sidecars sidecars() const;
+    };
+
+    // A file to pack. Empty copies are left out.
+    struct File {
+        std::string path;
+        std::string content_type;
+        std::string etag;
+        time_t last_modified;
+        std::string body;
+        std::string encoded[SidecarIndex::NUM_ENCODINGS];
+    };
+
+    // Maps the archive at path, or returns nullptr if it can't be read or
+    // isn't a valid archive.
+    static std::shared_ptr<const StaticArchive> Open(const std::string& path);
+    // Packs files into an archive at path, replacing it atomically. Returns
+    // false on failure.
+    static bool Write(const std::string& path, std::vector<File> files);
+
+    ~StaticArchive();
+
+    StaticArchive(const StaticArchive&) = delete;
+    StaticArchive& operator=(const StaticArchive&) = delete;
+
+    // The file at path, relative to the packed root, or nullptr.
+    const Entry* find(boost::string_ref path) const;
+    size_t size() const;
+
+ private:
+    StaticArchive(const char* data, size_t length);
+
+    // Reads the index. Returns false if anything is out of bounds or the
+    // paths aren't sorted.
+    bool load();
+
+    const char* data_;
+    size_t length_;
+    std::vector<Entry> entries_;
+};
+
+#endif  // STATIC_ARCHIVE_H
@@ -1,12 +1,116 @@
 #include "static_file_handler.h"
-#include "../cpp-markdown/markdown.h"
+#include "byte_range.h"
+#include "content_coding.h"
+#include "file_cache.h"
+#include "http_date.h"
+#include "markdown_cache.h"
+#include "sidecar_index.h"
+#include <sys/stat.h>
 #include <algorithm>
-#include <fstream>
-#include <sstream>
+#include <cstdio>
 #include <time.h>
 #include <random>
 #include <unordered_map>
 
+namespace {
+
+// A strong validator built from the file's identity and modification time,
+// which change whenever its contents are rewritten or replaced. Each
+// precompressed copy is a different representation and gets its own.
+std::string make_etag(const struct stat& st, SidecarIndex::Encoding encoding) {
+    char buffer[80];
+    snprintf(buffer, sizeof(buffer), "\"%llx-%llx-%llx%s%s\"",
+             static_cast<unsigned long long>(st.st_ino),
+             static_cast<unsigned long long>(st.st_size),
+             static_cast<unsigned long long>(st.st_mtim.tv_sec) * 1000000000ull + st.st_mtim.tv_nsec,
+             encoding == SidecarIndex::NUM_ENCODINGS ? "" : "-",
+             encoding == SidecarIndex::NUM_ENCODINGS ? "" : SidecarIndex::coding(encoding));
+    return buffer;
+}
+
+// The precompressed copy to send, or NUM_ENCODINGS for the file itself.
+SidecarIndex::Encoding choose_sidecar(const Request& request, const SidecarIndex::Sidecars& sidecars) {
+    if (!sidecars.any()) {
+        return SidecarIndex::NUM_ENCODINGS;
+    }
+
+    const boost::string_ref* accept_encoding = request.headers().find("Accept-Encoding");
+    for (int i = 0; i < SidecarIndex::NUM_ENCODINGS; i++) {
+        SidecarIndex::Encoding encoding = static_cast<SidecarIndex::Encoding>(i);
+        if (sidecars.has(encoding) && content_coding::accepts(accept_encoding, SidecarIndex::coding(encoding))) {
+            return encoding;
+        }
+    }
+    return SidecarIndex::NUM_ENCODINGS;
+}
+
+// Whether an If-None-Match list contains etag, by weak comparison.
+bool etag_list_matches(boost::string_ref list, const std::string& etag) {
+    while (!list.empty()) {
+        while (!list.empty() && (list.front() == ' ' || list.front() == '\t' || list.front() == ',')) {
+            list.remove_prefix(1);
+        }
+        if (list.starts_with("*")) {
+            return true;
+        }
+        if (list.starts_with("W/")) {
+            list.remove_prefix(2);
+        }
+        if (!list.starts_with("\"")) {
+            return false;
+        }
+        size_t end = list.substr(1).find('"');
+        if (end == boost::string_ref::npos) {
+            return false;
+        }
+        if (list.substr(0, end + 2) == etag) {
+            return true;
+        }
+        list.remove_prefix(end + 2);
+    }
+    return false;
+}
+
+// RFC 7232 section 6: If-None-Match takes precedence over If-Modified-Since.
+bool not_modified(const Request& request, const std::string& etag, time_t mtime) {
+    const boost::string_ref* if_none_match = request.headers().find("If-None-Match");
+    const boost::string_ref* if_modified_since = request.headers().find("If-Modified-Since");
+    if (!if_none_match && !if_modified_since) {
+        return false;
+    }
+
+    boost::string_ref method = request.method();
+    if (method != "GET" && method != "HEAD") {
+        return false;
+    }
+    if (if_none_match) {
+        return etag_list_matches(*if_none_match, etag);
+    }
+
+    time_t since;
+    return http_date::parse(*if_modified_since, &since) && mtime <= since;
+}
+
+// Sets a numeric setting of the handler's config, which may appear once.
+// Like the server's own settings, only plain decimal numbers short enough to
+// not overflow are accepted.
+bool parse_number(const std::string& name, const std::string& token, const std::string& uri_prefix,
+                  bool* has_value, size_t* value) {
+    if (*has_value) {
+        std::cerr << "Error: Multiple " << name << " mappings specified for " << uri_prefix << ".\n";
+        return false;
+    }
+    if (token.empty() || token.length() > 9 || token.find_first_not_of("1234567890") != std::string::npos) {
+        std::cerr << "Error: " << name << " is not a number.\n";
+        return false;
+    }
+    *value = std::stoul(token);
+    *has_value = true;
+    return true;
+}
+
+}  // namespace
+
 // Get the content type from the file name.
 std::string StaticFileHandler::get_content_type(const std::string& filename_str) {
     // Find last period.
@@ -39,6 +143,14 @@ std::string StaticFileHandler::get_content_type(const std::string& filename_str)
         return TYPE_TXT;
     } else if (type == "md") {
         return TYPE_MD;
+    } else if (type == "css") {
+        return TYPE_CSS;
+    } else if (type == "js") {
+        return TYPE_JS;
+    } else if (type == "json") {
+        return TYPE_JSON;
+    } else if (type == "svg") {
+        return TYPE_SVG;
     } else { // Default to type octet-stream.
         return TYPE_OCT;
     }
@@ -48,6 +160,16 @@ RequestHandler::Status StaticFileHandler::Init(const std::string& uri_prefix, co
     prefix = uri_prefix;
     root = "";
     timeout = 0;
+    sendfile_threshold = DEFAULT_SENDFILE_THRESHOLD;
+    bool has_sendfile_threshold = false;
+    size_t open_file_cache_ttl = DEFAULT_OPEN_FILE_CACHE_TTL;
+    size_t open_file_cache_max = DEFAULT_OPEN_FILE_CACHE_MAX;
+    bool has_open_file_cache_ttl = false;
+    bool has_open_file_cache_max = false;
+    size_t path_index_max = DEFAULT_PATH_INDEX_MAX;
+    bool has_path_index_max = false;
+    std::string archive_path;
+    archive.reset();
 
     // Iterate through the config block to find the root mapping.
     for (size_t i = 0; i < config.statements_.size(); i++) {
@@ -96,6 +218,33 @@ RequestHandler::Status StaticFileHandler::Init(const std::string& uri_prefix, co
                 std::cerr << "Error: Multiple user mappings specified for " << uri_prefix <<".\n";
                 return RequestHandler::Status::INVALID_CONFIG;
             }
+        } else if (first_token == "sendfile_threshold" && third_token == "") {
+            // Set the size from which files are sent with sendfile().
+            if (!parse_number(first_token, second_token, uri_prefix, &has_sendfile_threshold, &sendfile_threshold)) {
+                return RequestHandler::Status::INVALID_CONFIG;
+            }
+        } else if (first_token == "open_file_cache_ttl" && third_token == "") {
+            // Set how long open files are trusted.
+            if (!parse_number(first_token, second_token, uri_prefix, &has_open_file_cache_ttl, &open_file_cache_ttl)) {
+                return RequestHandler::Status::INVALID_CONFIG;
+            }
+        } else if (first_token == "open_file_cache_max" && third_token == "") {
+            // Set how many open files are kept.
+            if (!parse_number(first_token, second_token, uri_prefix, &has_open_file_cache_max, &open_file_cache_max)) {
+                return RequestHandler::Status::INVALID_CONFIG;
+            }
+        } else if (first_token == "path_index_max" && third_token == "") {
+            // Set how many entries the index of existing files may hold.
+            if (!parse_number(first_token, second_token, uri_prefix, &has_path_index_max, &path_index_max)) {
+                return RequestHandler::Status::INVALID_CONFIG;
+            }
+        } else if (first_token == "archive" && third_token == "") {
+            // Set the packed archive to serve instead of a root.
+            if (!archive_path.empty()) {
+                std::cerr << "Error: Multiple archive mappings specified for " << uri_prefix <<".\n";
+                return RequestHandler::Status::INVALID_CONFIG;
+            }
+            archive_path = second_token;
         } else if (first_token == "timeout" && third_token == "") {
             // Set the timeout value.
             if (timeout == 0) {
@@ -115,7 +264,12 @@ RequestHandler::Status StaticFileHandler::Init(const std::string& uri_prefix, co
         }
     }
 
-    if (root.empty()) {
+    if (!archive_path.empty() && !root.empty()) {
+        // Error: Files can come from only one place.
+        std::cerr << "Error: Both root and archive specified for " << uri_prefix <<".\n";
+        return RequestHandler::Status::INVALID_CONFIG;
+    }
+    if (root.empty() && archive_path.empty()) {
         // Error: No config definition for the root.
         std::cerr << "Error: No root mapping specified for " << uri_prefix <<".\n";
         return RequestHandler::Status::INVALID_CONFIG;
@@ -128,17 +282,34 @@ RequestHandler::Status StaticFileHandler::Init(const std::string& uri_prefix, co
         return RequestHandler::Status::INVALID_CONFIG;
     }
 
+    if (!archive_path.empty()) {
+        archive = StaticArchive::Open(archive_path);
+        if (!archive) {
+            std::cerr << "Error: Can't open archive " << archive_path << " for " << uri_prefix <<".\n";
+            return RequestHandler::Status::INVALID_CONFIG;
+        }
+        return RequestHandler::Status::OK;
+    }
+
+    open_files = std::make_shared<OpenFileCache>(root, open_file_cache_ttl, open_file_cache_max);
+    paths.reset();
+    if (path_index_max > 0) {
+        paths = std::make_shared<PathIndex>(root, path_index_max);
+    }
+
+    // Render the markdown under the root before anyone asks for it.
+    MarkdownCache::GetInstance().warm(root);
+
     return RequestHandler::Status::OK;
 }
 
 RequestHandler::Status StaticFileHandler::HandleRequest(const Request& request, Response* response) {
     std::string file_path = "";
-    std::string contents = "";
     std::string login = prefix + "/login.html";
     bool redirect = false;
 
     // Get URI.
-    std::string filename = request.uri();
+    std::string filename = request.uri().to_string();
 
     // Check if URI is login page
     if (filename.find(login) == 0 && login.length() == filename.length()) {
@@ -147,7 +318,7 @@ RequestHandler::Status StaticFileHandler::HandleRequest(const Request& request,
 
     // If serving regular static files or the request is about login.html, skip
     if (timeout != 0 && !redirect) {
-        bool cookie_ok = check_cookie(request.cookie(), response);
+        bool cookie_ok = check_cookie(request.cookie().to_string(), response);
 
         if (!cookie_ok) {
             // If cookie is not ok, need to redirect
@@ -159,7 +330,7 @@ RequestHandler::Status StaticFileHandler::HandleRequest(const Request& request,
     if (request.method() == "POST" && redirect) {
         // The body returns: username=USERNAME&password=PASSWORD
         // Extract username and password
-        std::string body = request.body();
+        std::string body = request.body().to_string();
         size_t first = body.find("=") + 1;
         size_t second = body.find("&");
         std::string user = body.substr(first, second - first);
@@ -170,7 +341,7 @@ RequestHandler::Status StaticFileHandler::HandleRequest(const Request& request,
 
         if (found != user_map.end() && pass == found->second) {
             // Generate and then add the cookie to cookie_map
-            std::string new_cookie = add_cookie(request.cookie());
+            std::string new_cookie = add_cookie(request.cookie().to_string());
 
             // Redirect to the original url and set the cookie
             // If the original request was login.html, don't redirect
@@ -205,9 +376,85 @@ RequestHandler::Status StaticFileHandler::HandleRequest(const Request& request,
     // Open file
     file_path = root + filename;
     std::cout << "StaticFileHandler: Handling request for " + file_path << std::endl;
-    Response::ResponseCode response_code = get_file(file_path, &contents);
+    std::string content_type = get_content_type(filename);
+
+    // Files are opened relative to the root, through the open file cache.
+    size_t start = filename.find_first_not_of('/');
+    std::string relative = start == std::string::npos ? "" : filename.substr(start);
+    if (archive) {
+        return archive_response(request, response, relative);
+    }
+
+    // Paths the index knows are missing are turned away before any syscall.
+    if (paths && !paths->may_exist(relative)) {
+        std::cout << "StaticFileHandler: File not found: " + file_path << std::endl;
+        return RequestHandler::Status::FILE_NOT_FOUND;
+    }
+    OpenFileCache::File opened;
+    bool has_stat = open_files->open(relative, &opened);
+    const struct stat& st = opened.st;
+
+    // A precompressed copy next to the file ("foo.css.gz") is sent in its
+    // place to clients that accept its encoding.
+    SidecarIndex::Sidecars sidecars;
+    if (has_stat && content_type != TYPE_MD) {
+        sidecars = SidecarIndex::GetInstance().find(file_path, st);
+    }
+    SidecarIndex::Encoding encoding = choose_sidecar(request, sidecars);
+
+    // The validators come from the stat alone, so a client that already has
+    // the file is answered before any of it is read.
+    std::string etag;
+    std::string last_modified;
+    if (has_stat) {
+        etag = make_etag(st, encoding);
+        last_modified = http_date::format(st.st_mtime);
+        if (response->GetHeader("Location") == "" && not_modified(request, etag, st.st_mtime)) {
+            response->SetStatus(Response::ResponseCode::NOT_MODIFIED);
+            response->AddHeader("ETag", etag);
+            response->AddHeader("Last-Modified", last_modified);
+            if (sidecars.any()) {
+                response->AddHeader("Vary", "Accept-Encoding");
+            }
+            return RequestHandler::Status::OK;
+        }
+    }
+
+    // Large files are sent with sendfile() rather than read into memory.
+    std::shared_ptr<const FileBody> file;
+    FileCache::Contents contents;
+    auto open_file = [&](const std::string& path, const OpenFileCache::File& open) {
+        if (static_cast<size_t>(open.st.st_size) >= sendfile_threshold) {
+            file = open.body;
+        } else {
+            contents = FileCache::GetInstance().get(path, *open.body, open.st);
+        }
+    };
 
-    if (response_code != Response::ResponseCode::OK) {
+    if (content_type == TYPE_MD) {
+        // Markdown is served from its cached rendering.
+        if (has_stat) {
+            contents = MarkdownCache::GetInstance().get(file_path, st);
+        }
+    } else if (encoding == SidecarIndex::NUM_ENCODINGS) {
+        if (has_stat) {
+            open_file(file_path, opened);
+        }
+    } else {
+        OpenFileCache::File sidecar;
+        if (open_files->open(relative + SidecarIndex::extension(encoding), &sidecar)) {
+            open_file(file_path + SidecarIndex::extension(encoding), sidecar);
+        } else {
+            // The copy has gone since it was indexed; send the file itself.
+            SidecarIndex::GetInstance().forget(file_path);
+            encoding = SidecarIndex::NUM_ENCODINGS;
+            etag = make_etag(st, encoding);
+            open_file(file_path, opened);
+        }
+    }
+    Response::ResponseCode response_code = Response::ResponseCode::OK;
+
+    if (!file && !contents) {
         response = nullptr;
         std::cout << "StaticFileHandler: File not found: " + file_path << std::endl;
         return RequestHandler::Status::FILE_NOT_FOUND;
@@ -222,61 +469,181 @@ RequestHandler::Status StaticFileHandler::HandleRequest(const Request& request,
         response->SetStatus(Response::ResponseCode::FOUND);
     }
 
-    std::string content_type = get_content_type(filename);
+    if (!etag.empty()) {
+        response->AddHeader("ETag", etag);
+        response->AddHeader("Last-Modified", last_modified);
+    }
+    if (encoding != SidecarIndex::NUM_ENCODINGS) {
+        response->AddHeader("Content-Encoding", SidecarIndex::coding(encoding));
+    }
+    if (sidecars.any()) {
+        response->AddHeader("Vary", "Accept-Encoding");
+    }
+
     //check for markdown type before setting to html
-    if (content_type == "text/markdown") {
-        response->AddHeader("Content-Type", "text/html");
-    } else {
-        response->AddHeader("Content-Type", content_type);
-        response->AddHeader("Content-Length", std::to_string(contents.length()));
-    }
-    // Set response body
-    if (content_type == "text/markdown") {
-        markdown::Document doc;
-        doc.read(contents);
-        std::ostringstream stream;
-        doc.write(stream);
-        std::string markdown = stream.str();
-        //add github styling to markdown
-        markdown.insert(0,
-            "<link rel=\"stylesheet\" href=\"markdown.css\">"
-            "<style>"
-                ".markdown-body {"
-                   "box-sizing: border-box;"
-                    "min-width: 200px;"
-                    "max-width: 980px;"
-                    "margin: 0 auto;"
-                    "padding: 45px;"
-                "}"
-            "</style>"
-            "<body class=\"markdown-body\">");
-        markdown.append("</body>");
-        //add content length after html is generated
-        response->AddHeader("Content-Length", std::to_string(markdown.length()));
-        response->SetBody(markdown);
+    if (content_type != "text/markdown") {
+        Body body;
+        body.file = file;
+        body.contents = contents;
+        return set_file_response(request, response, content_type, body, etag, last_modified);
+    }
 
-    } else {
-        response->SetBody(contents);
+    response->AddHeader("Content-Type", "text/html");
+    response->AddHeader("Content-Length", std::to_string(contents->length()));
+    response->SetBody(contents);
+
+    return RequestHandler::Status::OK;
+}
+
+RequestHandler::Status StaticFileHandler::archive_response(const Request& request, Response* response,
+                                                           const std::string& path) {
+    const StaticArchive::Entry* entry = archive->find(path);
+    if (!entry) {
+        std::cout << "StaticFileHandler: File not found in archive: " + path << std::endl;
+        return RequestHandler::Status::FILE_NOT_FOUND;
+    }
+
+    // Packed copies are chosen and validated like sidecars on disk.
+    SidecarIndex::Sidecars sidecars = entry->sidecars();
+    SidecarIndex::Encoding encoding = choose_sidecar(request, sidecars);
+    std::string etag = entry->etag.to_string();
+    if (encoding != SidecarIndex::NUM_ENCODINGS && !etag.empty()) {
+        etag.insert(etag.size() - 1, std::string("-") + SidecarIndex::coding(encoding));
+    }
+    std::string last_modified = http_date::format(entry->last_modified);
+
+    bool redirect = response->GetHeader("Location") != "";
+    if (!redirect && not_modified(request, etag, entry->last_modified)) {
+        response->SetStatus(Response::ResponseCode::NOT_MODIFIED);
+        response->AddHeader("ETag", etag);
+        response->AddHeader("Last-Modified", last_modified);
+        if (sidecars.any()) {
+            response->AddHeader("Vary", "Accept-Encoding");
+        }
+        return RequestHandler::Status::OK;
+    }
+
+    response->SetStatus(redirect ? Response::ResponseCode::FOUND : Response::ResponseCode::OK);
+    response->AddHeader("ETag", etag);
+    response->AddHeader("Last-Modified", last_modified);
+    if (encoding != SidecarIndex::NUM_ENCODINGS) {
+        response->AddHeader("Content-Encoding", SidecarIndex::coding(encoding));
+    }
+    if (sidecars.any()) {
+        response->AddHeader("Vary", "Accept-Encoding");
+    }
+
+    Body body;
+    body.owner = archive;
+    body.data = encoding == SidecarIndex::NUM_ENCODINGS ? entry->body : entry->encoded[encoding];
+    return set_file_response(request, response, entry->content_type.to_string(), body, etag, last_modified);
+}
+
+size_t StaticFileHandler::Body::length() const {
+    if (file) {
+        return file->length();
+    }
+    return contents ? contents->length() : data.size();
+}
+
+RequestHandler::Status StaticFileHandler::set_file_response(const Request& request, Response* response,
+                                                            const std::string& content_type, const Body& body,
+                                                            const std::string& etag,
+                                                            const std::string& last_modified) {
+    size_t length = body.length();
+    response->AddHeader("Content-Type", content_type);
+    response->AddHeader("Accept-Ranges", "bytes");
+
+    // Sends part of the body without copying it.
+    auto set_body = [&body, response](size_t offset, size_t part_length) {
+        if (body.file) {
+            response->SetFileBody(body.file, offset, part_length);
+        } else if (body.contents) {
+            response->SetBody(body.contents, offset, part_length);
+        } else {
+            response->SetBody(body.owner, body.data.substr(offset, part_length));
+        }
+    };
+
+    // Only a plain GET of the file can ask for part of it. If-Range makes
+    // that conditional on the file being unchanged since the client saw it,
+    // by strong comparison of either validator.
+    std::vector<byte_range::Range> ranges;
+    byte_range::Result range_result = byte_range::IGNORE;
+    const boost::string_ref* range = request.headers().find("Range");
+    const boost::string_ref* if_range = request.headers().find("If-Range");
+    if (range && request.method() == "GET" && response->status_code() == Response::ResponseCode::OK &&
+        (!if_range || (!etag.empty() && (*if_range == etag || *if_range == last_modified)))) {
+        range_result = byte_range::parse(*range, length, &ranges);
+    }
+
+    if (range_result == byte_range::NOT_SATISFIABLE) {
+        response->SetStatus(Response::ResponseCode::RANGE_NOT_SATISFIABLE);
+        response->AddHeader("Content-Range", byte_range::unsatisfied_range(length));
+        response->AddHeader("Content-Length", "0");
+        return RequestHandler::Status::OK;
     }
 
+    if (range_result == byte_range::SATISFIABLE && ranges.size() == 1) {
+        // A single range is sent straight from the file or memory.
+        const byte_range::Range& part = ranges[0];
+        response->SetStatus(Response::ResponseCode::PARTIAL_CONTENT);
+        response->AddHeader("Content-Range", byte_range::content_range(part, length));
+        response->AddHeader("Content-Length", std::to_string(part.length()));
+        set_body(part.first, part.length());
+        return RequestHandler::Status::OK;
+    }
+
+    if (range_result == byte_range::SATISFIABLE) {
+        // Several ranges are copied into a multipart body, reading only the
+        // requested bytes. Ranges of a large file that add up to more than
+        // the sendfile threshold would need too much memory, so the whole
+        // file is sent instead, as RFC 7233 allows.
+        size_t total = 0;
+        for (auto& part : ranges) {
+            total += part.length();
+        }
+
+        if (!body.file || total < sendfile_threshold) {
+            std::string boundary = gen_cookie(24);
+            std::string multipart;
+            multipart.reserve(total + ranges.size() * (boundary.size() + content_type.size() + 80));
+            for (auto& part : ranges) {
+                multipart.append("\r\n--").append(boundary).append("\r\n");
+                multipart.append("Content-Type: ").append(content_type).append("\r\n");
+                multipart.append("Content-Range: ").append(byte_range::content_range(part, length)).append("\r\n\r\n");
+                if (body.file) {
+                    multipart.append(body.file->Read(part.first, part.length()));
+                } else if (body.contents) {
+                    multipart.append(*body.contents, part.first, part.length());
+                } else {
+                    multipart.append(body.data.data() + part.first, part.length());
+                }
+            }
+            multipart.append("\r\n--").append(boundary).append("--\r\n");
+
+            response->SetStatus(Response::ResponseCode::PARTIAL_CONTENT);
+            response->SetHeader("Content-Type", "multipart/byteranges; boundary=" + boundary);
+            response->AddHeader("Content-Length", std::to_string(multipart.length()));
+            response->SetBody(multipart);
+            return RequestHandler::Status::OK;
+        }
+    }
+
+    response->AddHeader("Content-Length", std::to_string(length));
+    set_body(0, length);
     return RequestHandler::Status::OK;
 }
 
 Response::ResponseCode StaticFileHandler::get_file(const std::string& file_path, std::string* contents) {
-    // Attempt to open file
-    std::ifstream in_stream(file_path.c_str(), std::ios::in | std::ios::binary);
+    FileCache::Contents cached = FileCache::GetInstance().get(file_path);
 
     // File doesn't exist
-    if (!in_stream) {
-        contents = nullptr;
+    if (!cached) {
         return Response::ResponseCode::NOT_FOUND;
     }
 
-    // Read file contents
-    std::stringstream sstr;
-    sstr << in_stream.rdbuf();
-    contents->assign(sstr.str());
-
+    contents->assign(*cached);
     return Response::ResponseCode::OK;
 }
 
@@ -354,7 +721,15 @@ bool StaticFileHandler::check_cookie(std::string cookie, Response* response) {
         response->AddHeader("Content-Type", "text/html");
         response->AddHeader("Content-Length", "228");
         std::string contents = "";
-        get_file(root + "/login.html", &contents);
+        if (archive) {
+            // An archive handler has no root; its login page is packed.
+            const StaticArchive::Entry* login = archive->find("login.html");
+            if (login) {
+                contents = login->body.to_string();
+            }
+        } else {
+            get_file(root + "/login.html", &contents);
+        }
         response->SetBody(contents);
         return false;
     }
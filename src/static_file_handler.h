@@ -1,8 +1,13 @@
 #ifndef STATIC_FILE_HANDLER_H
 #define STATIC_FILE_HANDLER_H
 
+#include "file_cache.h"
+#include "open_file_cache.h"
+#include "path_index.h"
+#include "static_archive.h"
 #include "request_handler.h"
 #include <time.h>
+#include <memory>
 #include <unordered_map>
 
 // FILE TYPES
@@ -14,6 +19,14 @@ const std::string TYPE_PDF   = "application/pdf";
 const std::string TYPE_PNG   = "image/png";
 const std::string TYPE_TXT   = "text/plain";
 const std::string TYPE_MD    = "text/markdown";
+const std::string TYPE_CSS   = "text/css";
+const std::string TYPE_JS    = "application/javascript";
+const std::string TYPE_JSON  = "application/json";
+const std::string TYPE_SVG   = "image/svg+xml";
+
+// Files at least this big are sent with sendfile() instead of being cached
+// in memory, unless the handler's config sets sendfile_threshold.
+const size_t DEFAULT_SENDFILE_THRESHOLD = 1024 * 1024;
 
 class StaticFileHandler : public RequestHandler {
  public:
@@ -28,9 +41,36 @@ class StaticFileHandler : public RequestHandler {
     bool check_cookie(std::string cookie, Response* response);
 
  private:
+    // A file's bytes: an open file sent with sendfile(), cached contents, or
+    // memory that owner keeps alive.
+    struct Body {
+        std::shared_ptr<const FileBody> file;
+        FileCache::Contents contents;
+        std::shared_ptr<const void> owner;
+        boost::string_ref data;
+
+        size_t length() const;
+    };
+
+    // Sends a file, or the parts of it the Range header asks for. The
+    // validators are empty if unknown.
+    RequestHandler::Status set_file_response(const Request& request, Response* response,
+                                             const std::string& content_type, const Body& body,
+                                             const std::string& etag,
+                                             const std::string& last_modified);
+    // Serves the file at path, relative to the root, from archive.
+    RequestHandler::Status archive_response(const Request& request, Response* response,
+                                            const std::string& path);
+
     std::string prefix;
     std::string root;
     time_t timeout;
+    size_t sendfile_threshold;
+    std::shared_ptr<OpenFileCache> open_files;
+    // Null if path_index_max is 0.
+    std::shared_ptr<PathIndex> paths;
+    // Set instead of root to serve a packed archive.
+    std::shared_ptr<const StaticArchive> archive;
     std::string original_uri;
     std::unordered_map<std::string, time_t> cookie_map;
     std::unordered_map<std::string, std::string> user_map;
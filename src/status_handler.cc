@@ -10,6 +10,7 @@ RequestHandler::Status StatusHandler::HandleRequest(const Request& request, Resp
     int num_requests = ServerStatusTracker::GetInstance().GetNumRequests();
     ServerStatusTracker::RequestList url_requests = ServerStatusTracker::GetInstance().GetRequests();
     ServerStatusTracker::HandlerList handlers = ServerStatusTracker::GetInstance().GetHandlers();
+    ServerStatusTracker::FileCacheStats file_cache = ServerStatusTracker::GetInstance().GetFileCacheStats();
 
     std::ostringstream contents; 
     contents << "<!DOCTYPE html><html>" <<
@@ -47,6 +48,15 @@ RequestHandler::Status StatusHandler::HandleRequest(const Request& request, Resp
     }
 
     contents << "</table>" <<
+                "<h2>File Cache</h2>" <<
+                "<table>" <<
+                "<tr><th>Hits</th><th>Misses</th><th>Evictions</th></tr>" <<
+                "<tr>" <<
+                "<td>" << file_cache.hits << "</td>" <<
+                "<td>" << file_cache.misses << "</td>" <<
+                "<td>" << file_cache.evictions << "</td>" <<
+                "</tr>" <<
+                "</table>" <<
                 "</body></html>";
 
     std::string status_page = contents.str();
@@ -41,6 +41,48 @@ TEST_F(LoadConfigTest, PortConfigTest) {
     EXPECT_EQ(8080, server.get_port());
 }
 
+//successful load config with worker threads and keep-alive settings
+TEST_F(LoadConfigTest, ConnectionConfigTest) {
+    //create a config
+    bool loaded_config = parse_load("threads 8; keepalive_timeout 10; keepalive_requests 50;");
+
+    //assert that config was loaded correctly
+    ASSERT_TRUE(loaded_config);
+    EXPECT_EQ(8, server.get_num_threads());
+    EXPECT_EQ(10, server.get_keepalive_timeout());
+    EXPECT_EQ(50, server.get_keepalive_requests());
+}
+
+//successful load config with request size limits
+TEST_F(LoadConfigTest, SizeLimitConfigTest) {
+    //create a config
+    bool loaded_config = parse_load("max_header_size 1024; max_body_size 4096;");
+
+    //assert that config was loaded correctly
+    ASSERT_TRUE(loaded_config);
+    EXPECT_EQ(1024, server.get_max_header_size());
+    EXPECT_EQ(4096, server.get_max_body_size());
+}
+
+//gzip settings load, and levels above 9 are rejected
+TEST_F(LoadConfigTest, GzipConfigTest) {
+    ASSERT_TRUE(parse_load("gzip_level 9; gzip_min_length 0; gzip_cache_size 1024;"));
+
+    std::stringstream config_stream("gzip_level 10;");
+    NginxConfig bad_config;
+    parser.Parse(&config_stream, &bad_config);
+    EXPECT_FALSE(server.load_configs(bad_config));
+}
+
+//unsuccessful load config with zero worker threads
+TEST_F(LoadConfigTest, ZeroThreadsConfigTest) {
+    //create a config
+    bool loaded_config = parse_load("threads 0;");
+
+    //assert that config was not loaded
+    ASSERT_FALSE(loaded_config);
+}
+
 //successful load config for EchoHandler
 TEST_F(LoadConfigTest, EchoConfigTest) {
     //create a config
@@ -206,3 +248,77 @@ TEST_F(PrefixHandlerTest, InvalidGetHandlerTest) {
     RequestHandler* handler = server.get_handler("/bar/a.txt");
     EXPECT_EQ(typeid(NotFoundHandler), typeid(*handler));
 }
+
+// Counts how many of its instances have been deleted
+class CountingHandler : public RequestHandler {
+public:
+    ~CountingHandler() {
+        deleted++;
+    }
+    Status Init(const std::string& uri_prefix, const NginxConfig& config) {
+        return OK;
+    }
+    Status HandleRequest(const Request& request, Response* response) {
+        return OK;
+    }
+    static int deleted;
+};
+int CountingHandler::deleted = 0;
+REGISTER_REQUEST_HANDLER(CountingHandler);
+
+class ReloadConfigTest : public ::testing::Test {
+public:
+    void write_config(std::string config) {
+        std::ofstream config_file("reload_config_test");
+        config_file << config;
+    }
+    void TearDown() {
+        std::remove("reload_config_test");
+    }
+protected:
+    Webserver server;
+};
+
+//successful reload swaps in the new handlers
+TEST_F(ReloadConfigTest, ValidReloadTest) {
+    write_config("path /foo EchoHandler {} default NotFoundHandler {}");
+    ASSERT_TRUE(server.parse_config("reload_config_test"));
+    std::shared_ptr<const HandlerTable> old_handlers = server.get_handlers();
+
+    write_config("port 8080; path /foo StaticFileHandler { root /foo/bar; } default NotFoundHandler {}");
+    ASSERT_TRUE(server.reload_config());
+
+    //new requests use the new handler, while old ones keep theirs
+    EXPECT_EQ(typeid(StaticFileHandler), typeid(*server.get_handler("/foo")));
+    EXPECT_EQ(typeid(EchoHandler), typeid(*old_handlers->find("/foo")));
+    EXPECT_EQ(8080, server.get_port());
+}
+
+//unsuccessful reload keeps the current config
+TEST_F(ReloadConfigTest, InvalidReloadTest) {
+    write_config("max_body_size 10; path /foo EchoHandler {}");
+    ASSERT_TRUE(server.parse_config("reload_config_test"));
+
+    write_config("max_body_size 20; path /foo EchoHandler {} path /foo EchoHandler {}");
+    EXPECT_FALSE(server.reload_config());
+    write_config("path /foo EchoHandler {");
+    EXPECT_FALSE(server.reload_config());
+
+    EXPECT_EQ(typeid(EchoHandler), typeid(*server.get_handler("/foo")));
+    EXPECT_EQ(10, server.get_max_body_size());
+}
+
+//old handlers are deleted once the last request holding them is done
+TEST_F(ReloadConfigTest, RetireHandlersTest) {
+    write_config("path /foo CountingHandler {}");
+    ASSERT_TRUE(server.parse_config("reload_config_test"));
+    std::shared_ptr<const HandlerTable> in_flight = server.get_handlers();
+    CountingHandler::deleted = 0;
+
+    write_config("path /foo EchoHandler {}");
+    ASSERT_TRUE(server.reload_config());
+    EXPECT_EQ(0, CountingHandler::deleted);
+
+    in_flight.reset();
+    EXPECT_EQ(1, CountingHandler::deleted);
+}
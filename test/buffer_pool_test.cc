@@ -0,0 +1,38 @@
+#include "gtest/gtest.h"
+#include "buffer_pool.h"
+
+// Released buffers are handed out again
+TEST(BufferPoolTest, ReuseBuffer) {
+    BufferPool pool(16);
+    std::string buffer = pool.acquire();
+    ASSERT_EQ(16, buffer.size());
+    const char* data = buffer.data();
+
+    pool.release(std::move(buffer));
+    EXPECT_EQ(1, pool.size());
+
+    std::string reused = pool.acquire();
+    EXPECT_EQ(data, reused.data());
+    EXPECT_EQ(0, pool.size());
+}
+
+// Buffers that grew too large are not kept
+TEST(BufferPoolTest, DropLargeBuffer) {
+    BufferPool pool(16, 8, 64);
+    std::string buffer = pool.acquire();
+    buffer.resize(128);
+
+    pool.release(std::move(buffer));
+    EXPECT_EQ(0, pool.size());
+}
+
+// The pool never holds more than max_buffers buffers
+TEST(BufferPoolTest, MaxBuffers) {
+    BufferPool pool(16, 2);
+    std::string a = pool.acquire(), b = pool.acquire(), c = pool.acquire();
+
+    pool.release(std::move(a));
+    pool.release(std::move(b));
+    pool.release(std::move(c));
+    EXPECT_EQ(2, pool.size());
+}
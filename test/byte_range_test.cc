@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+#include "byte_range.h"
+#include <vector>
+
+using byte_range::Range;
+
+std::vector<Range> parse(const std::string& header, size_t length, byte_range::Result expected) {
+    std::vector<Range> ranges;
+    EXPECT_EQ(expected, byte_range::parse(header, length, &ranges)) << header;
+    return ranges;
+}
+
+TEST(ByteRangeTest, SingleRanges) {
+    std::vector<Range> ranges = parse("bytes=0-99", 1000, byte_range::SATISFIABLE);
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_EQ(0u, ranges[0].first);
+    EXPECT_EQ(99u, ranges[0].last);
+    EXPECT_EQ(100u, ranges[0].length());
+
+    // Open-ended and suffix ranges, clamped to the file.
+    ranges = parse("bytes=900-", 1000, byte_range::SATISFIABLE);
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_EQ(900u, ranges[0].first);
+    EXPECT_EQ(999u, ranges[0].last);
+
+    ranges = parse("Bytes=-50", 1000, byte_range::SATISFIABLE);
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_EQ(950u, ranges[0].first);
+    EXPECT_EQ(999u, ranges[0].last);
+
+    ranges = parse("bytes=990-2000", 1000, byte_range::SATISFIABLE);
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_EQ(990u, ranges[0].first);
+    EXPECT_EQ(999u, ranges[0].last);
+
+    ranges = parse("bytes=-5000", 1000, byte_range::SATISFIABLE);
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_EQ(0u, ranges[0].first);
+    EXPECT_EQ(999u, ranges[0].last);
+}
+
+TEST(ByteRangeTest, MultipleRangesAreSortedAndMerged) {
+    std::vector<Range> ranges = parse("bytes=500-599, 0-9,5-19,20-29,-10", 1000, byte_range::SATISFIABLE);
+    ASSERT_EQ(3u, ranges.size());
+    EXPECT_EQ(0u, ranges[0].first);
+    EXPECT_EQ(29u, ranges[0].last);
+    EXPECT_EQ(500u, ranges[1].first);
+    EXPECT_EQ(599u, ranges[1].last);
+    EXPECT_EQ(990u, ranges[2].first);
+    EXPECT_EQ(999u, ranges[2].last);
+
+    // Unsatisfiable ranges are dropped if any other is satisfiable.
+    ranges = parse("bytes=2000-3000,10-19", 1000, byte_range::SATISFIABLE);
+    ASSERT_EQ(1u, ranges.size());
+    EXPECT_EQ(10u, ranges[0].first);
+}
+
+TEST(ByteRangeTest, NotSatisfiable) {
+    parse("bytes=1000-", 1000, byte_range::NOT_SATISFIABLE);
+    parse("bytes=1000-1001,2000-", 1000, byte_range::NOT_SATISFIABLE);
+    parse("bytes=-0", 1000, byte_range::NOT_SATISFIABLE);
+    parse("bytes=0-", 0, byte_range::NOT_SATISFIABLE);
+}
+
+TEST(ByteRangeTest, IgnoresMalformedHeaders) {
+    parse("", 1000, byte_range::IGNORE);
+    parse("bytes=", 1000, byte_range::IGNORE);
+    parse("items=0-9", 1000, byte_range::IGNORE);
+    parse("bytes=9-0", 1000, byte_range::IGNORE);
+    parse("bytes=a-9", 1000, byte_range::IGNORE);
+    parse("bytes=0-9,", 1000, byte_range::IGNORE);
+    parse("bytes=-", 1000, byte_range::IGNORE);
+    parse("bytes=0-99999999999999999999999", 1000, byte_range::IGNORE);
+
+    std::string many = "bytes=0-0";
+    for (size_t i = 1; i <= byte_range::MAX_RANGES; i++) {
+        many += "," + std::to_string(i * 2) + "-" + std::to_string(i * 2);
+    }
+    parse(many, 1000, byte_range::IGNORE);
+}
+
+TEST(ByteRangeTest, ContentRange) {
+    EXPECT_EQ("bytes 0-99/1000", byte_range::content_range(Range{0, 99}, 1000));
+    EXPECT_EQ("bytes */1000", byte_range::unsatisfied_range(1000));
+}
@@ -0,0 +1,32 @@
+#include "gtest/gtest.h"
+#include "connection.h"
+#include "request_handler.h"
+
+// HTTP/1.1 connections persist by default
+TEST(ConnectionTest, KeepAliveDefault11) {
+    auto req = Request::Parse("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    ASSERT_TRUE(req);
+    EXPECT_TRUE(Connection::wants_keep_alive(*req));
+}
+
+// HTTP/1.0 connections close by default
+TEST(ConnectionTest, KeepAliveDefault10) {
+    auto req = Request::Parse("GET / HTTP/1.0\r\nHost: localhost\r\n\r\n");
+    ASSERT_TRUE(req);
+    EXPECT_FALSE(Connection::wants_keep_alive(*req));
+}
+
+// Connection: close ends an HTTP/1.1 connection
+TEST(ConnectionTest, ConnectionClose) {
+    auto req = Request::Parse("GET / HTTP/1.1\r\nConnection: close\r\n\r\n");
+    ASSERT_TRUE(req);
+    EXPECT_FALSE(Connection::wants_keep_alive(*req));
+}
+
+// Connection: keep-alive persists an HTTP/1.0 connection, in any case
+TEST(ConnectionTest, ConnectionKeepAlive) {
+    auto req = Request::Parse("GET / HTTP/1.0\r\nconnection: Keep-Alive\r\n\r\n");
+    ASSERT_TRUE(req);
+    EXPECT_TRUE(Connection::wants_keep_alive(*req));
+}
+
@@ -0,0 +1,33 @@
+#include "gtest/gtest.h"
+#include "content_coding.h"
+
+bool accepts(boost::string_ref header, boost::string_ref coding) {
+    return content_coding::accepts(&header, coding);
+}
+
+TEST(ContentCodingTest, ListedCodings) {
+    EXPECT_TRUE(accepts("gzip, deflate, br", "gzip"));
+    EXPECT_TRUE(accepts("gzip, deflate, br", "br"));
+    EXPECT_TRUE(accepts("GZIP", "gzip"));
+    EXPECT_TRUE(accepts("deflate;q=0.5 , gzip ; q=1.0", "gzip"));
+    EXPECT_FALSE(accepts("gzip, deflate", "br"));
+    EXPECT_FALSE(accepts("", "gzip"));
+    EXPECT_FALSE(accepts("gzipped", "gzip"));
+    EXPECT_FALSE(content_coding::accepts(nullptr, "gzip"));
+}
+
+TEST(ContentCodingTest, ZeroQualityRefuses) {
+    EXPECT_FALSE(accepts("gzip;q=0", "gzip"));
+    EXPECT_FALSE(accepts("br, gzip;Q=0.000", "gzip"));
+    EXPECT_TRUE(accepts("gzip;q=0.001", "gzip"));
+    EXPECT_TRUE(accepts("gzip;level=1;q=0.5", "gzip"));
+}
+
+TEST(ContentCodingTest, Wildcard) {
+    EXPECT_TRUE(accepts("*", "br"));
+    EXPECT_TRUE(accepts("identity, *;q=0.1", "gzip"));
+    EXPECT_FALSE(accepts("*;q=0", "gzip"));
+    // An explicit entry overrides the wildcard either way.
+    EXPECT_FALSE(accepts("*, gzip;q=0", "gzip"));
+    EXPECT_TRUE(accepts("gzip, *;q=0", "gzip"));
+}
@@ -0,0 +1,86 @@
+#include "gtest/gtest.h"
+#include "delimiter_scan.h"
+#include <string>
+#include <vector>
+
+using namespace delimiter_scan;
+
+class DelimiterScanTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        use_kernel(best_kernel());
+    }
+
+    // Every kernel this CPU can run.
+    std::vector<Kernel> Kernels() {
+        std::vector<Kernel> kernels;
+        for (Kernel kernel : {SCALAR, SSE42, AVX2}) {
+            if (use_kernel(kernel)) {
+                kernels.push_back(kernel);
+            }
+        }
+        return kernels;
+    }
+
+    // Header-like filler, including tabs and non-ASCII bytes that never match.
+    std::string Filler(size_t length) {
+        const std::string chars = "abcXYZ019 \t;=/-\x80\xff";
+        std::string filler;
+        for (size_t i = 0; i < length; i++) {
+            filler += chars[(i * 7) % chars.size()];
+        }
+        return filler;
+    }
+};
+
+TEST_F(DelimiterScanTest, ScalarAlwaysSupported) {
+    EXPECT_TRUE(use_kernel(SCALAR));
+    EXPECT_EQ(SCALAR, kernel());
+}
+
+// Every kernel finds the first delimiter wherever it falls, including
+// across vector boundaries and in the scalar tail.
+TEST_F(DelimiterScanTest, FindsFirstMatch) {
+    for (Kernel k : Kernels()) {
+        ASSERT_TRUE(use_kernel(k));
+        for (size_t length = 0; length < 100; length++) {
+            std::string filler = Filler(length);
+            const char* begin = filler.data();
+            const char* end = begin + filler.size();
+
+            EXPECT_EQ(end, find_control(begin, end)) << "kernel " << k << " length " << length;
+            EXPECT_EQ(end, find_char(begin, end, ':')) << "kernel " << k << " length " << length;
+
+            for (size_t pos = 0; pos < length; pos++) {
+                for (char delimiter : {'\r', '\n', '\0', '\x7f'}) {
+                    std::string s = filler;
+                    s[pos] = delimiter;
+                    s += "\r\n";
+                    EXPECT_EQ(pos, find_control(s.data(), s.data() + s.size()) - s.data())
+                        << "kernel " << k << " length " << length << " pos " << pos;
+                }
+
+                std::string s = filler;
+                s[pos] = ':';
+                EXPECT_EQ(pos, find_char(s.data(), s.data() + s.size(), ':') - s.data())
+                    << "kernel " << k << " length " << length << " pos " << pos;
+            }
+        }
+    }
+}
+
+// Spaces only end a search in find_space_or_control.
+TEST_F(DelimiterScanTest, FindsSpaces) {
+    for (Kernel k : Kernels()) {
+        ASSERT_TRUE(use_kernel(k));
+        for (size_t length = 1; length < 100; length++) {
+            std::string s(length, 'a');
+            s[length - 1] = ' ';
+            s[length / 2] = ' ';
+            const char* end = s.data() + s.size();
+
+            EXPECT_EQ(length / 2, find_space_or_control(s.data(), end) - s.data()) << "kernel " << k;
+            EXPECT_EQ(end, find_control(s.data(), end)) << "kernel " << k;
+        }
+    }
+}
@@ -6,7 +6,7 @@ using ::testing::Return;
 
 class MockRequest : public Request {
 public:
-    MOCK_CONST_METHOD0(raw_request, std::string());
+    MOCK_CONST_METHOD0(raw_request, boost::string_ref());
 };
 
 // Basic echo request
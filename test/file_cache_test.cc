@@ -0,0 +1,140 @@
+#include "gtest/gtest.h"
+#include "file_cache.h"
+#include "server_status_tracker.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+class FileCacheTest : public ::testing::Test {
+protected:
+    void WriteFile(const std::string& path, const std::string& contents) {
+        std::ofstream file(path, std::ios::binary);
+        file << contents;
+    }
+
+    std::string Name(int i) {
+        return "file_cache_" + std::to_string(i) + ".txt";
+    }
+
+    void TearDown() {
+        std::remove("file_cache_a.txt");
+        for (int i = 0; i < 9; i++) {
+            std::remove(Name(i).c_str());
+        }
+    }
+
+    // Counters recorded since the start of the test
+    ServerStatusTracker::FileCacheStats Stats() {
+        ServerStatusTracker::FileCacheStats now = ServerStatusTracker::GetInstance().GetFileCacheStats();
+        ServerStatusTracker::FileCacheStats stats = {now.hits - start_.hits, now.misses - start_.misses,
+                                                     now.evictions - start_.evictions};
+        return stats;
+    }
+
+    ServerStatusTracker::FileCacheStats start_ = ServerStatusTracker::GetInstance().GetFileCacheStats();
+};
+
+// The second lookup shares the first one's contents
+TEST_F(FileCacheTest, Hit) {
+    FileCache cache(1024);
+    WriteFile("file_cache_a.txt", "hello");
+
+    FileCache::Contents first = cache.get("file_cache_a.txt");
+    FileCache::Contents second = cache.get("file_cache_a.txt");
+
+    ASSERT_TRUE(first);
+    EXPECT_EQ("hello", *first);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(5, cache.size());
+    EXPECT_EQ(1, Stats().hits);
+    EXPECT_EQ(1, Stats().misses);
+}
+
+// Missing files and directories aren't found
+TEST_F(FileCacheTest, Missing) {
+    FileCache cache(1024);
+
+    EXPECT_FALSE(cache.get("file_cache_missing.txt"));
+    EXPECT_FALSE(cache.get("."));
+    EXPECT_EQ(0, cache.num_entries());
+}
+
+// A changed or deleted file is read again
+TEST_F(FileCacheTest, Revalidate) {
+    FileCache cache(1024);
+    WriteFile("file_cache_a.txt", "hello");
+    FileCache::Contents old_contents = cache.get("file_cache_a.txt");
+
+    WriteFile("file_cache_a.txt", "goodbye");
+    FileCache::Contents new_contents = cache.get("file_cache_a.txt");
+
+    ASSERT_TRUE(new_contents);
+    EXPECT_EQ("goodbye", *new_contents);
+    EXPECT_EQ("hello", *old_contents);
+    EXPECT_EQ(7, cache.size());
+
+    std::remove("file_cache_a.txt");
+    EXPECT_FALSE(cache.get("file_cache_a.txt"));
+    EXPECT_EQ(0, cache.size());
+}
+
+// The least recently used file is evicted first
+TEST_F(FileCacheTest, Evict) {
+    FileCache cache(80);
+    for (int i = 0; i < 9; i++) {
+        WriteFile(Name(i), std::string(10, 'a' + i));
+    }
+
+    // Fill the cache, then use the first file again
+    for (int i = 0; i < 8; i++) {
+        cache.get(Name(i));
+    }
+    cache.get(Name(0));
+    EXPECT_EQ(80, cache.size());
+    EXPECT_EQ(0, Stats().evictions);
+
+    cache.get(Name(8));
+    EXPECT_EQ(1, Stats().evictions);
+    EXPECT_EQ(8, cache.num_entries());
+    EXPECT_EQ(9, Stats().misses);
+
+    cache.get(Name(0));
+    EXPECT_EQ(9, Stats().misses);
+    cache.get(Name(1));
+    EXPECT_EQ(10, Stats().misses);
+
+    // Shrinking the cache evicts too
+    cache.set_capacity(40);
+    EXPECT_EQ(4, cache.num_entries());
+}
+
+// Files too big for the cache are still read
+TEST_F(FileCacheTest, Uncached) {
+    FileCache cache(80);
+    WriteFile("file_cache_a.txt", std::string(11, 'a'));
+
+    FileCache::Contents contents = cache.get("file_cache_a.txt");
+
+    ASSERT_TRUE(contents);
+    EXPECT_EQ(11, contents->size());
+    EXPECT_EQ(0, cache.num_entries());
+}
+
+// A file that is already open is validated against the given stat and read
+// from its descriptor
+TEST_F(FileCacheTest, OpenFile) {
+    FileCache cache(1024);
+    WriteFile("file_cache_a.txt", "hello");
+    std::shared_ptr<const FileBody> file = FileBody::Open("file_cache_a.txt");
+    ASSERT_TRUE(file);
+    struct stat st;
+    ASSERT_EQ(0, stat("file_cache_a.txt", &st));
+
+    FileCache::Contents first = cache.get("file_cache_a.txt", *file, st);
+    ASSERT_TRUE(first);
+    EXPECT_EQ("hello", *first);
+    EXPECT_EQ(first, cache.get("file_cache_a.txt", *file, st));
+    EXPECT_EQ(first, cache.get("file_cache_a.txt"));
+    EXPECT_EQ(1u, Stats().misses);
+    EXPECT_EQ(2u, Stats().hits);
+}
@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+#include "header_map.h"
+#include <string>
+
+// Common names are interned regardless of case
+TEST(HeaderNamesTest, Intern) {
+    EXPECT_EQ(header_names::CONTENT_LENGTH, header_names::intern("Content-Length"));
+    EXPECT_EQ(header_names::CONTENT_LENGTH, header_names::intern("content-LENGTH"));
+    EXPECT_EQ(header_names::COOKIE, header_names::intern("cookie"));
+    EXPECT_EQ(header_names::OTHER, header_names::intern("X-Forwarded-For"));
+    EXPECT_EQ(header_names::OTHER, header_names::intern("Content-Lengths"));
+    EXPECT_EQ("Set-Cookie", header_names::canonical(header_names::SET_COOKIE));
+}
+
+// Lookups ignore case for interned and other names
+TEST(HeaderMapTest, Find) {
+    HeaderMap headers;
+    headers.add("Content-Type", "text/html");
+    headers.add("X-Request-Id", "42");
+
+    ASSERT_TRUE(headers.find("content-type"));
+    EXPECT_EQ("text/html", *headers.find("content-type"));
+    ASSERT_TRUE(headers.find("x-request-id"));
+    EXPECT_EQ("42", *headers.find("X-REQUEST-ID"));
+    EXPECT_FALSE(headers.find("Location"));
+    EXPECT_FALSE(headers.find("X-Other"));
+
+    // Adding a header after a lookup of an uninterned name is still found
+    headers.add("X-Other", "1");
+    EXPECT_TRUE(headers.contains("x-other"));
+}
+
+// Entries keep their insertion order, and repeated headers keep every value
+TEST(HeaderMapTest, Order) {
+    HeaderMap headers;
+    headers.add("Set-Cookie", "a=1");
+    headers.add("X-B", "b");
+    headers.add("set-cookie", "c=3");
+
+    ASSERT_EQ(3, headers.size());
+    EXPECT_EQ("Set-Cookie", headers[0].first);
+    EXPECT_EQ("X-B", headers[1].first);
+    EXPECT_EQ("c=3", headers[2].second);
+    EXPECT_EQ("a=1", *headers.find("Set-Cookie"));
+}
+
+// set() replaces every value in place of the first; remove() drops them all
+TEST(HeaderMapTest, SetAndRemove) {
+    HeaderMap headers;
+    headers.add("Host", "a");
+    headers.add("X-Dup", "1");
+    headers.add("Accept", "*/*");
+    headers.add("x-dup", "2");
+
+    headers.set("X-DUP", "3");
+    ASSERT_EQ(3, headers.size());
+    EXPECT_EQ("X-Dup", headers[1].first);
+    EXPECT_EQ("3", headers[1].second);
+
+    headers.set("Location", "/");
+    EXPECT_EQ("Location", headers[3].first);
+
+    EXPECT_EQ(1, headers.remove("host"));
+    EXPECT_EQ(0, headers.remove("host"));
+    EXPECT_FALSE(headers.contains("Host"));
+    EXPECT_EQ("*/*", *headers.find("Accept"));
+    EXPECT_EQ("3", *headers.find("x-dup"));
+    EXPECT_EQ("X-Dup", headers[0].first);
+}
+
+// Views into a buffer work the same way
+TEST(HeaderMapTest, Views) {
+    std::string buffer = "COOKIE: private=1";
+    BasicHeaderMap<boost::string_ref> headers;
+    headers.add(boost::string_ref(buffer).substr(0, 6), boost::string_ref(buffer).substr(8));
+
+    ASSERT_TRUE(headers.find("Cookie"));
+    EXPECT_EQ("private=1", *headers.find("Cookie"));
+    EXPECT_EQ(buffer.data() + 8, headers.find("Cookie")->data());
+}
+
+// Many uninterned names
+TEST(HeaderMapTest, ManyHeaders) {
+    HeaderMap headers;
+    for (int i = 0; i < 200; i++) {
+        headers.add("X-Header-" + std::to_string(i), std::to_string(i));
+    }
+    for (int i = 0; i < 200; i++) {
+        ASSERT_TRUE(headers.find("x-header-" + std::to_string(i)));
+        EXPECT_EQ(std::to_string(i), *headers.find("X-HEADER-" + std::to_string(i)));
+    }
+    EXPECT_FALSE(headers.find("X-Header-200"));
+}
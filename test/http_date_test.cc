@@ -0,0 +1,29 @@
+#include "gtest/gtest.h"
+#include "http_date.h"
+
+TEST(HttpDateTest, Format) {
+    EXPECT_EQ("Thu, 01 Jan 1970 00:00:00 GMT", http_date::format(0));
+    EXPECT_EQ("Sun, 06 Nov 1994 08:49:37 GMT", http_date::format(784111777));
+}
+
+TEST(HttpDateTest, ParseAllThreeForms) {
+    for (const char* date : {"Sun, 06 Nov 1994 08:49:37 GMT", "Sunday, 06-Nov-94 08:49:37 GMT",
+                             "Sun Nov  6 08:49:37 1994"}) {
+        time_t time = 0;
+        EXPECT_TRUE(http_date::parse(date, &time)) << date;
+        EXPECT_EQ(784111777, time) << date;
+    }
+
+    time_t time = 0;
+    EXPECT_TRUE(http_date::parse(http_date::format(1700000000), &time));
+    EXPECT_EQ(1700000000, time);
+}
+
+TEST(HttpDateTest, ParseRejectsOtherText) {
+    time_t time = 0;
+    for (const char* date : {"", "yesterday", "Sun, 06 Nov 1994 08:49:37", "Sun, 06 Nov 1994 08:49:37 GMT ",
+                             "Sun, 6 Nov 1994 08:49:37 GMT", "Sun, 06 Foo 1994 08:49:37 GMT",
+                             "Sun, 06 Nov 1994 25:49:37 GMT", "1994-11-06T08:49:37Z"}) {
+        EXPECT_FALSE(http_date::parse(date, &time)) << date;
+    }
+}
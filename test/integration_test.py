@@ -2,6 +2,7 @@ from subprocess import *
 from sys import exit
 import os
 import shutil
+import socket
 
 # Kills the server before exiting with given return value
 def exit_test(server, return_val):
@@ -74,6 +75,24 @@ def main():
     print('Checking response output...')
     expected_output(out, expected, server)
 
+    ### KEEP-ALIVE ###
+    print('Sending two requests on one connection...')
+    request = b'GET /static/asdf.txt HTTP/1.1\r\nHost: localhost\r\n\r\n'
+    expected = b'HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 4\r\nConnection: keep-alive\r\n\r\nasdf'
+    sock = socket.create_connection(('localhost', 8080))
+    for i in range(2):
+        sock.sendall(request)
+        out = b''
+        while len(out) < len(expected):
+            data = sock.recv(4096)
+            if not data:
+                break
+            out += data
+
+        print('Checking response output...')
+        expected_output(out, expected, server)
+    sock.close()
+
     ### MULTITHREADING ###
     print('Opening connection and sending file request...')
     Popen(['nc', 'localhost', '8080'], stdout=DEVNULL)
@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include "markdown_cache.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+class MarkdownCacheTest : public ::testing::Test {
+protected:
+    void WriteFile(const std::string& path, const std::string& contents) {
+        std::ofstream file(path, std::ios::binary);
+        file << contents;
+    }
+
+    struct stat Stat(const std::string& path) {
+        struct stat st;
+        EXPECT_EQ(0, stat(path.c_str(), &st));
+        return st;
+    }
+
+    void TearDown() {
+        std::remove("markdown_cache_a.md");
+        std::remove("markdown_cache_dir/sub/b.md");
+        std::remove("markdown_cache_dir/sub/c.txt");
+        std::remove("markdown_cache_dir/.hidden/d.md");
+        std::remove("markdown_cache_dir/a.md");
+        rmdir("markdown_cache_dir/sub");
+        rmdir("markdown_cache_dir/.hidden");
+        rmdir("markdown_cache_dir");
+    }
+};
+
+TEST_F(MarkdownCacheTest, RendersWithStylesheet) {
+    std::string page = MarkdownCache::render("# Title\n");
+    EXPECT_EQ(0u, page.find("<link rel=\"stylesheet\" href=\"markdown.css\">"));
+    EXPECT_NE(std::string::npos, page.find("<body class=\"markdown-body\"><h1>Title</h1>"));
+    EXPECT_EQ("</body>", page.substr(page.size() - 7));
+}
+
+// A page is rendered once and shared until its file changes
+TEST_F(MarkdownCacheTest, RendersOnce) {
+    MarkdownCache cache;
+    WriteFile("markdown_cache_a.md", "# One\n");
+
+    MarkdownCache::Page first = cache.get("markdown_cache_a.md", Stat("markdown_cache_a.md"));
+    ASSERT_TRUE(first);
+    EXPECT_EQ(MarkdownCache::render("# One\n"), *first);
+    EXPECT_EQ(first, cache.get("markdown_cache_a.md", Stat("markdown_cache_a.md")));
+    EXPECT_EQ(1u, cache.num_entries());
+    EXPECT_EQ(first->size(), cache.size());
+
+    WriteFile("markdown_cache_a.md", "# Two, longer\n");
+    MarkdownCache::Page second = cache.get("markdown_cache_a.md", Stat("markdown_cache_a.md"));
+    ASSERT_TRUE(second);
+    EXPECT_EQ(MarkdownCache::render("# Two, longer\n"), *second);
+    EXPECT_EQ(1u, cache.num_entries());
+
+    struct stat st = Stat("markdown_cache_a.md");
+    std::remove("markdown_cache_a.md");
+    st.st_size++;
+    EXPECT_FALSE(cache.get("markdown_cache_a.md", st));
+    EXPECT_EQ(0u, cache.num_entries());
+}
+
+// Warming renders markdown below a root, but not hidden files or other types
+TEST_F(MarkdownCacheTest, Warm) {
+    ASSERT_EQ(0, mkdir("markdown_cache_dir", 0755));
+    ASSERT_EQ(0, mkdir("markdown_cache_dir/sub", 0755));
+    ASSERT_EQ(0, mkdir("markdown_cache_dir/.hidden", 0755));
+    WriteFile("markdown_cache_dir/a.md", "a");
+    WriteFile("markdown_cache_dir/sub/b.md", "b");
+    WriteFile("markdown_cache_dir/sub/c.txt", "c");
+    WriteFile("markdown_cache_dir/.hidden/d.md", "d");
+
+    MarkdownCache cache;
+    EXPECT_EQ(2u, cache.warm("markdown_cache_dir"));
+    EXPECT_EQ(2u, cache.num_entries());
+    size_t size = cache.size();
+
+    // Already warm, so nothing is rendered again.
+    MarkdownCache::Page page = cache.get("markdown_cache_dir/sub/b.md", Stat("markdown_cache_dir/sub/b.md"));
+    ASSERT_TRUE(page);
+    EXPECT_EQ(size, cache.size());
+
+    MarkdownCache empty(0);
+    EXPECT_EQ(0u, empty.warm("markdown_cache_dir"));
+    EXPECT_EQ(0u, cache.warm("markdown_cache_missing"));
+}
@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+#include "markdown.h"
+#include "markdown-tokens.h"
+#include <dirent.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Each test/markdown/<name>.md is rendered and compared with <name>.html,
+// which holds what the regex-based block parser produced for it.
+const std::string CORPUS_DIR = "test/markdown/";
+
+class MarkdownTest : public ::testing::Test {
+protected:
+    std::string ReadFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    std::string Render(const std::string& markdown) {
+        markdown::Document doc;
+        doc.read(markdown);
+        std::ostringstream html;
+        doc.write(html);
+        return html.str();
+    }
+
+    std::vector<std::string> CorpusNames() {
+        std::vector<std::string> names;
+        DIR* dir = opendir(CORPUS_DIR.c_str());
+        EXPECT_NE(nullptr, dir);
+        while (dir) {
+            struct dirent* entry = readdir(dir);
+            if (!entry) {
+                closedir(dir);
+                break;
+            }
+            std::string name = entry->d_name;
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, ".md") == 0) {
+                names.push_back(name.substr(0, name.size() - 3));
+            }
+        }
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+};
+
+TEST_F(MarkdownTest, MatchesGoldenOutput) {
+    std::vector<std::string> names = CorpusNames();
+    EXPECT_LE(8u, names.size());
+    for (auto& name : names) {
+        SCOPED_TRACE(name);
+        EXPECT_EQ(ReadFile(CORPUS_DIR + name + ".html"), Render(ReadFile(CORPUS_DIR + name + ".md")));
+    }
+}
+
+// The whole corpus as one document, so blocks of each file meet the next.
+TEST_F(MarkdownTest, MatchesConcatenatedCorpus) {
+    std::string markdown;
+    for (auto& name : CorpusNames()) {
+        markdown += ReadFile(CORPUS_DIR + name + ".md") + "\n";
+    }
+    EXPECT_EQ(ReadFile(CORPUS_DIR + "combined.html"), Render(markdown));
+}
+
+TEST_F(MarkdownTest, BlockEdgeCases) {
+    EXPECT_EQ("<h2>Title</h2>\n", Render("## Title ##"));
+    EXPECT_EQ("<h1>a#</h1>\n", Render("# a# #"));
+    EXPECT_EQ("<hr/>", Render(" -*_"));
+    EXPECT_EQ("<blockquote>\n<p>&gt;x</p>\n\n\n</blockquote>\n", Render("> >x"));
+    EXPECT_EQ("\n<ul>\n<li>a</li>\n<li> -x</li>\n</ul>\n\n", Render("* a\n*  -x"));
+    EXPECT_EQ("<p>Line</p>\n\n<br/><p>next</p>\n\n", Render("Line  \nnext"));
+}
+
+// Writing into a string appends the same HTML a stream gets.
+TEST_F(MarkdownTest, WritesIntoString) {
+    std::string markdown = ReadFile(CORPUS_DIR + "design_document.md");
+    markdown::Document doc;
+    doc.read(markdown);
+    EXPECT_LE(markdown.size(), doc.estimatedHtmlSize());
+
+    std::string html = "<body>";
+    doc.write(html);
+    EXPECT_EQ("<body>" + Render(markdown), html);
+}
+
+// Every kernel encodes alike, wherever the characters fall in a block.
+TEST_F(MarkdownTest, EncodesEntitiesWithEveryKernel) {
+    using namespace markdown::token;
+    const EncodingKernel best = encodingKernel();
+    for (EncodingKernel kernel : {cScalarKernel, cSse2Kernel, cAvx2Kernel}) {
+        if (!useEncodingKernel(kernel)) {
+            continue;
+        }
+        SCOPED_TRACE(kernel);
+        EXPECT_EQ("&lt;a href=&quot;x&quot;&gt;", encodeString("<a href=\"x\">", cAngles | cQuotes));
+        EXPECT_EQ("AT&amp;T &amp;lt;", encodeString("AT&T &lt;", cAmps));
+        EXPECT_EQ("a &amp; b &amp;", encodeString("a & b &amp;", cAmps));
+        EXPECT_EQ("&amp;amp; <", encodeString("&amp; <", cDoubleAmps));
+        EXPECT_EQ("<&\">", encodeString("<&\">", 0));
+
+        // Entities later in the text keep an earlier '&' unencoded, as the
+        // regular expression this replaced did.
+        EXPECT_EQ("AT&T &#38;", encodeString("AT&T &#38;", cAmps));
+        EXPECT_EQ("AT&T &#x2F;", encodeString("AT&T &#x2F;", cAmps));
+        EXPECT_EQ("AT&amp;T &amp;#1234;", encodeString("AT&T &#1234;", cAmps));
+        EXPECT_EQ("a & b\n&amp;", encodeString("a & b\n&amp;", cAmps));
+
+        for (size_t i = 0; i < 52; i++) {
+            std::string text(80, 'z');
+            text[i] = '<';
+            text[79 - i / 2] = '&';
+            std::string expected = text;
+            expected.replace(79 - i / 2, 1, "&amp;");
+            expected.replace(i, 1, "&lt;");
+            EXPECT_EQ(expected, encodeString(text, cAmps | cAngles));
+        }
+    }
+    useEncodingKernel(best);
+}
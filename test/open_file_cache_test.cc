@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+#include "open_file_cache.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+class OpenFileCacheTest : public ::testing::Test {
+protected:
+    void SetUp() {
+        mkdir("open_file_cache_root", 0755);
+    }
+
+    void TearDown() {
+        std::remove("open_file_cache_root/a.txt");
+        std::remove("open_file_cache_root/b.txt");
+        std::remove("open_file_cache_outside.txt");
+        rmdir("open_file_cache_root");
+    }
+
+    void WriteFile(const std::string& path, const std::string& contents) {
+        std::ofstream file(path, std::ios::binary);
+        file << contents;
+    }
+};
+
+// Within the TTL the same open file is handed out again
+TEST_F(OpenFileCacheTest, Hit) {
+    WriteFile("open_file_cache_root/a.txt", "hello");
+    OpenFileCache cache("open_file_cache_root", 60, 16);
+
+    OpenFileCache::File first;
+    OpenFileCache::File second;
+    ASSERT_TRUE(cache.open("a.txt", &first));
+    ASSERT_TRUE(cache.open("a.txt", &second));
+    EXPECT_EQ(first.body, second.body);
+    EXPECT_EQ("hello", second.body->Read());
+    EXPECT_EQ(5, second.st.st_size);
+    EXPECT_EQ(1u, cache.num_entries());
+}
+
+// A missing file stays missing until the TTL runs out
+TEST_F(OpenFileCacheTest, NotFound) {
+    OpenFileCache cache("open_file_cache_root", 60, 16);
+    OpenFileCache::File file;
+    EXPECT_FALSE(cache.open("a.txt", &file));
+
+    WriteFile("open_file_cache_root/a.txt", "hello");
+    EXPECT_FALSE(cache.open("a.txt", &file));
+    EXPECT_EQ(1u, cache.num_entries());
+
+    OpenFileCache uncached("open_file_cache_root", 0, 16);
+    EXPECT_TRUE(uncached.open("a.txt", &file));
+}
+
+// An expired entry is kept while the file is unchanged, and reopened after
+TEST_F(OpenFileCacheTest, Revalidate) {
+    WriteFile("open_file_cache_root/a.txt", "hello");
+    OpenFileCache cache("open_file_cache_root", 0, 16);
+
+    OpenFileCache::File first;
+    OpenFileCache::File second;
+    ASSERT_TRUE(cache.open("a.txt", &first));
+    ASSERT_TRUE(cache.open("a.txt", &second));
+    EXPECT_EQ(first.body, second.body);
+
+    WriteFile("open_file_cache_root/a.txt", "hello, world");
+    OpenFileCache::File changed;
+    ASSERT_TRUE(cache.open("a.txt", &changed));
+    EXPECT_NE(first.body, changed.body);
+    EXPECT_EQ("hello, world", changed.body->Read());
+
+    std::remove("open_file_cache_root/a.txt");
+    EXPECT_FALSE(cache.open("a.txt", &changed));
+}
+
+// Nothing outside the root can be opened
+TEST_F(OpenFileCacheTest, OutsideRoot) {
+    WriteFile("open_file_cache_outside.txt", "secret");
+    OpenFileCache cache("open_file_cache_root", 60, 16);
+
+    OpenFileCache::File file;
+    EXPECT_FALSE(cache.open("../open_file_cache_outside.txt", &file));
+    EXPECT_FALSE(cache.open("/etc/hostname", &file));
+    EXPECT_FALSE(cache.open("", &file));
+    EXPECT_FALSE(cache.open(".", &file));
+    EXPECT_EQ(1u, cache.num_entries());
+}
+
+// Least recently used entries are dropped first, and 0 entries disables
+// caching
+TEST_F(OpenFileCacheTest, MaxEntries) {
+    WriteFile("open_file_cache_root/a.txt", "a");
+    WriteFile("open_file_cache_root/b.txt", "b");
+    OpenFileCache cache("open_file_cache_root", 60, 1);
+
+    OpenFileCache::File a;
+    OpenFileCache::File b;
+    OpenFileCache::File again;
+    ASSERT_TRUE(cache.open("a.txt", &a));
+    ASSERT_TRUE(cache.open("b.txt", &b));
+    EXPECT_EQ(1u, cache.num_entries());
+    ASSERT_TRUE(cache.open("a.txt", &again));
+    EXPECT_NE(a.body, again.body);
+
+    OpenFileCache disabled("open_file_cache_root", 60, 0);
+    ASSERT_TRUE(disabled.open("a.txt", &a));
+    EXPECT_EQ(0u, disabled.num_entries());
+}
@@ -0,0 +1,121 @@
+#include "gtest/gtest.h"
+#include "path_index.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class PathIndexTest : public ::testing::Test {
+protected:
+    void SetUp() {
+        mkdir("path_index_root", 0755);
+        mkdir("path_index_root/docs", 0755);
+        WriteFile("path_index_root/a.txt");
+        WriteFile("path_index_root/docs/b.txt");
+    }
+
+    void TearDown() {
+        for (const char* file : {"path_index_root/a.txt", "path_index_root/docs/b.txt", "path_index_root/c.txt",
+                                 "path_index_root/new/d.txt", "path_index_root/link", "path_index_root/.hidden"}) {
+            std::remove(file);
+        }
+        rmdir("path_index_root/new");
+        rmdir("path_index_root/docs");
+        rmdir("path_index_root");
+    }
+
+    void WriteFile(const std::string& path) {
+        std::ofstream file(path);
+        file << "x";
+    }
+};
+
+TEST_F(PathIndexTest, Lookup) {
+    PathIndex index("path_index_root");
+    ASSERT_TRUE(index.complete());
+    EXPECT_EQ(2u, index.size());
+    EXPECT_TRUE(index.may_exist("a.txt"));
+    EXPECT_TRUE(index.may_exist("docs/b.txt"));
+    EXPECT_FALSE(index.may_exist("b.txt"));
+    EXPECT_FALSE(index.may_exist("docs"));
+    EXPECT_FALSE(index.may_exist("docs/a.txt"));
+    EXPECT_FALSE(index.may_exist("wp-login.php"));
+
+    // Paths the index can't vouch for.
+    EXPECT_TRUE(index.may_exist("docs//b.txt"));
+    EXPECT_TRUE(index.may_exist("./a.txt"));
+    EXPECT_TRUE(index.may_exist("../a.txt"));
+    EXPECT_TRUE(index.may_exist(".hidden"));
+}
+
+// Files and directories created or removed later are picked up
+TEST_F(PathIndexTest, Changes) {
+    PathIndex index("path_index_root");
+    EXPECT_FALSE(index.may_exist("c.txt"));
+    WriteFile("path_index_root/c.txt");
+    EXPECT_TRUE(index.may_exist("c.txt"));
+
+    mkdir("path_index_root/new", 0755);
+    WriteFile("path_index_root/new/d.txt");
+    EXPECT_TRUE(index.may_exist("new/d.txt"));
+
+    // Removals are applied by the next lookup that catches up.
+    std::remove("path_index_root/a.txt");
+    EXPECT_EQ(3u, index.size());
+    EXPECT_FALSE(index.may_exist("a.txt"));
+
+    std::remove("path_index_root/docs/b.txt");
+    rmdir("path_index_root/docs");
+    EXPECT_TRUE(index.complete());
+    EXPECT_EQ(2u, index.size());
+    EXPECT_FALSE(index.may_exist("docs/b.txt"));
+}
+
+// Lookups from several workers agree with each other while files change
+TEST_F(PathIndexTest, Concurrent) {
+    PathIndex index("path_index_root");
+    ASSERT_TRUE(index.complete());
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; i++) {
+        workers.emplace_back([&index] {
+            for (int j = 0; j < 1000; j++) {
+                EXPECT_TRUE(index.may_exist("a.txt"));
+                EXPECT_FALSE(index.may_exist("missing.txt"));
+                index.may_exist("c.txt");
+            }
+        });
+    }
+    WriteFile("path_index_root/c.txt");
+    EXPECT_TRUE(index.may_exist("c.txt"));
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_TRUE(index.may_exist("c.txt"));
+    EXPECT_EQ(3u, index.size());
+}
+
+// Symlinks aren't followed, so anything below one may exist
+TEST_F(PathIndexTest, Symlink) {
+    ASSERT_EQ(0, symlink("docs", "path_index_root/link"));
+    PathIndex index("path_index_root");
+    EXPECT_TRUE(index.may_exist("link"));
+    EXPECT_TRUE(index.may_exist("link/b.txt"));
+    EXPECT_TRUE(index.may_exist("link/missing.txt"));
+}
+
+// Roots that can't be indexed fully turn the index off
+TEST_F(PathIndexTest, Incomplete) {
+    PathIndex small("path_index_root", 2);
+    EXPECT_FALSE(small.complete());
+    EXPECT_TRUE(small.may_exist("wp-login.php"));
+
+    PathIndex missing("path_index_missing");
+    EXPECT_FALSE(missing.complete());
+    EXPECT_TRUE(missing.may_exist("a.txt"));
+
+    PathIndex disabled("path_index_root", 0);
+    EXPECT_FALSE(disabled.complete());
+}
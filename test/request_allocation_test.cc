@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+#include "echo_handler.h"
+#include "request_parser.h"
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// Counts every heap allocation made by this binary.
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+// Builds a GET for /echo with the given number of extra headers.
+std::string MakeRequest(int num_headers) {
+    std::string request = "GET /echo HTTP/1.1\r\nHost: localhost\r\n";
+    for (int i = 0; i < num_headers; i++) {
+        request += "X-Header-" + std::to_string(i) + ": some reasonably long header value\r\n";
+    }
+    return request + "\r\n";
+}
+
+// Allocations made parsing and echoing one request, the way a connection
+// does it: the parser is reused and the request refers to its buffer.
+size_t CountAllocations(RequestParser& parser, const std::string& raw) {
+    EchoHandler handler;
+    NginxConfig config;
+    handler.Init("/echo", config);
+
+    size_t before = allocations;
+    {
+        parser.reset();
+        EXPECT_EQ(RequestParser::COMPLETE, parser.parse(raw.data(), raw.size()));
+        auto request = Request::Parse(parser, raw.data(), raw.size());
+        Response response;
+        EXPECT_EQ(RequestHandler::Status::OK, handler.HandleRequest(*request, &response));
+        EXPECT_EQ(raw.size(), response.body_length());
+    }
+    return allocations - before;
+}
+
+// The allocation count doesn't grow with the size of the request.
+TEST(RequestAllocationTest, EchoGetIsConstant) {
+    RequestParser parser;
+    std::string small = MakeRequest(0);
+    std::string large = MakeRequest(50);
+
+    // Let the parser's header list grow to size first, as it would on a
+    // long-lived connection.
+    CountAllocations(parser, large);
+
+    size_t small_count = CountAllocations(parser, small);
+    size_t large_count = CountAllocations(parser, large);
+
+    EXPECT_EQ(small_count, large_count);
+    EXPECT_LE(large_count, 8);
+}
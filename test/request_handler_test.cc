@@ -28,6 +28,23 @@ TEST(RequestTest, ValidRequest){
     EXPECT_EQ("Keep-Alive", request->headers()[4].second);
 }
 
+// The body is kept byte for byte, including newlines
+TEST(RequestTest, RequestBody){
+    std::string request_string = "POST /echo HTTP/1.1\r\n"
+                                "Content-Length: 12\r\n\r\n"
+                                "line1\r\nline2";
+    auto request = Request::Parse(request_string);
+    ASSERT_TRUE(request);
+    EXPECT_EQ("POST", request->method());
+    EXPECT_EQ("line1\r\nline2", request->body());
+}
+
+// The head must be complete
+TEST(RequestTest, IncompleteRequest){
+    auto request = Request::Parse("GET / HTTP/1.1\r\nHost: localhost\r\n");
+    ASSERT_FALSE(request);
+}
+
 TEST(RequestTest, InvalidRequest){
     std::string request_string = "GET HTTP/1.1\r\n\r\n";
     auto request = Request::Parse(request_string);
@@ -80,4 +97,91 @@ TEST(ResponseTest, AddEmptyHeader) {
     resp.AddHeader("Content-Length", "7");
     resp.SetBody("foo bar");
     EXPECT_EQ(expected_200, resp.ToString());
-}
\ No newline at end of file
+}
+
+// Check that SetHeader replaces headers regardless of case
+TEST(ResponseTest, SetHeader) {
+    Response resp;
+
+    std::string expected_200 =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: 7\r\n"
+        "\r\n"
+        "foo bar";
+
+    resp.SetStatus(Response::ResponseCode::OK);
+    resp.SetVersion("HTTP/1.1");
+    resp.AddHeader("content-length", "228");
+    resp.AddHeader("Content-Type", "text/plain");
+    resp.AddHeader("Keep-Alive", "timeout=5");
+    resp.SetBody("foo bar");
+
+    resp.SetHeader("Content-Length", std::to_string(resp.body_length()));
+    resp.RemoveHeader("keep-alive");
+    EXPECT_EQ(expected_200, resp.ToString());
+}
+// Parse a response from an upstream server
+TEST(ResponseTest, ParseResponse) {
+    std::string raw_response =
+        "HTTP/1.1 302 Found\r\n"
+        "Location: http://www.example.com/\r\n"
+        "Content-Type:text/html\r\n"
+        "\r\n"
+        "<html>\r\nmoved\r\n</html>";
+
+    auto response = Response::Parse(raw_response);
+    ASSERT_TRUE(response);
+    EXPECT_EQ(Response::ResponseCode::FOUND, response->status_code());
+    EXPECT_EQ("http://www.example.com/", response->GetHeader("Location"));
+    EXPECT_EQ("text/html", response->GetHeader("Content-Type"));
+    EXPECT_EQ("HTTP/1.1 302 Found\r\n"
+              "Location: http://www.example.com/\r\n"
+              "Content-Type: text/html\r\n"
+              "\r\n"
+              "<html>\r\nmoved\r\n</html>", response->ToString());
+}
+
+// Unknown or malformed status codes are rejected
+TEST(ResponseTest, ParseInvalidResponse) {
+    EXPECT_FALSE(Response::Parse("HTTP/1.1 299 Whatever\r\n\r\n"));
+    EXPECT_FALSE(Response::Parse("HTTP/1.1 abc\r\n\r\n"));
+}
+
+// Header lookups ignore case, including for the private cookie
+TEST(RequestTest, CaseInsensitiveHeaders) {
+    auto request = Request::Parse("GET / HTTP/1.1\r\nhost: localhost\r\ncookie: a=1; private=abc; b=2\r\n\r\n");
+    ASSERT_TRUE(request);
+    ASSERT_TRUE(request->headers().find("Host"));
+    EXPECT_EQ("localhost", *request->headers().find("Host"));
+    EXPECT_EQ("abc", request->cookie());
+
+    request->update_header(std::make_pair("Host", "example.com"));
+    ASSERT_EQ(2, request->headers().size());
+    EXPECT_EQ("example.com", *request->headers().find("HOST"));
+    EXPECT_EQ("abc", request->cookie());
+}
+
+// Upstream servers may send header names in any case
+TEST(ResponseTest, CaseInsensitiveGetHeader) {
+    auto response = Response::Parse("HTTP/1.1 301 Moved Permanently\r\nlocation: http://example.com/\r\n\r\n");
+    ASSERT_TRUE(response);
+    EXPECT_EQ("http://example.com/", response->GetHeader("Location"));
+    EXPECT_EQ("", response->GetHeader("Content-Type"));
+}
+
+// The head is sized exactly and serialized separately from the body
+TEST(ResponseTest, SerializeHead) {
+    Response resp;
+    resp.SetStatus(Response::ResponseCode::OK);
+    resp.AddHeader("Content-Type", "text/plain");
+    resp.AddHeader("Content-Length", "7");
+    resp.SetBody("foo bar");
+
+    std::string head;
+    resp.SerializeHead(&head);
+    EXPECT_EQ("HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 7\r\n\r\n", head);
+    EXPECT_EQ(head.length(), resp.HeadLength());
+    EXPECT_EQ("foo bar", resp.body());
+    EXPECT_EQ(head + "foo bar", resp.ToString());
+}
@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+#include "request_parser.h"
+#include <string>
+
+class RequestParserTest : public ::testing::Test {
+protected:
+    std::string field(const RequestParser::Span& span) {
+        return raw_.substr(span.offset, span.length);
+    }
+
+    RequestParser::Result parse(const std::string& raw) {
+        raw_ = raw;
+        return parser_.parse(raw_.data(), raw_.size());
+    }
+
+    RequestParser parser_;
+    std::string raw_;
+};
+
+// Request line and headers are recorded as offsets into the buffer
+TEST_F(RequestParserTest, ValidRequest) {
+    ASSERT_EQ(RequestParser::COMPLETE, parse("GET /hello.htm HTTP/1.1\r\n"
+                                             "Host: www.example.com\r\n"
+                                             "Accept:   text/html  \r\n"
+                                             "X-Empty:\r\n\r\n"));
+    EXPECT_EQ("GET", field(parser_.method()));
+    EXPECT_EQ("/hello.htm", field(parser_.uri()));
+    EXPECT_EQ("HTTP/1.1", field(parser_.version()));
+    EXPECT_EQ(raw_.size(), parser_.head_length());
+    EXPECT_EQ(0, parser_.content_length());
+
+    ASSERT_EQ(3, parser_.headers().size());
+    EXPECT_EQ("Host", field(parser_.headers()[0].name));
+    EXPECT_EQ("www.example.com", field(parser_.headers()[0].value));
+    // Surrounding whitespace is not part of the value
+    EXPECT_EQ("Accept", field(parser_.headers()[1].name));
+    EXPECT_EQ("text/html", field(parser_.headers()[1].value));
+    EXPECT_EQ("X-Empty", field(parser_.headers()[2].name));
+    EXPECT_EQ("", field(parser_.headers()[2].value));
+}
+
+// Bare LF line endings are accepted
+TEST_F(RequestParserTest, BareLineFeeds) {
+    ASSERT_EQ(RequestParser::COMPLETE, parse("GET / HTTP/1.0\nHost: localhost\n\n"));
+    EXPECT_EQ("HTTP/1.0", field(parser_.version()));
+    ASSERT_EQ(1, parser_.headers().size());
+    EXPECT_EQ("localhost", field(parser_.headers()[0].value));
+}
+
+// Feeding a request one byte at a time gives the same result
+TEST_F(RequestParserTest, ResumeByteByByte) {
+    raw_ = "POST /login HTTP/1.1\r\nContent-Length: 5\r\nHost: localhost\r\n\r\nhello";
+
+    for (size_t i = 1; i < raw_.size(); i++) {
+        ASSERT_EQ(RequestParser::INCOMPLETE, parser_.parse(raw_.data(), i));
+    }
+    ASSERT_EQ(RequestParser::COMPLETE, parser_.parse(raw_.data(), raw_.size()));
+
+    EXPECT_EQ("POST", field(parser_.method()));
+    EXPECT_EQ("/login", field(parser_.uri()));
+    ASSERT_EQ(2, parser_.headers().size());
+    EXPECT_EQ("localhost", field(parser_.headers()[1].value));
+    EXPECT_EQ(5, parser_.content_length());
+    EXPECT_EQ(raw_.size(), parser_.request_length());
+}
+
+// The head is complete before the body has arrived
+TEST_F(RequestParserTest, WaitForBody) {
+    ASSERT_EQ(RequestParser::INCOMPLETE, parse("POST / HTTP/1.1\r\ncontent-length: 10\r\n\r\n12345"));
+    EXPECT_TRUE(parser_.head_complete());
+    EXPECT_EQ(10, parser_.content_length());
+}
+
+// Bytes past the declared body belong to the next request
+TEST_F(RequestParserTest, PipelinedRequest) {
+    ASSERT_EQ(RequestParser::COMPLETE, parse("GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ("/a", field(parser_.uri()));
+    EXPECT_EQ(19, parser_.request_length());
+
+    parser_.reset();
+    ASSERT_EQ(RequestParser::COMPLETE, parse("GET /b HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ("/b", field(parser_.uri()));
+}
+
+// Malformed request lines
+TEST_F(RequestParserTest, InvalidRequestLine) {
+    EXPECT_EQ(RequestParser::ERROR, parse("GET HTTP/1.1\r\n\r\n"));
+    parser_.reset();
+    EXPECT_EQ(RequestParser::ERROR, parse("GET  / HTTP/1.1\r\n\r\n"));
+    parser_.reset();
+    EXPECT_EQ(RequestParser::ERROR, parse("G(T / HTTP/1.1\r\n\r\n"));
+    parser_.reset();
+    EXPECT_EQ(RequestParser::ERROR, parse("GET / HTTP/1.1\rX\r\n\r\n"));
+}
+
+// Malformed headers
+TEST_F(RequestParserTest, InvalidHeaders) {
+    EXPECT_EQ(RequestParser::ERROR, parse("GET / HTTP/1.1\r\nNo colon\r\n\r\n"));
+    parser_.reset();
+    EXPECT_EQ(RequestParser::ERROR, parse("GET / HTTP/1.1\r\nHost: a\r\n folded\r\n\r\n"));
+    parser_.reset();
+    EXPECT_EQ(RequestParser::ERROR, parse("GET / HTTP/1.1\r\nHost: a\x01\r\n\r\n"));
+}
+
+// Only plain, consistent Content-Length framing is accepted
+TEST_F(RequestParserTest, InvalidFraming) {
+    EXPECT_EQ(RequestParser::ERROR, parse("POST / HTTP/1.1\r\nContent-Length: -1\r\n\r\n"));
+    parser_.reset();
+    EXPECT_EQ(RequestParser::ERROR, parse("POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n"));
+    parser_.reset();
+    EXPECT_EQ(RequestParser::ERROR, parse("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"));
+}
@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+#include "response_compressor.h"
+#include <zlib.h>
+
+std::string gunzip(boost::string_ref data) {
+    z_stream stream = z_stream();
+    EXPECT_EQ(Z_OK, inflateInit2(&stream, 15 + 16));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+
+    std::string out;
+    char buffer[4096];
+    int result = Z_OK;
+    while (result == Z_OK) {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+        result = inflate(&stream, Z_NO_FLUSH);
+        out.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+    EXPECT_EQ(Z_STREAM_END, result);
+    inflateEnd(&stream);
+    return out;
+}
+
+class ResponseCompressorTest : public ::testing::Test {
+protected:
+    ResponseCompressorTest() : compressor_(6, 100) {
+        gzip_request_ = Request::Parse("GET / HTTP/1.1\r\nAccept-Encoding: gzip, deflate\r\n\r\n");
+        plain_request_ = Request::Parse("GET / HTTP/1.1\r\n\r\n");
+        text_ = std::string(1000, 'a') + "end";
+    }
+
+    Response TextResponse(const std::string& type) {
+        Response response;
+        response.SetStatus(Response::ResponseCode::OK);
+        response.AddHeader("Content-Type", type);
+        response.AddHeader("Content-Length", std::to_string(text_.size()));
+        response.SetBody(text_);
+        return response;
+    }
+
+    ResponseCompressor compressor_;
+    std::unique_ptr<Request> gzip_request_;
+    std::unique_ptr<Request> plain_request_;
+    std::string text_;
+};
+
+TEST_F(ResponseCompressorTest, CompressesText) {
+    Response response = TextResponse("text/html; charset=utf-8");
+    response.AddHeader("ETag", "\"abc\"");
+    response.AddHeader("Accept-Ranges", "bytes");
+    ASSERT_TRUE(compressor_.compress(*gzip_request_, &response));
+
+    EXPECT_EQ("gzip", response.GetHeader("Content-Encoding"));
+    EXPECT_EQ("Accept-Encoding", response.GetHeader("Vary"));
+    EXPECT_EQ("W/\"abc\"", response.GetHeader("ETag"));
+    EXPECT_EQ("", response.GetHeader("Accept-Ranges"));
+    EXPECT_LT(response.body().size(), text_.size());
+    EXPECT_EQ(std::to_string(response.body().size()), response.GetHeader("Content-Length"));
+    EXPECT_EQ(text_, gunzip(response.body()));
+}
+
+TEST_F(ResponseCompressorTest, LeavesOtherResponsesAlone) {
+    // The client doesn't accept gzip, but caches need to know it matters.
+    Response plain = TextResponse("text/plain");
+    EXPECT_FALSE(compressor_.compress(*plain_request_, &plain));
+    EXPECT_EQ(text_, plain.body());
+    EXPECT_EQ("Accept-Encoding", plain.GetHeader("Vary"));
+
+    Response image = TextResponse("image/png");
+    EXPECT_FALSE(compressor_.compress(*gzip_request_, &image));
+
+    Response encoded = TextResponse("text/plain");
+    encoded.AddHeader("Content-Encoding", "br");
+    EXPECT_FALSE(compressor_.compress(*gzip_request_, &encoded));
+
+    Response not_found = TextResponse("text/html");
+    not_found.SetStatus(Response::ResponseCode::NOT_FOUND);
+    EXPECT_FALSE(compressor_.compress(*gzip_request_, &not_found));
+
+    Response small = TextResponse("text/html");
+    small.SetBody("tiny");
+    EXPECT_FALSE(compressor_.compress(*gzip_request_, &small));
+    EXPECT_EQ("", small.GetHeader("Vary"));
+
+    ResponseCompressor disabled(0, 0);
+    Response response = TextResponse("text/html");
+    EXPECT_FALSE(disabled.compress(*gzip_request_, &response));
+}
+
+TEST_F(ResponseCompressorTest, MemoizesSharedBodies) {
+    std::shared_ptr<const std::string> body = std::make_shared<const std::string>(text_);
+
+    Response first = TextResponse("application/json");
+    first.SetBody(body);
+    ASSERT_TRUE(compressor_.compress(*gzip_request_, &first));
+    Response second = TextResponse("application/json");
+    second.SetBody(body);
+    ASSERT_TRUE(compressor_.compress(*gzip_request_, &second));
+
+    EXPECT_EQ(first.shared_body(), second.shared_body());
+    EXPECT_EQ(1u, compressor_.num_entries());
+    EXPECT_EQ(text_, gunzip(second.body()));
+
+    // Once the source is released its entry goes with the next insertion.
+    body.reset();
+    std::shared_ptr<const std::string> other = std::make_shared<const std::string>(text_ + "x");
+    Response third = TextResponse("text/css");
+    third.SetBody(other);
+    ASSERT_TRUE(compressor_.compress(*gzip_request_, &third));
+    EXPECT_EQ(1u, compressor_.num_entries());
+    EXPECT_EQ(third.shared_body()->size(), compressor_.size());
+}
+
+// zlib rejects level 10, so every compression fails. Responses go out as
+// they were and nothing is memoized.
+TEST_F(ResponseCompressorTest, LeavesResponseAloneWhenZlibFails) {
+    ResponseCompressor failing(10, 100);
+    Response response = TextResponse("text/html");
+    EXPECT_FALSE(failing.compress(*gzip_request_, &response));
+    EXPECT_EQ(text_, response.body());
+    EXPECT_EQ("", response.GetHeader("Content-Encoding"));
+    EXPECT_EQ(std::to_string(text_.size()), response.GetHeader("Content-Length"));
+
+    Response shared = TextResponse("text/html");
+    shared.SetBody(std::make_shared<const std::string>(text_));
+    EXPECT_FALSE(failing.compress(*gzip_request_, &shared));
+    EXPECT_EQ(text_, shared.body());
+    EXPECT_EQ("", shared.GetHeader("Content-Encoding"));
+    EXPECT_EQ(0u, failing.num_entries());
+}
+
+TEST(ResponseCompressorTypesTest, Compressible) {
+    EXPECT_TRUE(ResponseCompressor::compressible("text/html"));
+    EXPECT_TRUE(ResponseCompressor::compressible("Text/CSS ; charset=utf-8"));
+    EXPECT_TRUE(ResponseCompressor::compressible("application/json"));
+    EXPECT_TRUE(ResponseCompressor::compressible("image/svg+xml"));
+    EXPECT_FALSE(ResponseCompressor::compressible("image/jpeg"));
+    EXPECT_FALSE(ResponseCompressor::compressible("application/octet-stream"));
+    EXPECT_FALSE(ResponseCompressor::compressible(""));
+}
@@ -10,8 +10,8 @@ using ::testing::Return;
 
 class MockRequest : public Request {
 public:
-    MOCK_CONST_METHOD0(raw_request, std::string());
-    MOCK_CONST_METHOD0(uri, std::string());
+    MOCK_CONST_METHOD0(raw_request, boost::string_ref());
+    MOCK_CONST_METHOD0(uri, boost::string_ref());
 };
 
 // Test fixture
@@ -36,7 +36,7 @@ TEST(ReverseProxyHandlerTests, TransformRequestTest) {
     auto req = Request::Parse(request);
     Request transformedReq;
     transformedReq = rp_handler.TransformRequest(*req);
-    std::string expectedRequest = "GET echo HTTP/1.0\r\nUser-Agent: curl/7.35.0\r\nHost: \r\nConnection: close\r\nAccept: */*\r\n\r\n\r\r\n";
+    std::string expectedRequest = "GET echo HTTP/1.0\r\nUser-Agent: curl/7.35.0\r\nHost: \r\nConnection: close\r\nAccept: */*\r\n\r\n\r\n";
     ASSERT_EQ(transformedReq.raw_request(), expectedRequest);
 }
 
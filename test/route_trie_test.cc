@@ -0,0 +1,103 @@
+#include "gtest/gtest.h"
+#include "route_trie.h"
+#include <random>
+#include <string>
+#include <unordered_map>
+
+// Only compared by address, never called.
+RequestHandler* handler(size_t i) {
+    return reinterpret_cast<RequestHandler*>(i + 1);
+}
+
+// Webserver::find_prefix before it used the trie.
+std::string legacy_find_prefix(const std::unordered_map<std::string, RequestHandler*>& handler_map,
+                               std::string uri) {
+    std::string longest = "";
+    size_t last = uri.find_last_of("/");
+    std::string prefix = uri.substr(0, last);
+
+    for (auto it : handler_map) {
+        std::string map = it.first;
+
+        if (prefix.find(map) == 0 && (prefix.find("/", map.length()) == map.length() ||
+            map.length() == prefix.length() || map.length() == 1)) {
+            if (map.length() > longest.length()) {
+                longest = map;
+            }
+        }
+    }
+
+    return longest;
+}
+
+// Exact matches only hit whole routes
+TEST(RouteTrieTest, FindExact) {
+    RouteTrie routes({{"/", handler(0)}, {"/echo", handler(1)}, {"default", handler(2)}});
+
+    EXPECT_EQ(3, routes.size());
+    EXPECT_EQ(handler(0), routes.find_exact("/"));
+    EXPECT_EQ(handler(1), routes.find_exact("/echo"));
+    EXPECT_EQ(handler(2), routes.find_exact("default"));
+    EXPECT_EQ(nullptr, routes.find_exact(""));
+    EXPECT_EQ(nullptr, routes.find_exact("/ech"));
+    EXPECT_EQ(nullptr, routes.find_exact("/echo/"));
+    EXPECT_EQ(nullptr, RouteTrie().find_exact("/"));
+}
+
+// The longest whole-segment prefix of the URI's directory wins
+TEST(RouteTrieTest, FindLongestPrefix) {
+    RouteTrie routes({{"/", handler(0)}, {"/foo", handler(1)}, {"/foo/bar", handler(2)}});
+    boost::string_ref prefix;
+
+    EXPECT_EQ(handler(2), routes.find_longest_prefix("/foo/bar/a.txt", &prefix));
+    EXPECT_EQ("/foo/bar", prefix);
+    EXPECT_EQ(handler(1), routes.find_longest_prefix("/foo/barn/a.txt", &prefix));
+    EXPECT_EQ("/foo", prefix);
+    EXPECT_EQ(handler(0), routes.find_longest_prefix("/fooo/a.txt", &prefix));
+    EXPECT_EQ("/", prefix);
+
+    // Files directly under the root have an empty directory
+    EXPECT_EQ(nullptr, routes.find_longest_prefix("/a.txt"));
+    EXPECT_EQ(nullptr, RouteTrie({{"/foo", handler(0)}}).find_longest_prefix("/fooo/a.txt"));
+}
+
+// Matches the original linear search on random rooted routes and any URIs
+TEST(RouteTrieTest, MatchesLegacyPrefixSearch) {
+    std::mt19937 random(42);
+    const char* segments[] = {"", "a", "b", "ab", "static", "x.txt"};
+    auto random_path = [&](bool rooted) {
+        std::string path;
+        size_t length = random() % 5;
+        if (rooted || random() % 4) {
+            path += "/";
+        }
+        for (size_t i = 0; i < length; i++) {
+            path += segments[random() % 6];
+            if (i + 1 < length) {
+                path += "/";
+            }
+        }
+        return path;
+    };
+
+    for (int round = 0; round < 200; round++) {
+        std::unordered_map<std::string, RequestHandler*> handler_map;
+        for (int i = 0; i < 8; i++) {
+            handler_map[random_path(true)] = handler(i);
+        }
+        handler_map.erase("");
+        RouteTrie routes(RouteTrie::Routes(handler_map.begin(), handler_map.end()));
+
+        for (int i = 0; i < 50; i++) {
+            std::string uri = random_path(false);
+            std::string expected = legacy_find_prefix(handler_map, uri);
+            boost::string_ref prefix;
+            RequestHandler* found = routes.find_longest_prefix(uri, &prefix);
+
+            ASSERT_EQ(expected.empty() ? nullptr : handler_map[expected], found) << uri;
+            EXPECT_EQ(expected, prefix.to_string()) << uri;
+            auto exact = handler_map.find(uri);
+            EXPECT_EQ(exact == handler_map.end() ? nullptr : exact->second, routes.find_exact(uri)) << uri;
+        }
+    }
+}
@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include "server_status_tracker.h"
+#include <thread>
 
 TEST(ServerStatusTest, RecordRequests) {
     ServerStatusTracker::GetInstance().RecordRequest("/status", Response::ResponseCode::OK);
@@ -35,4 +36,25 @@ TEST(ServerStatusTest, RecordHandlers) {
 
     EXPECT_EQ("/echo", handlers[2].first);
     EXPECT_EQ("EchoHandler", handlers[2].second);
-}
\ No newline at end of file
+}
+
+// A config reload replaces the mappings while workers record and read.
+TEST(ServerStatusTest, ReloadsWhileReading) {
+    ServerStatusTracker& tracker = ServerStatusTracker::GetInstance();
+    ServerStatusTracker::HandlerList small = {{"/a", "EchoHandler"}};
+    ServerStatusTracker::HandlerList large(100, std::make_pair("/static", "StaticFileHandler"));
+
+    tracker.SetHandlerMappings(small);
+
+    std::thread reloader([&]() {
+        for (int i = 0; i < 1000; i++) {
+            tracker.SetHandlerMappings(i % 2 ? small : large);
+        }
+    });
+    for (int i = 0; i < 1000; i++) {
+        tracker.RecordRequest("/a", Response::ResponseCode::OK);
+        size_t size = tracker.GetHandlers().size();
+        EXPECT_TRUE(size == small.size() || size == large.size());
+    }
+    reloader.join();
+}
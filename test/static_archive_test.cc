@@ -0,0 +1,80 @@
+#include "gtest/gtest.h"
+#include "static_archive.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class StaticArchiveTest : public ::testing::Test {
+protected:
+    void TearDown() {
+        std::remove("static_archive_test.pack");
+    }
+
+    StaticArchive::File File(const std::string& path, const std::string& body) {
+        StaticArchive::File file;
+        file.path = path;
+        file.content_type = "text/plain";
+        file.etag = "\"" + path + "\"";
+        file.last_modified = 784111777;
+        file.body = body;
+        return file;
+    }
+};
+
+TEST_F(StaticArchiveTest, RoundTrip) {
+    std::vector<StaticArchive::File> files;
+    files.push_back(File("z.txt", "last"));
+    files.push_back(File("a.txt", "first"));
+    files.push_back(File("docs/empty.txt", ""));
+    files.back().encoded[SidecarIndex::GZIP] = "gzipped";
+    ASSERT_TRUE(StaticArchive::Write("static_archive_test.pack", files));
+
+    std::shared_ptr<const StaticArchive> archive = StaticArchive::Open("static_archive_test.pack");
+    ASSERT_TRUE(archive);
+    EXPECT_EQ(3u, archive->size());
+
+    const StaticArchive::Entry* a = archive->find("a.txt");
+    ASSERT_TRUE(a);
+    EXPECT_EQ("first", a->body);
+    EXPECT_EQ("text/plain", a->content_type);
+    EXPECT_EQ("\"a.txt\"", a->etag);
+    EXPECT_EQ(784111777, a->last_modified);
+    EXPECT_FALSE(a->sidecars().any());
+
+    const StaticArchive::Entry* empty = archive->find("docs/empty.txt");
+    ASSERT_TRUE(empty);
+    EXPECT_EQ("", empty->body);
+    EXPECT_EQ("gzipped", empty->encoded[SidecarIndex::GZIP]);
+    EXPECT_TRUE(empty->sidecars().has(SidecarIndex::GZIP));
+    EXPECT_FALSE(empty->sidecars().has(SidecarIndex::BROTLI));
+
+    EXPECT_EQ("last", archive->find("z.txt")->body);
+    EXPECT_FALSE(archive->find("b.txt"));
+    EXPECT_FALSE(archive->find("docs"));
+    EXPECT_FALSE(archive->find("/a.txt"));
+}
+
+TEST_F(StaticArchiveTest, DuplicatePaths) {
+    std::vector<StaticArchive::File> files;
+    files.push_back(File("a.txt", "one"));
+    files.push_back(File("a.txt", "two"));
+    EXPECT_FALSE(StaticArchive::Write("static_archive_test.pack", files));
+}
+
+// Files that aren't archives, or are cut short, are rejected
+TEST_F(StaticArchiveTest, Invalid) {
+    EXPECT_FALSE(StaticArchive::Open("static_archive_missing.pack"));
+
+    std::ofstream("static_archive_test.pack") << "not an archive, but long enough to hold a header";
+    EXPECT_FALSE(StaticArchive::Open("static_archive_test.pack"));
+
+    std::vector<StaticArchive::File> files;
+    files.push_back(File("a.txt", "first"));
+    ASSERT_TRUE(StaticArchive::Write("static_archive_test.pack", files));
+    std::ifstream in("static_archive_test.pack", std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream("static_archive_test.pack", std::ios::binary) << contents.substr(0, contents.size() - 4);
+    EXPECT_FALSE(StaticArchive::Open("static_archive_test.pack"));
+}
@@ -1,9 +1,13 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 #include "static_file_handler.h"
+#include "http_date.h"
+#include "markdown_cache.h"
+#include "sidecar_index.h"
 #include <iostream>
 #include <fstream>
 #include <stdio.h>
+#include <sys/stat.h>
 #include <vector>
 #include <unistd.h>
 
@@ -11,13 +15,18 @@ using ::testing::Return;
 
 class MockRequest : public Request {
 public:
-    MOCK_CONST_METHOD0(raw_request, std::string());
-    MOCK_CONST_METHOD0(uri, std::string());
-    MOCK_CONST_METHOD0(method, std::string());
-    MOCK_CONST_METHOD0(body, std::string());
-    MOCK_CONST_METHOD0(cookie, std::string());
+    MOCK_CONST_METHOD0(raw_request, boost::string_ref());
+    MOCK_CONST_METHOD0(uri, boost::string_ref());
+    MOCK_CONST_METHOD0(method, boost::string_ref());
+    MOCK_CONST_METHOD0(body, boost::string_ref());
+    MOCK_CONST_METHOD0(cookie, boost::string_ref());
 };
 
+// The ETag and Last-Modified headers of a response for a file.
+std::string Validators(Response& resp) {
+    return "ETag: " + resp.GetHeader("ETag") + "\r\nLast-Modified: " + resp.GetHeader("Last-Modified") + "\r\n";
+}
+
 // Test fixture
 class StaticFileHandlerTests : public ::testing::Test {
 protected:
@@ -78,6 +87,10 @@ TEST(StaticFileHandlerHelperTests, FileExtensionTest) {
     EXPECT_EQ(TYPE_PDF, f_handler.get_content_type("test.pdf"));
     EXPECT_EQ(TYPE_PNG, f_handler.get_content_type("test.png"));
     EXPECT_EQ(TYPE_TXT, f_handler.get_content_type("test.txt"));
+    EXPECT_EQ(TYPE_CSS, f_handler.get_content_type("test.css"));
+    EXPECT_EQ(TYPE_JS, f_handler.get_content_type("test.js"));
+    EXPECT_EQ(TYPE_JSON, f_handler.get_content_type("test.json"));
+    EXPECT_EQ(TYPE_SVG, f_handler.get_content_type("test.svg"));
 }
 
 // Basic valid Init Call
@@ -154,7 +167,7 @@ TEST_F(StaticFileHandlerTests, TrailingSlash) {
     ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", out_config_));
 
     ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(processed_request, &resp));
-    EXPECT_EQ("HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 8\r\n\r\nfoo bar\n", resp.ToString());
+    EXPECT_EQ("HTTP/1.0 200 OK\r\n" + Validators(resp) + "Content-Type: text/plain\r\nAccept-Ranges: bytes\r\nContent-Length: 8\r\n\r\nfoo bar\n", resp.ToString());
     remove("test_file.txt");
 }
 
@@ -185,10 +198,418 @@ TEST_F(StaticFileHandlerTests, HandleBasicRequest) {
     ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", out_config_));
 
     ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(processed_request, &resp));
-    EXPECT_EQ("HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 8\r\n\r\nfoo bar\n", resp.ToString());
+    EXPECT_EQ("HTTP/1.0 200 OK\r\n" + Validators(resp) + "Content-Type: text/plain\r\nAccept-Ranges: bytes\r\nContent-Length: 8\r\n\r\nfoo bar\n", resp.ToString());
+    remove("test_file.txt");
+}
+
+// Files at or above the threshold are sent from the open file
+TEST_F(StaticFileHandlerTests, SendfileThreshold) {
+    EXPECT_CALL(processed_request, uri()).Times(2)
+        .WillOnce(Return("/static/test_file.txt"))
+        .WillOnce(Return("/static/test_file.txt"));
+    CreateTestFile();
+
+    ASSERT_TRUE(ParseString("root ./; sendfile_threshold 8;"));
+    StaticFileHandler f_handler;
+    Response resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", out_config_));
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(processed_request, &resp));
+    ASSERT_TRUE(resp.file_body());
+    EXPECT_EQ(8, resp.body_length());
+    EXPECT_EQ("HTTP/1.0 200 OK\r\n" + Validators(resp) + "Content-Type: text/plain\r\nAccept-Ranges: bytes\r\nContent-Length: 8\r\n\r\nfoo bar\n", resp.ToString());
+
+    std::stringstream small_config("root ./; sendfile_threshold 9;");
+    NginxConfig small_out_config;
+    ASSERT_TRUE(parser_.Parse(&small_config, &small_out_config));
+    StaticFileHandler small_handler;
+    Response small_resp;
+    ASSERT_EQ(RequestHandler::Status::OK, small_handler.Init("/static", small_out_config));
+    ASSERT_EQ(RequestHandler::Status::OK, small_handler.HandleRequest(processed_request, &small_resp));
+    EXPECT_FALSE(small_resp.file_body());
+    EXPECT_EQ("foo bar\n", small_resp.body());
+    remove("test_file.txt");
+}
+
+// Range requests, served from the cache and from the file
+TEST_F(StaticFileHandlerTests, SingleRange) {
+    CreateTestFile();
+    std::unique_ptr<Request> request =
+        Request::Parse("GET /static/test_file.txt HTTP/1.1\r\nRange: bytes=4-\r\n\r\n");
+    ASSERT_TRUE(request);
+
+    for (const char* config : {"root ./;", "root ./; sendfile_threshold 1;"}) {
+        std::stringstream config_stream(config);
+        NginxConfig range_config;
+        ASSERT_TRUE(parser_.Parse(&config_stream, &range_config));
+        StaticFileHandler f_handler;
+        Response resp;
+        ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", range_config));
+        ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*request, &resp));
+        EXPECT_EQ(Response::ResponseCode::PARTIAL_CONTENT, resp.status_code());
+        EXPECT_EQ(4, resp.body_length());
+        EXPECT_EQ("HTTP/1.0 206 Partial Content\r\n" + Validators(resp) + "Content-Type: text/plain\r\nAccept-Ranges: bytes\r\n"
+                  "Content-Range: bytes 4-7/8\r\nContent-Length: 4\r\n\r\nbar\n", resp.ToString());
+    }
+    remove("test_file.txt");
+}
+
+TEST_F(StaticFileHandlerTests, MultipleRanges) {
+    CreateTestFile();
+    std::unique_ptr<Request> request =
+        Request::Parse("GET /static/test_file.txt HTTP/1.1\r\nRange: bytes=0-0,-2\r\n\r\n");
+    ASSERT_TRUE(request);
+
+    ASSERT_TRUE(ParseString("root ./;"));
+    StaticFileHandler f_handler;
+    Response resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", out_config_));
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*request, &resp));
+    EXPECT_EQ(Response::ResponseCode::PARTIAL_CONTENT, resp.status_code());
+
+    std::string response = resp.ToString();
+    std::string type = "multipart/byteranges; boundary=";
+    size_t type_position = response.find(type);
+    ASSERT_NE(std::string::npos, type_position);
+    std::string boundary = response.substr(type_position + type.size(), 24);
+    std::string body = "\r\n--" + boundary + "\r\nContent-Type: text/plain\r\nContent-Range: bytes 0-0/8\r\n\r\nf"
+                       "\r\n--" + boundary + "\r\nContent-Type: text/plain\r\nContent-Range: bytes 6-7/8\r\n\r\nr\n"
+                       "\r\n--" + boundary + "--\r\n";
+    EXPECT_EQ(body, resp.body());
+    EXPECT_NE(std::string::npos, response.find("Content-Length: " + std::to_string(body.size()) + "\r\n"));
+    remove("test_file.txt");
+}
+
+TEST_F(StaticFileHandlerTests, UnsatisfiableRange) {
+    CreateTestFile();
+    std::unique_ptr<Request> request =
+        Request::Parse("GET /static/test_file.txt HTTP/1.1\r\nRange: bytes=8-\r\n\r\n");
+    ASSERT_TRUE(request);
+
+    ASSERT_TRUE(ParseString("root ./;"));
+    StaticFileHandler f_handler;
+    Response resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", out_config_));
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*request, &resp));
+    EXPECT_EQ("HTTP/1.0 416 Range Not Satisfiable\r\n" + Validators(resp) + "Content-Type: text/plain\r\nAccept-Ranges: bytes\r\n"
+              "Content-Range: bytes */8\r\nContent-Length: 0\r\n\r\n", resp.ToString());
+    remove("test_file.txt");
+}
+
+// A Range is only honoured if If-Range matches the file's date.
+TEST_F(StaticFileHandlerTests, IfRange) {
+    CreateTestFile();
+    ASSERT_TRUE(ParseString("root ./;"));
+    StaticFileHandler f_handler;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", out_config_));
+
+    std::unique_ptr<Request> stale = Request::Parse(
+        "GET /static/test_file.txt HTTP/1.1\r\nRange: bytes=4-\r\n"
+        "If-Range: Thu, 01 Jan 1970 00:00:00 GMT\r\n\r\n");
+    ASSERT_TRUE(stale);
+    Response stale_resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*stale, &stale_resp));
+    EXPECT_EQ(Response::ResponseCode::OK, stale_resp.status_code());
+    EXPECT_EQ("foo bar\n", stale_resp.body());
+
+    struct stat st;
+    ASSERT_EQ(0, stat("test_file.txt", &st));
+    std::unique_ptr<Request> current = Request::Parse(
+        "GET /static/test_file.txt HTTP/1.1\r\nRange: bytes=4-\r\n"
+        "If-Range: " + http_date::format(st.st_mtime) + "\r\n\r\n");
+    ASSERT_TRUE(current);
+    Response current_resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*current, &current_resp));
+    EXPECT_EQ(Response::ResponseCode::PARTIAL_CONTENT, current_resp.status_code());
+    EXPECT_EQ("bar\n", current_resp.body());
+    remove("test_file.txt");
+}
+
+// Conditional GETs of an unchanged file get a 304 without a body.
+TEST_F(StaticFileHandlerTests, NotModified) {
+    CreateTestFile();
+    ASSERT_TRUE(ParseString("root ./;"));
+    StaticFileHandler f_handler;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", out_config_));
+
+    struct stat st;
+    ASSERT_EQ(0, stat("test_file.txt", &st));
+    std::unique_ptr<Request> plain = Request::Parse("GET /static/test_file.txt HTTP/1.1\r\n\r\n");
+    ASSERT_TRUE(plain);
+    Response plain_resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*plain, &plain_resp));
+    std::string etag = plain_resp.GetHeader("ETag");
+    ASSERT_FALSE(etag.empty());
+    EXPECT_EQ('"', etag.front());
+    EXPECT_EQ(http_date::format(st.st_mtime), plain_resp.GetHeader("Last-Modified"));
+
+    std::string year_2000 = "Sat, 01 Jan 2000 00:00:00 GMT";
+    std::vector<std::pair<std::string, Response::ResponseCode>> cases = {
+        {"If-None-Match: " + etag, Response::ResponseCode::NOT_MODIFIED},
+        {"If-None-Match: \"x\", W/" + etag, Response::ResponseCode::NOT_MODIFIED},
+        {"If-None-Match: *", Response::ResponseCode::NOT_MODIFIED},
+        {"If-None-Match: \"x\"", Response::ResponseCode::OK},
+        {"If-Modified-Since: " + http_date::format(st.st_mtime), Response::ResponseCode::NOT_MODIFIED},
+        {"If-Modified-Since: " + year_2000, Response::ResponseCode::OK},
+        {"If-Modified-Since: yesterday", Response::ResponseCode::OK},
+        // If-None-Match takes precedence.
+        {"If-None-Match: \"x\"\r\nIf-Modified-Since: " + http_date::format(st.st_mtime),
+         Response::ResponseCode::OK},
+    };
+    for (auto& c : cases) {
+        std::unique_ptr<Request> request =
+            Request::Parse("GET /static/test_file.txt HTTP/1.1\r\n" + c.first + "\r\n\r\n");
+        ASSERT_TRUE(request);
+        Response resp;
+        ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*request, &resp));
+        EXPECT_EQ(c.second, resp.status_code()) << c.first;
+        EXPECT_EQ(etag, resp.GetHeader("ETag"));
+        if (c.second == Response::ResponseCode::NOT_MODIFIED) {
+            EXPECT_EQ("HTTP/1.0 304 Not Modified\r\n" + Validators(resp) + "\r\n", resp.ToString());
+        }
+    }
+
+    // If-Range also accepts the ETag.
+    std::unique_ptr<Request> range = Request::Parse(
+        "GET /static/test_file.txt HTTP/1.1\r\nRange: bytes=4-\r\nIf-Range: " + etag + "\r\n\r\n");
+    ASSERT_TRUE(range);
+    Response range_resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*range, &range_resp));
+    EXPECT_EQ(Response::ResponseCode::PARTIAL_CONTENT, range_resp.status_code());
     remove("test_file.txt");
 }
 
+// Precompressed copies are sent to clients that accept their encoding.
+TEST_F(StaticFileHandlerTests, PrecompressedSidecar) {
+    SidecarIndex::GetInstance().clear();
+    CreateTestFile();
+    std::ofstream sidecar("test_file.txt.gz");
+    sidecar << "compressed";
+    sidecar.close();
+
+    // Without a TTL the removal of the copy below is noticed at once.
+    ASSERT_TRUE(ParseString("root ./; open_file_cache_ttl 0;"));
+    StaticFileHandler f_handler;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", out_config_));
+
+    std::unique_ptr<Request> gzip = Request::Parse(
+        "GET /static/test_file.txt HTTP/1.1\r\nAccept-Encoding: br;q=0, gzip\r\n\r\n");
+    ASSERT_TRUE(gzip);
+    Response gzip_resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*gzip, &gzip_resp));
+    EXPECT_EQ("compressed", gzip_resp.body());
+    EXPECT_EQ("gzip", gzip_resp.GetHeader("Content-Encoding"));
+    EXPECT_EQ("Accept-Encoding", gzip_resp.GetHeader("Vary"));
+    EXPECT_EQ("text/plain", gzip_resp.GetHeader("Content-Type"));
+    std::string etag = gzip_resp.GetHeader("ETag");
+    EXPECT_EQ("-gzip\"", etag.substr(etag.size() - 6));
+
+    std::unique_ptr<Request> identity = Request::Parse(
+        "GET /static/test_file.txt HTTP/1.1\r\nAccept-Encoding: br\r\n\r\n");
+    ASSERT_TRUE(identity);
+    Response identity_resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*identity, &identity_resp));
+    EXPECT_EQ("foo bar\n", identity_resp.body());
+    EXPECT_EQ("", identity_resp.GetHeader("Content-Encoding"));
+    EXPECT_EQ("Accept-Encoding", identity_resp.GetHeader("Vary"));
+    EXPECT_NE(etag, identity_resp.GetHeader("ETag"));
+
+    // A copy removed behind the index's back falls back to the file.
+    remove("test_file.txt.gz");
+    Response missing_resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*gzip, &missing_resp));
+    EXPECT_EQ("foo bar\n", missing_resp.body());
+    EXPECT_EQ("", missing_resp.GetHeader("Content-Encoding"));
+    remove("test_file.txt");
+}
+
+// Markdown is rendered once, when the handler starts, and then shared.
+TEST_F(StaticFileHandlerTests, CachedMarkdown) {
+    MarkdownCache::GetInstance().clear();
+    mkdir("markdown_root", 0755);
+    std::ofstream markdown_file("markdown_root/page.md");
+    markdown_file << "# Page" << std::endl;
+    markdown_file.close();
+
+    ASSERT_TRUE(ParseString("root markdown_root;"));
+    StaticFileHandler f_handler;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", out_config_));
+    EXPECT_EQ(1u, MarkdownCache::GetInstance().num_entries());
+
+    std::unique_ptr<Request> request = Request::Parse("GET /static/page.md HTTP/1.1\r\n\r\n");
+    ASSERT_TRUE(request);
+    Response first;
+    Response second;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*request, &first));
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*request, &second));
+    EXPECT_EQ("text/html", first.GetHeader("Content-Type"));
+    EXPECT_EQ(MarkdownCache::render("# Page\n"), first.body());
+    EXPECT_EQ(first.shared_body(), second.shared_body());
+
+    remove("markdown_root/page.md");
+    rmdir("markdown_root");
+}
+
+// The threshold must be a single number
+TEST_F(StaticFileHandlerTests, InvalidSendfileThreshold) {
+    StaticFileHandler f_handler;
+    ASSERT_TRUE(ParseString("root ./; sendfile_threshold big;"));
+    EXPECT_EQ(RequestHandler::Status::INVALID_CONFIG, f_handler.Init("/static", out_config_));
+
+    std::stringstream duplicate_config("root ./; sendfile_threshold 1; sendfile_threshold 2;");
+    NginxConfig duplicate_out_config;
+    ASSERT_TRUE(parser_.Parse(&duplicate_config, &duplicate_out_config));
+    StaticFileHandler other_handler;
+    EXPECT_EQ(RequestHandler::Status::INVALID_CONFIG, other_handler.Init("/static", duplicate_out_config));
+}
+
+TEST_F(StaticFileHandlerTests, InvalidOpenFileCache) {
+    for (const char* config : {"root ./; open_file_cache_ttl soon;",
+                               "root ./; open_file_cache_max -1;",
+                               "root ./; open_file_cache_max 1; open_file_cache_max 2;",
+                               "root ./; path_index_max many;",
+                               "root ./; path_index_max 1; path_index_max 2;",
+                               "root ./; open_file_cache_ttl 1234567890;",
+                               "root ./; sendfile_threshold 1234567890;"}) {
+        std::stringstream config_stream(config);
+        NginxConfig out_config;
+        ASSERT_TRUE(parser_.Parse(&config_stream, &out_config));
+        StaticFileHandler f_handler;
+        EXPECT_EQ(RequestHandler::Status::INVALID_CONFIG, f_handler.Init("/static", out_config)) << config;
+    }
+}
+
+// Files are opened below the root only.
+TEST_F(StaticFileHandlerTests, ParentDirectory) {
+    CreateTestFile();
+    mkdir("parent_root", 0755);
+
+    ASSERT_TRUE(ParseString("root parent_root;"));
+    StaticFileHandler f_handler;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", out_config_));
+
+    std::unique_ptr<Request> request = Request::Parse("GET /static/../test_file.txt HTTP/1.1\r\n\r\n");
+    ASSERT_TRUE(request);
+    Response response;
+    EXPECT_EQ(RequestHandler::Status::FILE_NOT_FOUND, f_handler.HandleRequest(*request, &response));
+
+    rmdir("parent_root");
+    remove("test_file.txt");
+}
+
+// Files the index knows are missing are turned away; new ones are found.
+TEST_F(StaticFileHandlerTests, PathIndex) {
+    mkdir("indexed_root", 0755);
+    ASSERT_TRUE(ParseString("root indexed_root;"));
+    StaticFileHandler f_handler;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", out_config_));
+
+    std::unique_ptr<Request> request = Request::Parse("GET /static/new.txt HTTP/1.1\r\n\r\n");
+    ASSERT_TRUE(request);
+    Response missing;
+    EXPECT_EQ(RequestHandler::Status::FILE_NOT_FOUND, f_handler.HandleRequest(*request, &missing));
+
+    std::ofstream file("indexed_root/new.txt");
+    file << "new";
+    file.close();
+    Response found;
+    EXPECT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*request, &found));
+    EXPECT_EQ("new", found.body());
+
+    remove("indexed_root/new.txt");
+    rmdir("indexed_root");
+}
+
+// A packed archive is served from memory, with its copies, validators and
+// ranges.
+TEST_F(StaticFileHandlerTests, Archive) {
+    std::vector<StaticArchive::File> files(1);
+    files[0].path = "docs/page.txt";
+    files[0].content_type = "text/plain";
+    files[0].etag = "\"abc-6\"";
+    files[0].last_modified = 784111777;
+    files[0].body = "packed";
+    files[0].encoded[SidecarIndex::GZIP] = "gzipped";
+    ASSERT_TRUE(StaticArchive::Write("handler_test.pack", files));
+
+    ASSERT_TRUE(ParseString("archive handler_test.pack;"));
+    StaticFileHandler f_handler;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/static", out_config_));
+    remove("handler_test.pack");
+
+    std::unique_ptr<Request> request = Request::Parse("GET /static/docs/page.txt HTTP/1.1\r\n\r\n");
+    ASSERT_TRUE(request);
+    Response response;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*request, &response));
+    EXPECT_EQ(Response::ResponseCode::OK, response.status_code());
+    EXPECT_EQ("packed", response.body());
+    EXPECT_EQ("text/plain", response.GetHeader("Content-Type"));
+    EXPECT_EQ("\"abc-6\"", response.GetHeader("ETag"));
+    EXPECT_EQ("Sun, 06 Nov 1994 08:49:37 GMT", response.GetHeader("Last-Modified"));
+    EXPECT_EQ("Accept-Encoding", response.GetHeader("Vary"));
+
+    std::unique_ptr<Request> gzip = Request::Parse(
+        "GET /static/docs/page.txt HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+    ASSERT_TRUE(gzip);
+    Response gzip_resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*gzip, &gzip_resp));
+    EXPECT_EQ("gzipped", gzip_resp.body());
+    EXPECT_EQ("gzip", gzip_resp.GetHeader("Content-Encoding"));
+    EXPECT_EQ("\"abc-6-gzip\"", gzip_resp.GetHeader("ETag"));
+
+    std::unique_ptr<Request> range = Request::Parse(
+        "GET /static/docs/page.txt HTTP/1.1\r\nRange: bytes=2-3\r\n\r\n");
+    ASSERT_TRUE(range);
+    Response range_resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*range, &range_resp));
+    EXPECT_EQ(Response::ResponseCode::PARTIAL_CONTENT, range_resp.status_code());
+    EXPECT_EQ("ck", range_resp.body());
+
+    std::unique_ptr<Request> cached = Request::Parse(
+        "GET /static/docs/page.txt HTTP/1.1\r\nIf-None-Match: \"abc-6\"\r\n\r\n");
+    ASSERT_TRUE(cached);
+    Response cached_resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(*cached, &cached_resp));
+    EXPECT_EQ(Response::ResponseCode::NOT_MODIFIED, cached_resp.status_code());
+
+    std::unique_ptr<Request> missing = Request::Parse("GET /static/docs/other.txt HTTP/1.1\r\n\r\n");
+    ASSERT_TRUE(missing);
+    Response missing_resp;
+    EXPECT_EQ(RequestHandler::Status::FILE_NOT_FOUND, f_handler.HandleRequest(*missing, &missing_resp));
+}
+
+// A private archive redirects to the login page packed with it.
+TEST_F(StaticFileHandlerTests, PrivateArchive) {
+    std::vector<StaticArchive::File> files(1);
+    files[0].path = "login.html";
+    files[0].content_type = "text/html";
+    files[0].etag = "\"login\"";
+    files[0].body = "<form>packed login</form>";
+    ASSERT_TRUE(StaticArchive::Write("private_test.pack", files));
+
+    ASSERT_TRUE(ParseString("archive private_test.pack; user root password; timeout 10;"));
+    StaticFileHandler f_handler;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.Init("/private", out_config_));
+    remove("private_test.pack");
+
+    EXPECT_CALL(processed_request, uri()).Times(1).WillOnce(Return("/private/test_file.txt"));
+    EXPECT_CALL(processed_request, cookie()).Times(1).WillOnce(Return(""));
+    Response resp;
+    ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(processed_request, &resp));
+    EXPECT_EQ(Response::ResponseCode::FOUND, resp.status_code());
+    EXPECT_EQ("/private/login.html", resp.GetHeader("Location"));
+    EXPECT_EQ("<form>packed login</form>", resp.body());
+}
+
+TEST_F(StaticFileHandlerTests, InvalidArchive) {
+    for (const char* config : {"archive missing.pack;", "root ./; archive missing.pack;"}) {
+        std::stringstream config_stream(config);
+        NginxConfig out_config;
+        ASSERT_TRUE(parser_.Parse(&config_stream, &out_config));
+        StaticFileHandler f_handler;
+        EXPECT_EQ(RequestHandler::Status::INVALID_CONFIG, f_handler.Init("/static", out_config)) << config;
+    }
+}
+
 // Check that each cookie is unique
 TEST(StaticFileHandlerHelperTests, GenerateCookieTest) {
     StaticFileHandler f_handler;
@@ -356,7 +777,7 @@ TEST_F(StaticFileHandlerTests, HandleLogin) {
     // Handle the second mock request
     Response new_resp;
     ASSERT_EQ(RequestHandler::Status::OK, f_handler.HandleRequest(new_request, &new_resp));
-    EXPECT_EQ("HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 8\r\n\r\nfoo bar\n", new_resp.ToString());
+    EXPECT_EQ("HTTP/1.0 200 OK\r\n" + Validators(new_resp) + "Content-Type: text/plain\r\nAccept-Ranges: bytes\r\nContent-Length: 8\r\n\r\nfoo bar\n", new_resp.ToString());
     remove("login.html");
     remove("test_file.txt");
 }
@@ -18,7 +18,7 @@ TEST(StatusHandlerTest, Output) {
     std::string expected_contents =
         std::string("HTTP/1.0 200 OK\r\n") +
         "Content-Type: text/html\r\n" +
-        "Content-Length: 425\r\n\r\n" +
+        "Content-Length: 698\r\n\r\n" +
         "<!DOCTYPE html><html>" +
         "<head>" +
         "<style>table {border-collapse: collapse;}th, td {padding: 8px;text-align: left; border-bottom: 1px solid #ddd;}</style>" +
@@ -28,7 +28,7 @@ TEST(StatusHandlerTest, Output) {
         "<h2>Requests</h2>" +
         "<p>Total Requests: 2</p>" +
         "<table>" +
-        "<th><td>Request URL</td><td>Response Code</td></th>" +
+        "<tr><th>Request URL</th><th>Response Code</th></tr>" +
         "<tr>" +
         "<td>/echo</td>" +
         "<td>200</td>" +
@@ -40,7 +40,7 @@ TEST(StatusHandlerTest, Output) {
         "</table>" +
         "<h2>Request Handlers</h2>" +
         "<table>" +
-        "<th><td>URL Prefix</td><td>Response Handler</td></th>" +
+        "<tr><th>URL Prefix</th><th>Response Handler</th></tr>" +
         "<tr>" +
         "<td>/echo</td>" +
         "<td>EchoHandler</td>" +
@@ -48,13 +48,26 @@ TEST(StatusHandlerTest, Output) {
         "<tr>" +
         "<td>/static</td>" +
         "<td>StaticFileHandler</td>" +
-        "</tr>" + 
+        "</tr>" +
+        "</table>" +
+        "<h2>File Cache</h2>" +
+        "<table>" +
+        "<tr><th>Hits</th><th>Misses</th><th>Evictions</th></tr>" +
+        "<tr>" +
+        "<td>3</td>" +
+        "<td>1</td>" +
+        "<td>0</td>" +
+        "</tr>" +
         "</table></body></html>";
 
     ServerStatusTracker::GetInstance().RecordHandlerMapping("/echo", "EchoHandler");
     ServerStatusTracker::GetInstance().RecordHandlerMapping("/static", "StaticFileHandler");
     ServerStatusTracker::GetInstance().RecordRequest("/echo", Response::ResponseCode::OK);
     ServerStatusTracker::GetInstance().RecordRequest("/static/file.txt", Response::ResponseCode::NOT_FOUND);
+    for (int i = 0; i < 3; i++) {
+        ServerStatusTracker::GetInstance().RecordFileCacheHit();
+    }
+    ServerStatusTracker::GetInstance().RecordFileCacheMiss();
 
     ASSERT_EQ(RequestHandler::Status::OK, s_handler.HandleRequest(req, &resp));
     EXPECT_EQ(expected_contents, resp.ToString());
@@ -0,0 +1,48 @@
+#include "directory_walker.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+bool walk(const std::string& root, const std::string& relative, int depth,
+          const std::function<bool(const std::string&)>& visit) {
+    std::string directory = relative.empty() ? root : root + "/" + relative;
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        std::cerr << "Error: Can't open directory " << directory << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> names;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+
+    for (auto& name : names) {
+        std::string child = relative.empty() ? name : relative + "/" + name;
+        struct stat st;
+        if (stat((directory + "/" + name).c_str(), &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            if (depth > 0 && !walk(root, child, depth - 1, visit)) {
+                return false;
+            }
+        } else if (S_ISREG(st.st_mode) && !visit(child)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+bool walk_directory(const std::string& root, int max_depth,
+                    const std::function<bool(const std::string& relative)>& visit) {
+    return walk(root, "", max_depth, visit);
+}
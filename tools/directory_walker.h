@@ -0,0 +1,20 @@
+#ifndef DIRECTORY_WALKER_H
+#define DIRECTORY_WALKER_H
+
+#include <functional>
+#include <string>
+
+// Walks the regular files below a root directory for the tools that process
+// a whole static root. Hidden entries are skipped, and so are directories
+// more than max_depth levels below the root.
+//
+// Usage:
+//   walk_directory(root, 16, [&](const std::string& relative) { ...; return true; });
+//
+// visit gets each file's path relative to the root. Returns false, after an
+// error message, if a directory can't be opened, or as soon as visit returns
+// false.
+bool walk_directory(const std::string& root, int max_depth,
+                    const std::function<bool(const std::string& relative)>& visit);
+
+#endif  // DIRECTORY_WALKER_H
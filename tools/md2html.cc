@@ -0,0 +1,122 @@
+// Renders every markdown file under a directory to an HTML page, as the
+// server would serve it, so docs can be rendered once at deploy time.
+//
+// Usage: md2html [-j <jobs>] <root> [<output>]
+//
+// Each <root>/path/name.md becomes <output>/path/name.html, with <output>
+// defaulting to <root>. Files are rendered in parallel on <jobs> threads,
+// one per core by default. Hidden entries are skipped.
+#include "directory_walker.h"
+#include "file_cache.h"
+#include "markdown_cache.h"
+#include <errno.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Directory levels rendered below the root.
+const int MAX_RENDER_DEPTH = 16;
+
+bool has_md_extension(const std::string& name) {
+    return name.size() > 3 && name.compare(name.size() - 3, 3, ".md") == 0;
+}
+
+// Creates the directories leading to path, like mkdir -p.
+bool make_parents(const std::string& path) {
+    for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+        if (mkdir(path.substr(0, slash).c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Writes the page through a temporary file, so a server reading the output
+// never sees half of it.
+bool write_page(const std::string& path, const std::string& page) {
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(page.data(), page.size());
+    out.close();
+    if (!out || rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    // hardware_concurrency() is 0 when the core count can't be found.
+    unsigned jobs = std::max(std::thread::hardware_concurrency(), 1u);
+    int arg = 1;
+    if (arg + 1 < argc && std::string(argv[arg]) == "-j") {
+        jobs = std::atoi(argv[arg + 1]);
+        arg += 2;
+    }
+    if (argc - arg < 1 || argc - arg > 2 || jobs == 0) {
+        std::cerr << "Usage: " << argv[0] << " [-j <jobs>] <root> [<output>]" << std::endl;
+        return 1;
+    }
+
+    std::string root = argv[arg];
+    std::string output = argc - arg == 2 ? argv[arg + 1] : root;
+    for (std::string* directory : {&root, &output}) {
+        while (directory->size() > 1 && directory->back() == '/') {
+            directory->pop_back();
+        }
+    }
+
+    std::vector<std::string> paths;
+    auto add_markdown = [&](const std::string& relative) {
+        if (has_md_extension(relative)) {
+            paths.push_back(relative);
+        }
+        return true;
+    };
+    if (!walk_directory(root, MAX_RENDER_DEPTH, add_markdown)) {
+        return 1;
+    }
+
+    // Each thread takes the next unrendered file until none are left.
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> failures(0);
+    std::mutex error_mutex;
+    auto render_files = [&]() {
+        for (size_t i = next++; i < paths.size(); i = next++) {
+            std::string source = root + "/" + paths[i];
+            std::string target = output + "/" + paths[i].substr(0, paths[i].size() - 3) + ".html";
+            struct stat st;
+            FileCache::Contents markdown = FileCache::read(source, &st);
+            if (!markdown || !make_parents(target) || !write_page(target, MarkdownCache::render(*markdown))) {
+                failures++;
+                std::lock_guard<std::mutex> lock(error_mutex);
+                std::cerr << "Error: Can't render " << source << " to " << target << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < jobs && i < paths.size(); i++) {
+        threads.emplace_back(render_files);
+    }
+    render_files();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::cout << "Rendered " << paths.size() - failures << " of " << paths.size() << " markdown files from " << root
+              << " into " << output << std::endl;
+    return failures == 0 ? 0 : 1;
+}
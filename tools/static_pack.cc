@@ -0,0 +1,111 @@
+// Packs a static root into an archive that StaticFileHandler can serve with
+// "archive <file>;" instead of "root <directory>;".
+//
+// Usage: static_pack <root> <archive>
+//
+// Markdown is rendered to HTML as the handler would. Precompressed copies
+// next to a file ("foo.css.gz", "foo.css.br") are packed with it; text files
+// without a gzip copy get one if it is smaller. Hidden entries are skipped.
+#include "directory_walker.h"
+#include "markdown_cache.h"
+#include "response_compressor.h"
+#include "static_archive.h"
+#include "static_file_handler.h"
+#include <sys/stat.h>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Directory levels packed below the root.
+const int MAX_PACK_DEPTH = 16;
+
+// A strong validator that only changes with the contents, so it survives
+// repacking and redeploying unchanged files.
+std::string content_etag(const std::string& body) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : body) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "\"%llx-%llx\"", static_cast<unsigned long long>(hash),
+             static_cast<unsigned long long>(body.size()));
+    return buffer;
+}
+
+bool pack_file(const std::string& root, const std::string& relative, std::vector<StaticArchive::File>* files) {
+    std::string path = root + "/" + relative;
+    struct stat read_st;
+    FileCache::Contents contents = FileCache::read(path, &read_st);
+    if (!contents) {
+        std::cerr << "Error: Can't read " << path << std::endl;
+        return false;
+    }
+
+    StaticArchive::File file;
+    file.path = relative;
+    file.last_modified = read_st.st_mtime;
+    file.content_type = StaticFileHandler().get_content_type(relative);
+    if (file.content_type == TYPE_MD) {
+        file.content_type = TYPE_HTML;
+        file.body = MarkdownCache::render(*contents);
+    } else {
+        file.body = *contents;
+
+        // Copies as old as the file itself, as SidecarIndex would use them.
+        for (int i = 0; i < SidecarIndex::NUM_ENCODINGS; i++) {
+            SidecarIndex::Encoding encoding = static_cast<SidecarIndex::Encoding>(i);
+            struct stat sidecar_st;
+            FileCache::Contents sidecar = FileCache::read(path + SidecarIndex::extension(encoding), &sidecar_st);
+            if (sidecar && (sidecar_st.st_mtim.tv_sec > read_st.st_mtim.tv_sec ||
+                            (sidecar_st.st_mtim.tv_sec == read_st.st_mtim.tv_sec &&
+                             sidecar_st.st_mtim.tv_nsec >= read_st.st_mtim.tv_nsec))) {
+                file.encoded[encoding] = *sidecar;
+            }
+        }
+    }
+
+    std::string& gzip = file.encoded[SidecarIndex::GZIP];
+    if (gzip.empty() && file.body.size() >= DEFAULT_GZIP_MIN_LENGTH &&
+        ResponseCompressor::compressible(file.content_type)) {
+        gzip = ResponseCompressor::gzip(file.body, 9);
+        if (gzip.size() >= file.body.size()) {
+            gzip.clear();
+        }
+    }
+
+    file.etag = content_etag(file.body);
+    files->push_back(std::move(file));
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <root> <archive>" << std::endl;
+        return 1;
+    }
+
+    std::string root = argv[1];
+    while (root.size() > 1 && root.back() == '/') {
+        root.pop_back();
+    }
+
+    std::vector<StaticArchive::File> files;
+    if (!walk_directory(root, MAX_PACK_DEPTH,
+                        [&](const std::string& relative) { return pack_file(root, relative, &files); })) {
+        return 1;
+    }
+
+    size_t num_files = files.size();
+    if (!StaticArchive::Write(argv[2], std::move(files))) {
+        std::cerr << "Error: Can't write " << argv[2] << std::endl;
+        return 1;
+    }
+    std::cout << "Packed " << num_files << " files from " << root << " into " << argv[2] << std::endl;
+    return 0;
+}